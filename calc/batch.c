@@ -0,0 +1,560 @@
+/**
+ * @file  calc/batch.c
+ * @brief 一括処理
+ *
+ * 入力を大きな単位で読み込み, 行に分割してワーカスレッドで計算する.\n
+ * 通常ファイルは一定サイズの窓ごとに mmap し, 行をコピーせずに計算する.\n
+ * 行は位置と長さで渡すため, 入力バッファには書き込まない.\n
+ * 結果は入力順に, バッファリングして出力する.\n
+ * 出力の N 行目は入力の N 行目に対応し, 空行には空行を出力する.
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2010-2011 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#define _GNU_SOURCE   /* memrchr */
+#include <stdio.h>    /* FILE fread fwrite */
+#include <stdlib.h>   /* malloc realloc */
+#include <string.h>   /* memchr memcpy memmove memset */
+#include <stdbool.h>  /* bool */
+#include <unistd.h>   /* sysconf */
+#include <pthread.h>  /* pthread_create pthread_join */
+#include <sys/stat.h> /* fstat */
+#include <sys/mman.h> /* mmap munmap madvise */
+
+#include "def.h"
+#include "log.h"
+#include "timer.h"
+#include "memfree.h"
+#include "calc.h"
+#include "interval.h"
+#include "option.h"
+#include "batch.h"
+
+#define CHUNK_SIZE  (1024 * 1024)      /**< 読込単位 */
+#define OUTBUF_SIZE (256 * 1024)       /**< 出力バッファサイズ */
+#define MIN_LINES   256                /**< スレッドあたりの最小行数 */
+#define MAP_WINDOW  (64 * 1024 * 1024) /**< mmap 窓サイズ */
+
+/** ワーカスレッド情報構造体 */
+struct worker {
+    pthread_t tid;              /**< スレッドID */
+    bool running;               /**< スレッド起動済み */
+    const unsigned char **expr; /**< 式の配列 */
+    const size_t *len;          /**< 式の長さの配列 */
+    size_t count;               /**< 式の数 */
+    unsigned char *out;         /**< 出力バッファ */
+    size_t outsize;             /**< 出力バッファサイズ */
+    calcresult *result;         /**< 結果の配列 */
+    ssize_t done;               /**< 計算した式の数 */
+};
+
+/** 一括処理情報構造体 */
+struct batchinfo {
+    const unsigned char **expr;     /**< 式の配列 */
+    size_t *len;                    /**< 式の長さの配列 */
+    calcresult *result;             /**< 結果の配列 */
+    size_t nline;                   /**< 確保済みの行数 */
+    unsigned char *out;             /**< 出力バッファ */
+    size_t outsize;                 /**< 出力バッファサイズ */
+    size_t anssize;                 /**< 一行あたりの出力バッファサイズ */
+    struct worker worker[MAX_JOBS]; /**< ワーカスレッド */
+    long jobs;                      /**< ワーカスレッド数 */
+};
+
+/* 内部関数 */
+/** 入力ループ */
+static int batch_loop(FILE *fp, struct batchinfo *bi,
+                      const volatile sig_atomic_t *stop);
+/** mmap 入力ループ */
+static int batch_mmap(const int fd, const off_t size, struct batchinfo *bi,
+                      const volatile sig_atomic_t *stop);
+/** 窓の分割 */
+static int batch_window(struct batchinfo *bi, const unsigned char *buf,
+                        const size_t length,
+                        const volatile sig_atomic_t *stop);
+/** 読込単位の計算と出力 */
+static int batch_chunk(struct batchinfo *bi, const unsigned char *buf,
+                       const size_t length);
+/** 領域確保 */
+static int batch_reserve(struct batchinfo *bi, const size_t nline);
+/** ワーカスレッド */
+static void *batch_worker(void *arg);
+/** 結果出力 */
+static int batch_output(const struct worker *w);
+
+/**
+ * 一括処理
+ *
+ * @param[in] file 入力ファイル(NULLまたは"-"の場合, 標準入力)
+ * @param[in] stop 中断フラグ
+ * @retval EX_NG エラー
+ */
+int
+batch_main(const char *file, const volatile sig_atomic_t *stop)
+{
+    FILE *fp = stdin;       /* ファイルポインタ */
+    struct stat st;         /* ファイル情報 */
+    struct batchinfo bi;    /* 一括処理情報 */
+    int retval = 0;         /* 戻り値 */
+    unsigned int start = 0; /* タイマ開始 */
+
+    dbglog("start: file=%s, jobs=%ld", file, g_jobs);
+
+    if (setvbuf(stdout, (char *)NULL, _IOFBF, OUTBUF_SIZE))
+        outlog("setvbuf: stdout");
+
+    if (file && strcmp(file, "-")) {
+        fp = fopen(file, "r");
+        if (!fp) {
+            outlog("fopen: %s", file);
+            (void)fprintf(stderr, "Cannot open %s\n", file);
+            return EX_NG;
+        }
+    }
+
+    (void)memset(&bi, 0, sizeof(struct batchinfo));
+    bi.jobs = g_jobs;
+    bi.anssize = MAX_ANSWER;
+    if (g_mflag && MAX_ANSWER < MAX_MPANSWER(g_digit)) /* 多倍長計算 */
+        bi.anssize = MAX_MPANSWER(g_digit);
+    if (g_iflag) /* 区間演算 */
+        bi.anssize = MAX_IANSWER;
+    if (bi.jobs <= 0) /* 未指定 */
+        bi.jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    if (bi.jobs <= 0)
+        bi.jobs = 1;
+    else if (MAX_JOBS < bi.jobs)
+        bi.jobs = MAX_JOBS;
+
+    if (g_tflag)
+        start_timer(&start);
+
+    if (fp != stdin && !fstat(fileno(fp), &st) &&
+        S_ISREG(st.st_mode) && 0 < st.st_size)
+        retval = batch_mmap(fileno(fp), st.st_size, &bi, stop);
+    else
+        retval = batch_loop(fp, &bi, stop);
+
+    if (fflush(stdout) == EOF) {
+        outlog("fflush");
+        retval = EX_NG;
+    }
+
+    if (g_tflag) {
+        unsigned int calc_time = stop_timer(&start);
+        print_timer(calc_time);
+    }
+
+    if (fp != stdin) {
+        if (fclose(fp) == EOF)
+            outlog("fclose: %s", file);
+    }
+    memfree((void **)&bi.expr, (void **)&bi.len, (void **)&bi.result,
+            (void **)&bi.out, NULL);
+    return retval;
+}
+
+/**
+ * 入力ループ
+ *
+ * 読込単位の最後の改行までを計算し, 残りは次の読込に持ち越す.\n
+ * 読込単位に改行がない場合は, バッファを拡張する.
+ *
+ * @param[in] fp ファイルポインタ
+ * @param[in,out] bi 一括処理情報
+ * @param[in] stop 中断フラグ
+ * @retval EX_NG エラー
+ */
+static int
+batch_loop(FILE *fp, struct batchinfo *bi, const volatile sig_atomic_t *stop)
+{
+    unsigned char *buf = NULL;  /* 入力バッファ */
+    unsigned char *tmp = NULL;  /* 一時ポインタ */
+    unsigned char *end = NULL;  /* 最後の改行 */
+    size_t size = CHUNK_SIZE;   /* バッファサイズ */
+    size_t length = 0;          /* 読込済みバイト数 */
+    size_t nread = 0;           /* 読込バイト数 */
+    size_t used = 0;            /* 計算したバイト数 */
+    bool eof = false;           /* 入力終了 */
+    int retval = EX_OK;         /* 戻り値 */
+
+    buf = (unsigned char *)malloc(size);
+    if (!buf) {
+        outlog("malloc: size=%zu", size);
+        return EX_NG;
+    }
+
+    while (!eof && !*stop) {
+        if (length == size) { /* 改行がない */
+            tmp = (unsigned char *)realloc(buf, size * 2);
+            if (!tmp) {
+                outlog("realloc: size=%zu", size * 2);
+                retval = EX_NG;
+                break;
+            }
+            buf = tmp;
+            size *= 2;
+        }
+
+        nread = fread(buf + length, sizeof(unsigned char),
+                      size - length, fp);
+        if (nread < size - length) {
+            if (ferror(fp)) {
+                outlog("fread: fp=%p", fp);
+                retval = EX_NG;
+                break;
+            }
+            eof = true;
+        }
+        length += nread;
+
+        if (eof) {
+            used = length;
+        } else {
+            end = (unsigned char *)memrchr(buf, '\n', length);
+            if (!end)
+                continue;
+            used = (size_t)(end - buf) + 1;
+        }
+
+        retval = batch_chunk(bi, buf, used);
+        if (retval < 0)
+            break;
+
+        length -= used;
+        (void)memmove(buf, buf + used, length);
+    }
+
+    memfree((void **)&buf, NULL);
+    return retval;
+}
+
+/**
+ * mmap 入力ループ
+ *
+ * ファイルを窓ごとに mmap し, 窓の最後の改行までを計算する.\n
+ * 次の窓は残りの先頭を含むページから始める. 窓に改行がない場合は,
+ * 窓を拡張する.
+ *
+ * @param[in] fd ファイルディスクリプタ
+ * @param[in] size ファイルサイズ
+ * @param[in,out] bi 一括処理情報
+ * @param[in] stop 中断フラグ
+ * @retval EX_NG エラー
+ */
+static int
+batch_mmap(const int fd, const off_t size, struct batchinfo *bi,
+           const volatile sig_atomic_t *stop)
+{
+    unsigned char *addr = NULL; /* 割り当てアドレス */
+    unsigned char *buf = NULL;  /* 未処理の先頭 */
+    unsigned char *end = NULL;  /* 最後の改行 */
+    off_t offset = 0;           /* 未処理の先頭位置 */
+    off_t base = 0;             /* 窓の先頭位置 */
+    size_t window = MAP_WINDOW; /* 窓サイズ */
+    size_t maplen = 0;          /* 割り当てサイズ */
+    size_t length = 0;          /* 未処理バイト数 */
+    size_t used = 0;            /* 計算したバイト数 */
+    long pagesize = 0;          /* ページサイズ */
+    bool last = false;          /* 最後の窓 */
+    int retval = EX_OK;         /* 戻り値 */
+
+    pagesize = sysconf(_SC_PAGESIZE);
+    if (pagesize <= 0)
+        pagesize = 4096;
+
+    while (offset < size && !*stop && retval == EX_OK) {
+        base = offset & ~((off_t)pagesize - 1);
+        maplen = window;
+        last = (size - base <= (off_t)maplen);
+        if (last)
+            maplen = (size_t)(size - base);
+
+        addr = (unsigned char *)mmap(NULL, maplen, PROT_READ,
+                                     MAP_PRIVATE, fd, base);
+        if (addr == MAP_FAILED) {
+            outlog("mmap: offset=%lld, length=%zu", (long long)base, maplen);
+            return EX_NG;
+        }
+        (void)madvise(addr, maplen, MADV_SEQUENTIAL);
+
+        buf = addr + (offset - base);
+        length = maplen - (size_t)(offset - base);
+
+        if (last) {
+            used = length;
+        } else {
+            end = (unsigned char *)memrchr(buf, '\n', length);
+            if (!end) { /* 改行がない */
+                window *= 2;
+                (void)munmap(addr, maplen);
+                continue;
+            }
+            used = (size_t)(end - buf) + 1;
+        }
+
+        retval = batch_window(bi, buf, used, stop);
+
+        if (munmap(addr, maplen) < 0)
+            outlog("munmap: length=%zu", maplen);
+        offset += (off_t)(last ? length : used);
+    }
+    return retval;
+}
+
+/**
+ * 窓の分割
+ *
+ * 出力バッファが大きくなりすぎないよう, 行の境界で読込単位に分割する.
+ *
+ * @param[in,out] bi 一括処理情報
+ * @param[in] buf 入力
+ * @param[in] length バイト数
+ * @param[in] stop 中断フラグ
+ * @retval EX_NG エラー
+ */
+static int
+batch_window(struct batchinfo *bi, const unsigned char *buf,
+             const size_t length, const volatile sig_atomic_t *stop)
+{
+    const unsigned char *last = buf + length; /* 終端 */
+    const unsigned char *end = NULL;          /* 分割位置 */
+    size_t piece = 0;                         /* 分割サイズ */
+    int retval = EX_OK;                       /* 戻り値 */
+
+    while (buf < last && !*stop && retval == EX_OK) {
+        piece = (size_t)(last - buf);
+        if (CHUNK_SIZE < piece) {
+            end = (const unsigned char *)memchr(buf + CHUNK_SIZE - 1, '\n',
+                                                piece - CHUNK_SIZE + 1);
+            if (end)
+                piece = (size_t)(end - buf) + 1;
+        }
+        retval = batch_chunk(bi, buf, piece);
+        buf += piece;
+    }
+    return retval;
+}
+
+/**
+ * 読込単位の計算と出力
+ *
+ * 行に分割し, 連続した範囲ごとにワーカスレッドへ割り当てる.\n
+ * 全ての行を計算できなかった場合はエラーとする.
+ *
+ * @param[in,out] bi 一括処理情報
+ * @param[in] buf 入力バッファ(終端文字は不要)
+ * @param[in] length バイト数
+ * @retval EX_NG エラー
+ */
+static int
+batch_chunk(struct batchinfo *bi, const unsigned char *buf,
+            const size_t length)
+{
+    const unsigned char *p = buf;             /* 行の先頭 */
+    const unsigned char *q = NULL;            /* 行の末尾 */
+    const unsigned char *last = buf + length; /* 終端 */
+    size_t len = 0;                           /* 行の長さ */
+    size_t count = 0;                         /* 行数 */
+    size_t start = 0;                         /* 割り当て開始行 */
+    size_t per = 0;                           /* スレッドあたりの行数 */
+    long jobs = 0;                            /* スレッド数 */
+    struct worker *w = NULL;                  /* ワーカスレッド */
+    int retval = EX_OK;                       /* 戻り値 */
+
+    while (p < last) {
+        q = (const unsigned char *)memchr(p, '\n', (size_t)(last - p));
+        if (!q)
+            q = last;
+        len = (size_t)(q - p);
+        if (len && p[len - 1] == '\r')
+            len--;
+        if (bi->nline <= count) {
+            if (batch_reserve(bi, count + 1) < 0)
+                return EX_NG;
+        }
+        bi->expr[count] = p;
+        bi->len[count++] = len;
+        p = q + 1;
+    }
+    dbglog("count=%zu", count);
+    if (!count)
+        return EX_OK;
+
+    jobs = (long)(count / MIN_LINES) + 1;
+    if (bi->jobs < jobs)
+        jobs = bi->jobs;
+    per = (count + jobs - 1) / jobs;
+
+    int i;
+    for (i = 0; i < jobs && start < count; i++) {
+        w = &bi->worker[i];
+        (void)memset(w, 0, sizeof(struct worker));
+        w->expr = bi->expr + start;
+        w->len = bi->len + start;
+        w->count = (count - start < per) ? count - start : per;
+        w->result = bi->result + start;
+        w->out = bi->out + start * bi->anssize;
+        w->outsize = w->count * bi->anssize;
+        start += w->count;
+
+        if (i == 0) /* 先頭は自スレッドで計算する */
+            continue;
+        if (pthread_create(&w->tid, NULL, batch_worker, w)) {
+            outlog("pthread_create");
+            (void)batch_worker(w);
+        } else {
+            w->running = true;
+        }
+    }
+    jobs = i;
+    (void)batch_worker(&bi->worker[0]);
+
+    for (i = 0; i < jobs; i++) {
+        w = &bi->worker[i];
+        if (w->running && pthread_join(w->tid, NULL))
+            outlog("pthread_join");
+        if (w->done < 0) { /* メモリ不足 */
+            retval = EX_NG;
+        } else if ((size_t)w->done < w->count) { /* 出力バッファ不足 */
+            outlog("calc_eval_batch: done=%zd, count=%zu", w->done, w->count);
+            retval = EX_NG;
+        }
+    }
+
+    for (i = 0; i < jobs && retval == EX_OK; i++)
+        retval = batch_output(&bi->worker[i]);
+
+    return retval;
+}
+
+/**
+ * 領域確保
+ *
+ * 行数に応じて式, 式の長さ, 結果の配列と出力バッファを拡張する.
+ *
+ * @param[in,out] bi 一括処理情報
+ * @param[in] nline 必要な行数
+ * @retval EX_NG メモリ不足
+ */
+static int
+batch_reserve(struct batchinfo *bi, const size_t nline)
+{
+    size_t n = bi->nline ? bi->nline : MIN_LINES; /* 確保する行数 */
+    void *tmp = NULL;                            /* 一時ポインタ */
+
+    while (n < nline)
+        n *= 2;
+
+    tmp = realloc(bi->expr, n * sizeof(*bi->expr));
+    if (!tmp)
+        goto error_handler;
+    bi->expr = (const unsigned char **)tmp;
+
+    tmp = realloc(bi->len, n * sizeof(*bi->len));
+    if (!tmp)
+        goto error_handler;
+    bi->len = (size_t *)tmp;
+
+    tmp = realloc(bi->result, n * sizeof(*bi->result));
+    if (!tmp)
+        goto error_handler;
+    bi->result = (calcresult *)tmp;
+
+    tmp = realloc(bi->out, n * bi->anssize);
+    if (!tmp)
+        goto error_handler;
+    bi->out = (unsigned char *)tmp;
+    bi->outsize = n * bi->anssize;
+
+    bi->nline = n;
+    return EX_OK;
+
+error_handler:
+    outlog("realloc: nline=%zu", n);
+    return EX_NG;
+}
+
+/**
+ * ワーカスレッド
+ *
+ * @param[in,out] arg ワーカスレッド情報
+ * @return 常にNULL
+ */
+static void *
+batch_worker(void *arg)
+{
+    struct worker *w = (struct worker *)arg; /* ワーカスレッド */
+    calcinfo calc;                           /* calcinfo構造体 */
+
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    calc.digit = g_digit;
+    calc.mpflag = g_mflag;
+    calc.fflag = g_fflag;
+    calc.iflag = g_iflag;
+
+    w->done = calc_eval_batch(&calc, w->expr, w->len, w->count,
+                              w->out, w->outsize, w->result);
+    dbglog("done=%zd", w->done);
+    return NULL;
+}
+
+/**
+ * 結果出力
+ *
+ * 結果文字列の終端文字を改行に置き換え, まとめて出力する.\n
+ * 空行の結果は出力せず, 改行だけを出力する.
+ *
+ * @param[in] w ワーカスレッド情報
+ * @retval EX_NG 出力エラー
+ */
+static int
+batch_output(const struct worker *w)
+{
+    const calcresult *r = NULL; /* 結果 */
+    size_t from = 0;            /* 未出力の先頭 */
+    size_t length = 0;          /* 出力バイト数 */
+
+    if (w->done <= 0)
+        return EX_OK;
+
+    ssize_t i;
+    for (i = 0; i < w->done; i++) {
+        r = &w->result[i];
+        w->out[r->offset + r->length] = '\n';
+        if (w->len[i]) /* 空行以外 */
+            continue;
+        length = r->offset - from;
+        if (fwrite(w->out + from, sizeof(unsigned char), length, stdout) <
+            length || putchar('\n') == EOF)
+            goto error_handler;
+        from = r->offset + r->length + 1;
+    }
+    length = r->offset + r->length + 1 - from;
+
+    if (fwrite(w->out + from, sizeof(unsigned char), length, stdout) < length)
+        goto error_handler;
+    return EX_OK;
+
+error_handler:
+    outlog("fwrite: length=%zu", length);
+    return EX_NG;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file  calc/batch.h
+ * @brief 一括処理
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2010-2011 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include <signal.h> /* sig_atomic_t */
+
+#define MAX_JOBS 256 /**< ワーカスレッド数最大値 */
+
+/** 一括処理 */
+int batch_main(const char *file, const volatile sig_atomic_t *stop);
+
+#endif /* _BATCH_H_ */
@@ -5,6 +5,7 @@
  * 式とは、項を + または - でつないだものであり、項とは因子を * または / で\n
  * つないだものであり、因子とは数または ( ) で囲んだ式である.\n
  * 再帰的下降構文解析を使用する.\n
+ * 構文解析の結果はノード配列にコンパイルされ, 評価時には文字列を走査しない.\n
  * 加減乗除 [+,-,*,/]、括弧 [(,)]、正負符号 [+,-]、べき乗[^]、\n
  * 関数 [abs,sqrt,sin,cos,tan,asin,acos,atan,exp,ln,log,deg,rad,n,nPr,nCr]、\n
  * 定数 [pi,e] が使用できる.
@@ -30,14 +31,15 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
  */
 
-#include <stdio.h>    /* fprintf snprintf FILE */
+#include <stdio.h>    /* snprintf */
+#include <math.h>     /* signbit isfinite isinf */
+#include <fenv.h>     /* fetestexcept */
 #include <string.h>   /* memcpy memset */
 #include <stdlib.h>   /* malloc */
+#include <stdint.h>   /* uint64_t uintptr_t */
 #include <ctype.h>    /* isdigit isalpha */
 #include <stdarg.h>   /* va_list va_arg */
-#ifdef _DEBUG
-#  include <limits.h> /* INT_MAX */
-#endif /* _DEBUG */
+#include <limits.h>   /* INT_MAX */
 
 #include "timer.h"
 #include "log.h"
@@ -45,75 +47,205 @@
 #include "func.h"
 #include "error.h"
 #include "calc.h"
-
-/* 外部変数 */
-bool g_tflag = false;               /**< tオプションフラグ */
+#include "mpcalc.h"
+#include "interval.h"
+#include "number.h"
+
+#define MAX_STACK 256 /**< スタック上に確保する値の数 */
+
+/** 構文解析の範囲 */
+enum parselevel {
+    PL_EXPR = 0, /**< 式 */
+    PL_TERM,     /**< 項 */
+    PL_FACTOR,   /**< 因子 */
+    PL_TOKEN     /**< 数または関数 */
+};
+
+/** 構文解析スタック要素種別 */
+enum parsekind {
+    PK_OP = 0, /**< 二項演算子 */
+    PK_PAREN,  /**< 括弧 */
+    PK_FUNC    /**< 関数の引数 */
+};
+
+/** 構文解析スタック要素 */
+struct parseitem {
+    const struct funcinfo *fp; /**< 関数情報(PK_FUNC) */
+    int args[MAX_FUNC_ARGS];   /**< 引数ノード(PK_FUNC) */
+    int node;                  /**< 左辺ノード(PK_OP), 引数の先頭(PK_FUNC) */
+    unsigned char kind;        /**< 種別 */
+    unsigned char op;          /**< 演算子文字(PK_OP) */
+    unsigned char argc;        /**< 解析済みの引数の数(PK_FUNC) */
+    bool neg;                  /**< 単項マイナス(PK_FUNC) */
+};
 
 /* 内部変数 */
 static const double EX_ERROR = 0.0; /**< エラー戻り値 */
-static long digit = DEFAULT_DIGIT;  /**< 桁数 */
+static const int INIT_NODES = 16;   /**< ノード配列初期サイズ */
+/** 10のべき乗(整数変換用) */
+static const double pow10_tab[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+    1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
 
 /* 内部関数 */
 /** バッファ読込 */
 static void readch(calcinfo *calc);
 /** 式 */
-static double expression(calcinfo *calc);
+static int expression(calcinfo *calc);
+#ifdef UNITTEST
 /** 項 */
-static double term(calcinfo *calc);
+static int term(calcinfo *calc);
 /** 因子 */
-static double factor(calcinfo *calc);
+static int factor(calcinfo *calc);
 /** 数または関数 */
-static double token(calcinfo *calc);
+static int token(calcinfo *calc);
+#endif /* UNITTEST */
+/** 構文解析 */
+static int parse(calcinfo *calc, const enum parselevel level);
+/** 演算子の優先順位 */
+static int get_prec(const int ch);
+/** 演算子の命令種別 */
+static OP get_op(const int ch);
+/** 構文解析スタック拡張 */
+static int grow_items(struct parseitem **item, size_t *capacity,
+                      const struct parseitem *local);
 /** 文字列を数値に変換 */
 static double number(calcinfo *calc);
-/** 文字数取得 */
-static int get_strlen(const double val, const char *fmt);
+/** ノード追加 */
+static int push_node(calcinfo *calc, const calcnode *node);
+/** 演算ノード追加 */
+static int add_node(calcinfo *calc, OP op, int lhs, int rhs);
+/** 数値ノード追加 */
+static int add_number(calcinfo *calc, double val, const int pos);
+/** 変数ノード追加 */
+static int add_var(calcinfo *calc, const int var);
+/** 変数検索 */
+static int find_var(const calcinfo *calc, const char *name,
+                    const size_t len);
+/** 変数名確認 */
+static bool is_var_name(const char *name);
+/** 関数ノード追加 */
+static int add_func(calcinfo *calc, const struct funcinfo *fp,
+                    const int *args);
+/** 最適化 */
+static int optimize(calccode *code);
+/** 定数畳み込み */
+static bool fold_node(calcnode *np, const calcnode *node);
+/** ノードハッシュ値取得 */
+static unsigned int hash_node(const calcnode *np);
+/** ノード比較 */
+static bool same_node(const calcnode *a, const calcnode *b);
+/** ノード評価 */
+static inline double eval_node(calcinfo *calc, const calcnode *np,
+                               const double *val);
+/** ノード配列評価 */
+static void eval(calcinfo *calc, const calccode *code, double *val,
+                 double *result);
+/** 出力に必要なバッファサイズ */
+static size_t get_answer_size(const calcinfo *calc, const long digit);
 
 /**
  * 計算結果
  *
+ * 式をコンパイルし, 評価した結果を文字列にする.\n
+ * 結果文字列は calcinfo の結果文字列バッファ, エラーメッセージの静的領域
+ * または calcinfo が保持する確保領域(alloc)を指す. 解放は destroy_answer
+ * が行うため, 呼び出し元は書き換え, 解放してはならない.
+ *
  * @param[in] calc calcinfo構造体
  * @param[in] expr 式
- * @return 新たに領域確保された結果文字列ポインタ
+ * @return 結果文字列ポインタ
  * @retval NULL エラー
  * @attention destroy_answerを必ず呼ぶこと.
  */
-unsigned char *
+const unsigned char *
 create_answer(calcinfo *calc, const unsigned char *expr)
+{
+    return create_answer_buf(calc, (const char *)expr,
+                             strlen((const char *)expr));
+}
+
+/**
+ * 計算結果(長さ指定)
+ *
+ * buf から len バイトを式として計算する. 終端文字は不要である.\n
+ * mpflag が設定されている場合は多倍長計算を行う(HAVE_MPFR のみ).
+ * iflag が設定されている場合は区間演算を行う(多倍長計算が優先).
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] buf 式
+ * @param[in] len 式の長さ
+ * @return 結果文字列ポインタ
+ * @retval NULL エラー
+ * @attention destroy_answerを必ず呼ぶこと.
+ */
+const unsigned char *
+create_answer_buf(calcinfo *calc, const char *buf, const size_t len)
+{
+    calccode *code = NULL;              /* コード */
+    const unsigned char *answer = NULL; /* 結果文字列 */
+
+    dbglog("start: len=%zu", len);
+
+#ifdef HAVE_MPFR
+    if (calc->mpflag) /* 多倍長計算 */
+        return calc_answer_mp(calc, buf, len);
+#endif /* HAVE_MPFR */
+    if (calc->iflag) /* 区間演算 */
+        return calc_answer_interval(calc, buf, len);
+
+    code = calc_compile_buf(calc, buf, len);
+    if (!code && !is_error(calc)) /* メモリ不足 */
+        return NULL;
+
+    answer = calc_answer(calc, code);
+    calc_destroy(&code);
+
+    return answer;
+}
+
+/**
+ * コードから計算結果
+ *
+ * コードを評価した結果を文字列にする.\n
+ * コードがNULLの場合, 設定されているエラーメッセージを結果とする.\n
+ * 有効桁数と処理時間計測は calcinfo の設定に従う.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] code コード
+ * @return 結果文字列ポインタ
+ * @retval NULL エラー
+ * @attention destroy_answerを必ず呼ぶこと.
+ */
+const unsigned char *
+calc_answer(calcinfo *calc, const calccode *code)
 {
     double val = 0.0;        /* 値 */
-    size_t length = 0;       /* 文字数 */
+    long digit = 0;          /* 有効桁数 */
     int retval = 0;          /* 戻り値 */
     unsigned int start = 0;  /* タイマ開始 */
 
-    dbglog("start");
-
-    calc->ptr = (unsigned char *)expr; /* 走査用ポインタ */
-    dbglog("ptr=%p", calc->ptr);
+    dbglog("start: code=%p", code);
 
-    /* フォーマット設定 */
-    retval = snprintf(calc->fmt, sizeof(calc->fmt),
-                      "%s%ld%s", "%.", digit, "g");
-    if (retval < 0) {
-        outlog("snprintf");
-        return NULL;
-    }
-    dbglog("fmt=%s", calc->fmt);
+    digit = calc_get_digit(calc);
 
-    readch(calc);
+#ifdef _DEBUG
+    /* フォーマット設定(デバッグログ用) */
+    (void)snprintf(calc->fmt, sizeof(calc->fmt), "%%.%ldg", digit);
+#endif /* _DEBUG */
 
-    if (g_tflag)
+    if (calc->tflag)
         start_timer(&start);
 
-    val = expression(calc);
+    if (code) {
+        retval = calc_eval(calc, code, &val);
+        if (retval < 0) /* メモリ不足 */
+            return NULL;
+    }
     dbglog(calc->fmt, val);
-    dbglog("ptr=%p, ch=%c", calc->ptr, calc->ch);
 
-    check_validate(calc, val);
-    if (calc->ch != '\0') /* エラー */
-        set_errorcode(calc, E_SYNTAX);
-
-    if (g_tflag) {
+    if (calc->tflag) {
         unsigned int calc_time = stop_timer(&start);
         print_timer(calc_time);
     }
@@ -123,37 +255,71 @@ create_answer(calcinfo *calc, const unsigned char *expr)
         clear_error(calc);
         if (!calc->answer)
             return NULL;
-        dbglog("answer=%p, length=%zu", calc->answer, length);
     } else {
-        /* 文字数取得 */
-        retval = get_strlen(val, calc->fmt);
-        if (retval <= 0) { /* エラー */
-            outlog("get_strlen=%d", retval);
-            return NULL;
-        }
-        dbglog("get_strlen=%d, INT_MAX=%d", retval, INT_MAX);
-        length = (size_t)retval + 1; /* 文字数 + 1 */
-
-        /* メモリ確保 */
-        calc->answer = (unsigned char *)malloc(length * sizeof(unsigned char));
-        if (!calc->answer) {
-            outlog("malloc: length=%zu", length);
-            return NULL;
-        }
-        (void)memset(calc->answer, 0, length * sizeof(unsigned char));
-
         /* 値を文字列に変換 */
-        retval = snprintf((char *)calc->answer, length, calc->fmt, val);
+        retval = calc_format((char *)calc->buf, sizeof(calc->buf), val, digit);
         if (retval < 0) {
-            outlog("snprintf: answer=%p, length=%zu", calc->answer, length);
+            outlog("calc_format: val=%g, digit=%ld", val, digit);
             return NULL;
         }
-        dbglog(calc->fmt, val);
-        dbglog("answer=%s, length=%zu", calc->answer, length);
+        calc->answer = calc->buf;
     }
+    dbglog("answer=%s", calc->answer);
     return calc->answer;
 }
 
+/**
+ * 数値を文字列に変換
+ *
+ * printf の "%.<digit>g" と同じ文字列を buf に一度で書き込む.\n
+ * 桁数内に収まる整数は libc を通さずに変換する.
+ *
+ * @param[out] buf バッファ
+ * @param[in] size バッファサイズ
+ * @param[in] val 値
+ * @param[in] dgt 有効桁数(1-INT_MAX)
+ * @return 文字数(終端を含まない)
+ * @retval EX_NG バッファ不足, 有効桁数不正またはエラー
+ */
+int
+calc_format(char *buf, const size_t size, const double val, const long dgt)
+{
+    char tmp[MAX_ANSWER];     /* 逆順の数字 */
+    unsigned long long n = 0; /* 整数値 */
+    double mag = 0.0;         /* 絶対値 */
+    size_t length = 0;        /* 文字数 */
+    size_t pos = 0;           /* 位置 */
+    int retval = 0;           /* 戻り値 */
+
+    if (dgt <= 0 || INT_MAX < dgt) { /* 有効桁数不正 */
+        outlog("dgt=%ld", dgt);
+        return EX_NG;
+    }
+
+    mag = val < 0 ? -val : val;
+    if (mag < pow10_tab[dgt < 15 ? dgt : 15] &&
+        mag == (double)(unsigned long long)mag) { /* 整数 */
+        n = (unsigned long long)mag;
+        do {
+            tmp[length++] = (char)('0' + n % 10);
+            n /= 10;
+        } while (n);
+        if (signbit(val))
+            tmp[length++] = '-';
+        if (size <= length)
+            return EX_NG;
+        while (length)
+            buf[pos++] = tmp[--length];
+        buf[pos] = '\0';
+        return (int)pos;
+    }
+
+    retval = snprintf(buf, size, "%.*g", (int)dgt, val);
+    if (retval < 0 || size <= (size_t)retval)
+        return EX_NG;
+    return retval;
+}
+
 /**
  * メモリ解放
  *
@@ -164,77 +330,440 @@ void
 destroy_answer(void *calc)
 {
     calcinfo *ptr = (calcinfo *)calc;
-    dbglog("start: result=%p", ptr->answer);
-    memfree((void **)&ptr->answer, NULL);
+    dbglog("start: result=%p, alloc=%p", ptr->answer, ptr->alloc);
+    ptr->answer = NULL;
+    memfree((void **)&ptr->alloc, NULL);
 }
 
 /**
- * 引数解析
+ * 式のコンパイル
+ *
+ * 式を一度だけ構文解析し, ノード配列に変換する.\n
+ * ノードは評価順(後置順)に並び, 被演算子は必ず自身より前にある.
  *
  * @param[in] calc calcinfo構造体
- * @param[out] x 値
- * @param[out] ... 可変引数
- * @return なし
- * @attention 最後の引数はNULLにすること.
+ * @param[in] expr 式
+ * @return 新たに領域確保されたコード
+ * @retval NULL エラー(errorcodeが設定されていなければメモリ不足)
+ * @attention calc_destroyを必ず呼ぶこと.
  */
-void
-parse_func_args(calcinfo *calc, double *x, ...)
+calccode *
+calc_compile(calcinfo *calc, const unsigned char *expr)
 {
-    double *val = NULL; /* 値 */
-    va_list ap;         /* va_list */
+    return calc_compile_buf(calc, (const char *)expr,
+                            strlen((const char *)expr));
+}
 
-    dbglog("start");
+/**
+ * 式のコンパイル(長さ指定)
+ *
+ * buf から len バイトの範囲だけを構文解析する.\n
+ * 終端文字は不要で, 受信バッファや mmap した領域をそのまま渡せる.\n
+ * 繰り返し評価するため, 定数の畳み込みと共通部分式の共有を行う.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] buf 式
+ * @param[in] len 式の長さ
+ * @return 新たに領域確保されたコード
+ * @retval NULL エラー(errorcodeが設定されていなければメモリ不足)
+ * @attention calc_destroyを必ず呼ぶこと.
+ */
+calccode *
+calc_compile_buf(calcinfo *calc, const char *buf, const size_t len)
+{
+    return calc_compile_vars(calc, buf, len, NULL, 0);
+}
 
-    if (is_error(calc))
-        return;
+/**
+ * 式のコンパイル(変数付き)
+ *
+ * vars に挙げた名前を変数として構文解析する. 変数は同名の関数より
+ * 優先される. 式中の n 番目ではなく, vars の n 番目が変数番号になる.\n
+ * 評価時は calc_eval_vars, calc_eval_many に変数番号順の値を渡す.\n
+ * 式中に書けない変数名がある場合は E_SYNTAX になる.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] buf 式
+ * @param[in] len 式の長さ
+ * @param[in] vars 変数名の配列(英字のみ, MAX_FUNC_NAME 文字以内)
+ * @param[in] nvar 変数の数
+ * @return 新たに領域確保されたコード
+ * @retval NULL エラー(errorcodeが設定されていなければメモリ不足)
+ * @attention calc_destroyを必ず呼ぶこと.
+ */
+calccode *
+calc_compile_vars(calcinfo *calc, const char *buf, const size_t len,
+                  const char *const *vars, const int nvar)
+{
+    calccode *code = NULL; /* コード */
+    int retval = 0;        /* 戻り値 */
 
-    if (calc->ch != '(') {
+    dbglog("start: len=%zu, nvar=%d", len, nvar);
+
+    int i;
+    for (i = 0; i < nvar; i++) {
+        if (!vars || !is_var_name(vars[i])) { /* 式中に書けない */
+            outlog("vars=%p, i=%d", (const void *)vars, i);
+            set_errorcode(calc, E_SYNTAX);
+            return NULL;
+        }
+    }
+
+    code = (calccode *)malloc(sizeof(calccode));
+    if (!code) {
+        outlog("malloc: size=%zu", sizeof(calccode));
+        return NULL;
+    }
+    (void)memset(code, 0, sizeof(calccode));
+    code->nvar = (0 < nvar) ? nvar : 0;
+
+    calc->vars = vars;
+    calc->nvar = code->nvar;
+    retval = calc_parse(calc, code, buf, len);
+    calc->vars = NULL;
+    calc->nvar = 0;
+
+    if (retval < 0 || optimize(code) < 0) {
+        calc_destroy(&code);
+        return NULL;
+    }
+    return code;
+}
+
+/**
+ * コード評価
+ *
+ * ノード配列を先頭から順に評価する.\n
+ * 文字列の走査, 関数名の検索は行わない.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] code コード
+ * @param[out] result 値
+ * @retval EX_NG メモリ不足
+ * @attention 計算エラーはerrorcodeに設定される.
+ */
+int
+calc_eval(calcinfo *calc, const calccode *code, double *result)
+{
+    double stack[MAX_STACK]; /* 値 */
+    double *val = stack;     /* 値 */
+
+    dbglog("start: size=%d", code->size);
+
+    if (code->nvar && !calc->var) { /* 変数の値なし */
+        outlog("nvar=%d", code->nvar);
         set_errorcode(calc, E_SYNTAX);
-        return;
+        *result = EX_ERROR;
+        return EX_OK;
     }
 
-    readch(calc);
-    *x = expression(calc);
-    dbglog(calc->fmt, *x);
+    if (NELEMS(stack) < (size_t)code->size) {
+        val = (double *)malloc(code->size * sizeof(double));
+        if (!val) {
+            outlog("malloc: size=%zu", code->size * sizeof(double));
+            *result = EX_ERROR;
+            return EX_NG;
+        }
+    }
 
-    va_start(ap, x);
+    eval(calc, code, val, result);
 
-    while ((val = va_arg(ap, double *)) != NULL) {
-        if (calc->ch != ',') {
-            set_errorcode(calc, E_SYNTAX);
-            va_end(ap);
-            return;
+    if (val != stack)
+        memfree((void **)&val, NULL);
+
+    return EX_OK;
+}
+
+/**
+ * コード評価(変数付き)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] code コード
+ * @param[in] var 変数の値(変数番号順)
+ * @param[out] result 値
+ * @retval EX_NG メモリ不足
+ * @attention 計算エラーはerrorcodeに設定される.
+ */
+int
+calc_eval_vars(calcinfo *calc, const calccode *code, const double *var,
+               double *result)
+{
+    int retval = 0; /* 戻り値 */
+
+    calc->var = var;
+    retval = calc_eval(calc, code, result);
+    calc->var = NULL;
+    return retval;
+}
+
+/**
+ * 複数の変数値でコード評価
+ *
+ * 一つのコードを count 組の変数値で順に評価する.\n
+ * var は一組 code->nvar 個の値を count 組並べたものとする.
+ * 評価用の領域は全ての組で使い回す.\n
+ * エラーになった組は result に 0 を設定し, errorcode にエラーコードを
+ * 設定する. calc の errorcode は変更しない.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] code コード
+ * @param[in] var 変数の値(count * code->nvar 個)
+ * @param[in] count 組の数
+ * @param[out] result 値の配列(count個)
+ * @param[out] errorcode エラーコードの配列(count個, NULL可)
+ * @return 評価した組の数
+ * @retval EX_NG メモリ不足または変数の値なし
+ */
+ssize_t
+calc_eval_many(calcinfo *calc, const calccode *code, const double *var,
+               const size_t count, double *result, ER *errorcode)
+{
+    double stack[MAX_STACK]; /* 値 */
+    double *val = stack;     /* 値 */
+
+    dbglog("start: size=%d, nvar=%d, count=%zu",
+           code->size, code->nvar, count);
+
+    if (code->nvar && !var) { /* 変数の値なし */
+        outlog("nvar=%d", code->nvar);
+        return EX_NG;
+    }
+
+    if (NELEMS(stack) < (size_t)code->size) {
+        val = (double *)malloc(code->size * sizeof(double));
+        if (!val) {
+            outlog("malloc: size=%zu", code->size * sizeof(double));
+            return EX_NG;
         }
-        readch(calc);
-        *val = expression(calc);
-        dbglog(calc->fmt, *val);
     }
 
-    va_end(ap);
+    size_t i;
+    for (i = 0; i < count; i++) {
+        clear_error(calc);
+        calc->var = var + i * code->nvar;
+        eval(calc, code, val, &result[i]);
+        if (errorcode)
+            errorcode[i] = calc->errorcode;
+    }
+    calc->var = NULL;
+    clear_error(calc);
+
+    if (val != stack)
+        memfree((void **)&val, NULL);
+    return (ssize_t)count;
+}
 
-    if (calc->ch != ')') {
-        set_errorcode(calc, E_SYNTAX);
-        return;
+/**
+ * 一括計算
+ *
+ * 複数の式を順に計算し, 結果文字列を出力バッファに詰めて書き込む.\n
+ * コード, 評価用の領域は全ての式で使い回す.\n
+ * 各結果文字列は終端文字付きで書き込まれ, 位置と長さ, エラーコードが
+ * result に設定される. エラーの場合はエラーメッセージを書き込む.\n
+ * 出力バッファの残りが MAX_ANSWER (多倍長計算では MAX_MPANSWER,
+ * 区間演算では MAX_IANSWER) 未満になった時点で中断する.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] expr 式の配列
+ * @param[in] len 式の長さの配列(NULLの場合, 各式は終端文字まで)
+ * @param[in] count 式の数
+ * @param[out] out 出力バッファ
+ * @param[in] outsize 出力バッファサイズ
+ * @param[out] result 結果の配列(count個)
+ * @return 計算した式の数
+ * @retval EX_NG メモリ不足
+ */
+ssize_t
+calc_eval_batch(calcinfo *calc, const unsigned char *const *expr,
+                const size_t *len, const size_t count, unsigned char *out,
+                const size_t outsize, calcresult *result)
+{
+    calccode code;            /* コード */
+    double stack[MAX_STACK];  /* 値 */
+    double *val = stack;      /* 値 */
+    size_t nval = MAX_STACK;  /* 確保済みの値の数 */
+    double *tmp = NULL;       /* 一時ポインタ */
+    double answer = 0.0;      /* 計算結果 */
+    long digit = 0;           /* 有効桁数 */
+    size_t pos = 0;           /* 出力位置 */
+    size_t done = 0;          /* 計算した式の数 */
+    int retval = 0;           /* 戻り値 */
+    unsigned int start = 0;   /* タイマ開始 */
+
+    dbglog("start: count=%zu, outsize=%zu", count, outsize);
+
+    (void)memset(&code, 0, sizeof(calccode));
+    digit = calc_get_digit(calc);
+
+    if (calc->tflag)
+        start_timer(&start);
+
+    for (done = 0; done < count; done++) {
+        if (outsize - pos < get_answer_size(calc, digit)) /* バッファ不足 */
+            break;
+
+        clear_error(calc);
+#ifdef HAVE_MPFR
+        if (calc->mpflag) { /* 多倍長計算 */
+            result[done].offset = pos;
+            retval = calc_eval_mp(calc, (const char *)expr[done],
+                                  len ? len[done] :
+                                  strlen((const char *)expr[done]),
+                                  (char *)out + pos, outsize - pos);
+            if (retval < 0 && !is_error(calc))
+                goto error_handler; /* メモリ不足 */
+            result[done].errorcode = calc->errorcode;
+            result[done].errorpos = is_error(calc) ? calc->errorpos : -1;
+            if (is_error(calc))
+                retval = snprintf((char *)out + pos, outsize - pos, "%s",
+                                  get_errorstr(calc->errorcode));
+            result[done].length = (size_t)retval;
+            pos += (size_t)retval + 1;
+            continue;
+        }
+#endif /* HAVE_MPFR */
+        if (calc->iflag) { /* 区間演算 */
+            result[done].offset = pos;
+            retval = calc_eval_interval(calc, &code, (const char *)expr[done],
+                                        len ? len[done] :
+                                        strlen((const char *)expr[done]),
+                                        (char *)out + pos, outsize - pos);
+            if (retval < 0 && !is_error(calc))
+                goto error_handler; /* メモリ不足 */
+            result[done].errorcode = calc->errorcode;
+            result[done].errorpos = is_error(calc) ? calc->errorpos : -1;
+            if (is_error(calc))
+                retval = snprintf((char *)out + pos, outsize - pos, "%s",
+                                  get_errorstr(calc->errorcode));
+            result[done].length = (size_t)retval;
+            pos += (size_t)retval + 1;
+            continue;
+        }
+
+        if (calc_parse(calc, &code, (const char *)expr[done],
+                       len ? len[done] :
+                       strlen((const char *)expr[done])) < 0 &&
+            !is_error(calc))
+            goto error_handler; /* メモリ不足 */
+
+        if (!is_error(calc)) {
+            if (nval < (size_t)code.size) { /* 評価領域拡張 */
+                tmp = (double *)realloc(val == stack ? NULL : val,
+                                        code.capacity * sizeof(double));
+                if (!tmp) {
+                    outlog("realloc: size=%zu",
+                           code.capacity * sizeof(double));
+                    goto error_handler;
+                }
+                val = tmp;
+                nval = (size_t)code.capacity;
+            }
+            eval(calc, &code, val, &answer);
+        }
+
+        result[done].offset = pos;
+        result[done].errorcode = calc->errorcode;
+        result[done].errorpos = is_error(calc) ? calc->errorpos : -1;
+        if (is_error(calc)) {
+            retval = snprintf((char *)out + pos, outsize - pos, "%s",
+                              get_errorstr(calc->errorcode));
+        } else {
+            retval = calc_format((char *)out + pos, outsize - pos,
+                                 answer, digit);
+        }
+        if (retval < 0) {
+            outlog("format: answer=%g", answer);
+            goto error_handler;
+        }
+        result[done].length = (size_t)retval;
+        pos += (size_t)retval + 1;
     }
-    readch(calc);
+    clear_error(calc);
+
+    if (calc->tflag) {
+        unsigned int calc_time = stop_timer(&start);
+        print_timer(calc_time);
+    }
+
+    if (val != stack)
+        memfree((void **)&val, NULL);
+    memfree((void **)&code.node, NULL);
+    return (ssize_t)done;
+
+error_handler:
+    clear_error(calc);
+    if (val != stack)
+        memfree((void **)&val, NULL);
+    memfree((void **)&code.node, NULL);
+    return EX_NG;
 }
 
 /**
- * 桁数設定
+ * コード解放
  *
+ * @param[in,out] code コード
  * @return なし
  */
 void
-set_digit(long dgt)
+calc_destroy(calccode **code)
 {
-    digit = dgt;
+    dbglog("start: code=%p", *code);
+
+    if (!*code)
+        return;
+    memfree((void **)&(*code)->node, (void **)code, NULL);
+}
+
+/**
+ * 引数解析
+ *
+ * 引数を解析し, 各引数のノード番号を設定する.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] args ノード番号
+ * @param[in] argc 引数の数
+ * @retval EX_NG エラー
+ */
+int
+parse_func_args(calcinfo *calc, int *args, const int argc)
+{
+    dbglog("start: argc=%d", argc);
+
+    if (is_error(calc))
+        return EX_NG;
+
+    if (calc->ch != '(') {
+        set_errorcode(calc, E_SYNTAX);
+        return EX_NG;
+    }
+
+    int i;
+    for (i = 0; i < argc; i++) {
+        if (i && calc->ch != ',') {
+            set_errorcode(calc, E_SYNTAX);
+            return EX_NG;
+        }
+        readch(calc);
+        args[i] = expression(calc);
+        dbglog("args[%d]=%d", i, args[i]);
+        if (args[i] < 0)
+            return EX_NG;
+    }
+
+    if (calc->ch != ')') {
+        set_errorcode(calc, E_SYNTAX);
+        return EX_NG;
+    }
+    readch(calc);
+    return EX_OK;
 }
 
 /**
  * バッファ読込
  *
  * バッファから一文字読み込む.
- * 空白, タブは読み飛ばす.
+ * 空白, タブは読み飛ばす.\n
+ * 走査終端に達した場合は終端文字を読み込んだものとする.
  *
  * @param[in] calc calcinfo構造体
  * @return なし
@@ -245,6 +774,10 @@ readch(calcinfo *calc)
     dbglog("start");
 
     do {
+        if (calc->end && calc->end <= calc->ptr) { /* 走査終端 */
+            calc->ch = '\0';
+            break;
+        }
         calc->ch = (int)*calc->ptr;
         dbglog("ptr=%p, ch=%c", calc->ptr, calc->ch);
         if (calc->ch == '\0')
@@ -257,223 +790,986 @@ readch(calcinfo *calc)
  * 式
  *
  * @param[in] calc calcinfo構造体
- * @return 値
+ * @return ノード番号
+ * @retval EX_NG エラー
  */
-static double
+static int
 expression(calcinfo *calc)
 {
-    double x = 0.0; /* 値 */
+    return parse(calc, PL_EXPR);
+}
 
-    dbglog("start");
+#ifdef UNITTEST
+/**
+ * 項
+ *
+ * @param[in] calc calcinfo構造体
+ * @return ノード番号
+ * @retval EX_NG エラー
+ */
+static int
+term(calcinfo *calc)
+{
+    return parse(calc, PL_TERM);
+}
 
-    if (is_error(calc))
-        return EX_ERROR;
+/**
+ * 因子
+ *
+ * @param[in] calc calcinfo構造体
+ * @return ノード番号
+ * @retval EX_NG エラー
+ */
+static int
+factor(calcinfo *calc)
+{
+    return parse(calc, PL_FACTOR);
+}
 
-    x = term(calc);
-    dbglog(calc->fmt, x);
+/**
+ * 数または関数
+ *
+ * @param[in] calc calcinfo構造体
+ * @return ノード番号
+ * @retval EX_NG エラー
+ */
+static int
+token(calcinfo *calc)
+{
+    return parse(calc, PL_TOKEN);
+}
+#endif /* UNITTEST */
+
+/**
+ * 構文解析
+ *
+ * 再帰を使わず, 括弧と関数の引数を構文解析スタックに積んで解析する.
+ * 入れ子の深さによらずスタック使用量は一定で, 構文解析スタックは
+ * MAX_STACK を超えた場合のみヒープに確保する.\n
+ * 文法は以下のとおり. 演算子は全て左結合で, ^ は * / と同じ優先順位とする.
+ * level は最も外側で受け付ける範囲を指定する.
+ * @code
+ * expression := term { ('+' | '-') term }
+ * term       := factor { ('*' | '/' | '^') factor }
+ * factor     := '(' expression ')' | token
+ * token      := [ '+' | '-' ] ( number | variable | function )
+ * function   := name [ '(' expression { ',' expression } ')' ]
+ * @endcode
+ * ノードは再帰下降で解析した場合と同じ順序(後置順)で追加する.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] level 解析する範囲
+ * @return ノード番号
+ * @retval EX_NG エラー(errorcodeが設定されていなければメモリ不足)
+ */
+static int
+parse(calcinfo *calc, const enum parselevel level)
+{
+    struct parseitem stack[MAX_STACK];          /* 構文解析スタック */
+    struct parseitem *item = stack;             /* 構文解析スタック */
+    struct parseitem *top = NULL;               /* 先頭要素 */
+    size_t capacity = NELEMS(stack);            /* 確保済みの要素数 */
+    size_t depth = 0;                           /* 要素数 */
+    size_t nframe = 0;                          /* 開いている括弧と関数 */
+    const struct funcinfo *fp = NULL;           /* 関数情報 */
+    int args[MAX_FUNC_ARGS] = { EX_NG, EX_NG }; /* 引数ノード(引数なし) */
+    char func[MAX_FUNC_NAME + 1];               /* 関数文字列(終端文字なし) */
+    const unsigned char *name = NULL;           /* 関数名の位置 */
+    size_t len = 0;                             /* 関数文字列の長さ */
+    int sign = '+';                             /* 単項+- */
+    int prec = 0;                               /* 演算子の優先順位 */
+    int var = EX_NG;                            /* 変数番号 */
+    int x = EX_NG;                              /* ノード */
+
+    dbglog("start: level=%d", (int)level);
+
+    if (is_error(calc))
+        return EX_NG;
 
     while (true) {
-        if (calc->ch == '+') {
+        /* 被演算子 */
+        if (depth == capacity && grow_items(&item, &capacity, stack) < 0)
+            goto error_handler;
+
+        if (calc->ch == '(' && (nframe || level != PL_TOKEN)) { /* 括弧 */
+            if (calc->maxdepth && calc->maxdepth <= (int)nframe) {
+                set_errorcode(calc, E_LIMIT);
+                goto error_handler;
+            }
+            item[depth].kind = PK_PAREN;
+            depth++;
+            nframe++;
             readch(calc);
-            x += term(calc);
-        } else if (calc->ch == '-') {
+            continue;
+        }
+
+        sign = '+';
+        if (calc->ch == '+' || calc->ch == '-') { /* 単項+- */
+            sign = calc->ch;
             readch(calc);
-            x -= term(calc);
-        } else {
-            break;
+        }
+
+        if (isdigit(calc->ch)) { /* 数値 */
+            int pos = (int)(calc->ptr - 1 - calc->top); /* 数値の位置 */
+            double val = number(calc);
+            x = add_number(calc, (sign == '+') ? val : -val, pos);
+            sign = '+';
+        } else if (isalpha(calc->ch)) { /* 変数または関数 */
+            name = calc->ptr - 1;
+            len = 0;
+            while (isalpha(calc->ch) && len < sizeof(func)) {
+                func[len++] = (char)calc->ch;
+                readch(calc);
+            }
+            dbglog("func=%.*s", (int)len, func);
+
+            var = find_var(calc, func, len);
+            if (0 <= var) { /* 変数 */
+                x = add_var(calc, var);
+            } else {
+                fp = get_func(func, len);
+                if (!fp) { /* エラー */
+                    set_errorpos(calc, E_NOFUNC, name);
+                    goto error_handler;
+                }
+                if (get_func_argc(fp)) { /* 引数を解析する */
+                    if (calc->ch != '(') {
+                        set_errorcode(calc, E_SYNTAX);
+                        goto error_handler;
+                    }
+                    if (calc->maxdepth && calc->maxdepth <= (int)nframe) {
+                        set_errorcode(calc, E_LIMIT);
+                        goto error_handler;
+                    }
+                    top = &item[depth++];
+                    top->kind = PK_FUNC;
+                    top->fp = fp;
+                    top->args[0] = top->args[1] = EX_NG;
+                    top->node = calc->code->size;
+                    top->argc = 0;
+                    top->neg = (sign == '-');
+                    nframe++;
+                    readch(calc);
+                    continue;
+                }
+                x = add_func(calc, fp, args);
+                /* 評価前に浮動小数点例外をクリアする */
+                if (0 <= x)
+                    calc->code->node[x].flags |= NODE_CLEARFE;
+            }
+        } else { /* エラー */
+            dbglog("ch=%c", calc->ch);
+            set_errorcode(calc, E_SYNTAX);
+            goto error_handler;
+        }
+        if (sign == '-')
+            x = add_node(calc, OP_NEG, x, EX_NG);
+        if (x < 0)
+            goto error_handler;
+
+        /* 演算子 */
+        while (true) {
+            prec = get_prec(calc->ch);
+            if (!nframe && (PL_FACTOR <= level ||
+                            (level == PL_TERM && prec == 1)))
+                prec = 0; /* 範囲外 */
+
+            while (depth && item[depth - 1].kind == PK_OP &&
+                   prec <= get_prec(item[depth - 1].op)) {
+                depth--;
+                x = add_node(calc, get_op(item[depth].op),
+                             item[depth].node, x);
+                if (x < 0)
+                    goto error_handler;
+            }
+
+            if (prec) { /* 二項演算子 */
+                top = &item[depth++];
+                top->kind = PK_OP;
+                top->op = (unsigned char)calc->ch;
+                top->node = x;
+                readch(calc);
+                break;
+            }
+
+            if (!nframe) /* 解析終了 */
+                goto done;
+
+            top = &item[depth - 1];
+            if (top->kind == PK_PAREN) { /* 括弧 */
+                if (calc->ch != ')') {
+                    set_errorcode(calc, E_SYNTAX);
+                    goto error_handler;
+                }
+                readch(calc);
+                depth--;
+                nframe--;
+                continue;
+            }
+
+            /* 関数の引数 */
+            top->args[top->argc++] = x;
+            dbglog("args[%d]=%d", top->argc - 1, x);
+            if (top->argc < get_func_argc(top->fp)) {
+                if (calc->ch != ',') {
+                    set_errorcode(calc, E_SYNTAX);
+                    goto error_handler;
+                }
+                readch(calc);
+                break;
+            }
+            if (calc->ch != ')') {
+                set_errorcode(calc, E_SYNTAX);
+                goto error_handler;
+            }
+            readch(calc);
+
+            x = add_func(calc, top->fp, top->args);
+            if (x < 0)
+                goto error_handler;
+            /* 引数の評価前に浮動小数点例外をクリアする */
+            calc->code->node[(top->node < x) ? top->node : x].flags |=
+                NODE_CLEARFE;
+            if (top->neg) {
+                x = add_node(calc, OP_NEG, x, EX_NG);
+                if (x < 0)
+                    goto error_handler;
+            }
+            depth--;
+            nframe--;
         }
     }
 
-    dbglog(calc->fmt, x);
+done:
+    if (item != stack)
+        memfree((void **)&item, NULL);
+    dbglog("x=%d", x);
     return x;
+
+error_handler:
+    if (item != stack)
+        memfree((void **)&item, NULL);
+    return EX_NG;
 }
 
 /**
- * 項
+ * 演算子の優先順位
+ *
+ * @param[in] ch 文字
+ * @return 優先順位
+ * @retval 0 二項演算子でない
+ */
+static int
+get_prec(const int ch)
+{
+    switch (ch) {
+    case '+':
+    case '-':
+        return 1;
+    case '*':
+    case '/':
+    case '^':
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * 演算子の命令種別
+ *
+ * @param[in] ch 演算子文字
+ * @return 命令種別
+ */
+static OP
+get_op(const int ch)
+{
+    switch (ch) {
+    case '+':
+        return OP_ADD;
+    case '-':
+        return OP_SUB;
+    case '*':
+        return OP_MUL;
+    case '/':
+        return OP_DIV;
+    default:
+        return OP_POW;
+    }
+}
+
+/**
+ * 構文解析スタック拡張
+ *
+ * 要素数を倍にする. スタック上の領域からはヒープにコピーする.
+ *
+ * @param[in,out] item 構文解析スタック
+ * @param[in,out] capacity 確保済みの要素数
+ * @param[in] local スタック上の領域
+ * @retval EX_NG メモリ不足
+ */
+static int
+grow_items(struct parseitem **item, size_t *capacity,
+           const struct parseitem *local)
+{
+    struct parseitem *tmp = NULL; /* 一時ポインタ */
+    size_t size = *capacity * 2;  /* 確保する要素数 */
+
+    if (*item == local) {
+        tmp = (struct parseitem *)malloc(size * sizeof(struct parseitem));
+        if (tmp)
+            (void)memcpy(tmp, local, *capacity * sizeof(struct parseitem));
+    } else {
+        tmp = (struct parseitem *)realloc(*item,
+                                          size * sizeof(struct parseitem));
+    }
+    if (!tmp) {
+        outlog("alloc: size=%zu", size * sizeof(struct parseitem));
+        return EX_NG;
+    }
+    *item = tmp;
+    *capacity = size;
+    return EX_OK;
+}
+
+/**
+ * 文字列を数値に変換
+ *
+ * 数値の書式は number_scan() を参照.
  *
  * @param[in] calc calcinfo構造体
  * @return 値
  */
 static double
-term(calcinfo *calc)
+number(calcinfo *calc)
 {
-    double x = 0.0, y = 0.0; /* 値 */
+    char text[MAX_NUMBER_TEXT];             /* 数値文字列 */
+    numberinfo num = { text, sizeof(text) }; /* 数値文字列構造体 */
+    unsigned char *start = calc->ptr - 1;   /* 数値の先頭 */
+    size_t len = SIZE_MAX;                  /* 走査する長さ */
+    size_t used = 0;                        /* 読み取った文字数 */
+    double x = 0.0;                         /* 値 */
 
     dbglog("start");
 
-    if (is_error(calc))
-        return EX_ERROR;
+    if (calc->end)
+        len = (size_t)(calc->end - start);
+    used = number_scan((const char *)start, len, &num);
+    if (!used) { /* シンタックスエラー */
+        set_errorpos(calc, E_SYNTAX, start);
+        return x;
+    }
+    calc->ptr = start + used;
+    readch(calc);
 
-    x = factor(calc);
+    x = number_to_double(&num);
     dbglog(calc->fmt, x);
 
-    while (true) {
-        if (calc->ch == '*') {
-            readch(calc);
-            x *= factor(calc);
-        } else if (calc->ch == '/') {
-            readch(calc);
-            y = factor(calc);
-            if (y == 0) { /* ゼロ除算エラー */
-                set_errorcode(calc, E_DIVBYZERO);
-                return EX_ERROR;
-            }
-            x /= y;
-        } else if (calc->ch == '^') {
-            readch(calc);
-            y = factor(calc);
-            x = get_pow(calc, x, y);
-        } else {
-            break;
+    if (isinf(x)) /* 範囲外 */
+        set_errorpos(calc, E_INFINITY, start);
+
+    return x;
+}
+
+/**
+ * ノード追加
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] node ノード
+ * @return ノード番号
+ * @retval EX_NG エラー
+ */
+static int
+push_node(calcinfo *calc, const calcnode *node)
+{
+    calccode *code = calc->code; /* コード */
+    calcnode *tmp = NULL;        /* 一時ポインタ */
+    int capacity = 0;            /* 確保するノード数 */
+
+    if (is_error(calc))
+        return EX_NG;
+
+    if (calc->maxnodes && calc->maxnodes <= code->size) { /* 制限超過 */
+        set_errorcode(calc, E_LIMIT);
+        return EX_NG;
+    }
+
+    if (code->capacity <= code->size) {
+        capacity = code->capacity ? code->capacity * 2 : INIT_NODES;
+        tmp = (calcnode *)realloc(code->node, capacity * sizeof(calcnode));
+        if (!tmp) {
+            outlog("realloc: capacity=%d", capacity);
+            return EX_NG;
         }
+        code->node = tmp;
+        code->capacity = capacity;
     }
-    dbglog(calc->fmt, x);
-    return x;
+
+    code->node[code->size] = *node;
+    dbglog("node=%d, op=%d", code->size, (int)node->op);
+    return code->size++;
 }
 
 /**
- * 因子
+ * 演算ノード追加
  *
  * @param[in] calc calcinfo構造体
- * @return 値
+ * @param[in] op 命令種別
+ * @param[in] lhs 左辺ノード
+ * @param[in] rhs 右辺ノード(単項演算の場合は無視される)
+ * @return ノード番号
+ * @retval EX_NG エラー
  */
-static double
-factor(calcinfo *calc)
+static int
+add_node(calcinfo *calc, OP op, int lhs, int rhs)
 {
-    double x = 0.0; /* 値 */
+    calcnode node; /* ノード */
 
-    dbglog("start");
+    if (lhs < 0 || (op != OP_NEG && rhs < 0)) /* 被演算子エラー */
+        return EX_NG;
 
-    if (is_error(calc))
-        return EX_ERROR;
+    (void)memset(&node, 0, sizeof(calcnode));
+    node.op = (unsigned char)op;
+    node.lhs = lhs;
+    node.rhs = (op != OP_NEG) ? rhs : EX_NG;
 
-    if (calc->ch != '(')
-        return token(calc);
+    return push_node(calc, &node);
+}
 
-    readch(calc);
-    x = expression(calc);
+/**
+ * 数値ノード追加
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] val 値
+ * @param[in] pos 数値の式中の位置
+ * @return ノード番号
+ * @retval EX_NG エラー
+ */
+static int
+add_number(calcinfo *calc, double val, const int pos)
+{
+    calcnode node; /* ノード */
 
-    if (calc->ch != ')') { /* シンタックスエラー */
-        set_errorcode(calc, E_SYNTAX);
-        return EX_ERROR;
-    }
-    readch(calc);
+    (void)memset(&node, 0, sizeof(calcnode));
+    node.op = OP_NUM;
+    node.lhs = node.rhs = EX_NG;
+    node.pos = pos;
+    node.u.val = val;
 
-    dbglog(calc->fmt, x);
-    return x;
+    return push_node(calc, &node);
 }
 
 /**
- * 数または関数
+ * 変数ノード追加
  *
  * @param[in] calc calcinfo構造体
- * @return 値
+ * @param[in] var 変数番号
+ * @return ノード番号
+ * @retval EX_NG エラー
  */
-static double
-token(calcinfo *calc)
+static int
+add_var(calcinfo *calc, const int var)
 {
-    double result = 0.0;               /* 結果 */
-    int sign = '+';                 /* 単項+- */
-    char func[MAX_FUNC_STRING + 1]; /* 関数文字列 */
-    int pos = 0;                    /* 配列位置 */
+    calcnode node; /* ノード */
 
-    dbglog("start");
+    (void)memset(&node, 0, sizeof(calcnode));
+    node.op = OP_VAR;
+    node.lhs = node.rhs = EX_NG;
+    node.u.var = var;
 
-    if (is_error(calc))
-        return EX_ERROR;
+    return push_node(calc, &node);
+}
 
-    /* 初期化 */
-    (void)memset(func, 0, sizeof(func));
+/**
+ * 変数検索
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] name 名前(終端文字は不要)
+ * @param[in] len 名前の長さ
+ * @return 変数番号
+ * @retval EX_NG 変数なし
+ */
+static int
+find_var(const calcinfo *calc, const char *name, const size_t len)
+{
+    int i;
+    for (i = 0; i < calc->nvar; i++) {
+        if (!strncmp(calc->vars[i], name, len) && !calc->vars[i][len])
+            return i;
+    }
+    return EX_NG;
+}
 
-    if (calc->ch == '+' || calc->ch == '-') { /* 単項+- */
-        sign = calc->ch;
-        readch(calc);
+/**
+ * 変数名確認
+ *
+ * 構文解析で名前として読める, 英字のみ MAX_FUNC_NAME 文字以内か確認する.
+ *
+ * @param[in] name 名前
+ * @retval true 変数名として使える
+ */
+static bool
+is_var_name(const char *name)
+{
+    size_t len = 0; /* 名前の長さ */
+
+    if (!name)
+        return false;
+    for (len = 0; name[len]; len++) {
+        if (MAX_FUNC_NAME <= len || !isalpha((unsigned char)name[len]))
+            return false;
     }
+    return 0 < len;
+}
 
-    if (isdigit(calc->ch)) { /* 数値 */
-        result = number(calc);
-    } else if (isalpha(calc->ch)) { /* 関数 */
-        while (isalpha(calc->ch) && calc->ch != '\0' &&
-               pos <= MAX_FUNC_STRING) {
-            func[pos++] = calc->ch;
-            readch(calc);
-        }
-        dbglog("func=%s", func);
+/**
+ * 関数ノード追加
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] fp 関数情報
+ * @param[in] args 引数ノード
+ * @return ノード番号
+ * @retval EX_NG エラー
+ */
+static int
+add_func(calcinfo *calc, const struct funcinfo *fp, const int *args)
+{
+    calcnode node; /* ノード */
+
+    (void)memset(&node, 0, sizeof(calcnode));
+    node.op = OP_FUNC;
+    node.lhs = args[0];
+    node.rhs = args[1];
+    node.u.func = fp;
+
+    return push_node(calc, &node);
+}
+
+/**
+ * 構文解析(最適化なし)
+ *
+ * 式を構文解析し, コードのノード配列を作り直す.\n
+ * 最初のエラーで解析を打ち切り, その位置を errorpos に設定する.\n
+ * 式の長さ, 入れ子の深さ, ノード数が calcinfo の上限を超える場合は
+ * E_LIMIT とする.\n
+ * ノード配列の領域は再利用する. 最適化は行わないため, 数値ノードの
+ * pos は式中の数値の位置を指す.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in,out] code コード
+ * @param[in] buf 式
+ * @param[in] len 式の長さ
+ * @retval EX_NG エラー(errorcodeが設定されていなければメモリ不足)
+ */
+int
+calc_parse(calcinfo *calc, calccode *code, const char *buf,
+           const size_t len)
+{
+    int root = 0; /* ルートノード */
+
+    code->size = 0;
+    calc->code = code;
+    calc->ptr = (unsigned char *)buf; /* 走査用ポインタ */
+    calc->top = calc->ptr;
+    calc->end = calc->ptr + len;
+    dbglog("ptr=%p", calc->ptr);
 
-        result = exec_func(calc, func);
+    if (calc->maxlen && calc->maxlen < len) /* 制限超過 */
+        set_errorpos(calc, E_LIMIT, calc->top + calc->maxlen);
 
-    } else { /* エラー */
-        dbglog("ch=%c", calc->ch);
+    readch(calc);
+    root = expression(calc);
+    dbglog("ptr=%p, ch=%c, root=%d", calc->ptr, calc->ch, root);
+
+    if (calc->ch != '\0') /* エラー */
         set_errorcode(calc, E_SYNTAX);
+    calc->code = NULL;
+    calc->end = NULL;
+    calc->top = NULL;
+
+    if (root < 0 || is_error(calc)) {
+        if (!is_error(calc))
+            outlog("expression=%d", root);
+        return EX_NG;
     }
-
-    dbglog(calc->fmt, result);
-    return (sign == '+') ? result : -result;
+    return EX_OK;
 }
 
 /**
- * 文字列を数値に変換
+ * 最適化
  *
- * @param[in] calc calcinfo構造体
- * @return 値
+ * 構文解析後のノード配列をその場で書き換える.\n
+ * 被演算子が全て数値のノードは, 評価して数値ノードに置き換える.
+ * 評価でエラーまたは浮動小数点例外が発生する場合, および結果が有限でない
+ * 場合は置き換えず, 実行時に同じエラーになるようにする.\n
+ * 同じノードは一つにまとめる. ただし check_math_feexcept() が見る
+ * 例外フラグを変えないよう, 演算子は浮動小数点例外のクリアを挟まない
+ * 範囲でのみまとめる. 組み込み関数は呼び出し時に例外を確認済みのため,
+ * クリアを跨いでも最初の呼び出しにまとめ, クリアは最初の呼び出しの
+ * ものを残す. 登録関数は畳み込み, 共有ともに行わない.\n
+ * 最後に, どこからも参照されなくなったノードを取り除く.
+ *
+ * @param[in,out] code コード
+ * @retval EX_NG メモリ不足
  */
-static double
-number(calcinfo *calc)
+static int
+optimize(calccode *code)
 {
-    double x = 0.0, y = 1.0; /* 値 */
+    int stack[MAX_STACK * 6]; /* 作業領域 */
+    int *work = stack;        /* 作業領域 */
+    int *map = NULL;          /* 旧ノード番号から新ノード番号 */
+    int *epoch = NULL;        /* 新ノードの例外クリア区間 */
+    int *table = NULL;        /* ハッシュテーブル */
+    size_t nslot = 16;        /* スロット数 */
+    size_t nwork = 0;         /* 作業領域の要素数 */
+    calcnode node;            /* ノード */
+    unsigned int h = 0;       /* スロット位置 */
+    int found = EX_NG;        /* 同じノード */
+    int cur = 0;              /* 現在の例外クリア区間 */
+    int n = 0;                /* 新ノード数 */
+    bool pending = false;     /* 例外クリア待ち */
+
+    dbglog("start: size=%d", code->size);
+
+    if (code->size <= 1)
+        return EX_OK;
+
+    while (nslot < (size_t)code->size * 2)
+        nslot *= 2;
+    nwork = (size_t)code->size * 2 + nslot;
+    if (NELEMS(stack) < nwork) {
+        work = (int *)malloc(nwork * sizeof(int));
+        if (!work) {
+            outlog("malloc: size=%zu", nwork * sizeof(int));
+            return EX_NG;
+        }
+    }
+    map = work;
+    epoch = map + code->size;
+    table = epoch + code->size;
+    (void)memset(table, 0xff, nslot * sizeof(int)); /* EX_NG */
+
+    /* 畳み込みと共有 */
+    int i;
+    for (i = 0; i < code->size; i++) {
+        node = code->node[i];
+        if (node.flags & NODE_CLEARFE) {
+            node.flags &= ~NODE_CLEARFE;
+            pending = true;
+        }
+        if (0 <= node.lhs)
+            node.lhs = map[node.lhs];
+        if (0 <= node.rhs)
+            node.rhs = map[node.rhs];
+        if (node.op != OP_NUM && node.op != OP_VAR)
+            (void)fold_node(&node, code->node);
+
+        h = hash_node(&node) & (nslot - 1);
+        found = EX_NG;
+        while (0 <= table[h]) {
+            if (same_node(&code->node[table[h]], &node)) {
+                found = table[h];
+                break;
+            }
+            h = (h + 1) & (nslot - 1);
+        }
+        if (0 <= found && (node.op == OP_NUM || node.op == OP_VAR ||
+                           node.op == OP_FUNC ||
+                           (!pending && epoch[found] == cur))) {
+            map[i] = found;
+            continue;
+        }
 
-    dbglog("start");
+        if (pending) {
+            node.flags |= NODE_CLEARFE;
+            pending = false;
+            cur++;
+        }
+        code->node[n] = node;
+        epoch[n] = cur;
+        if (node.op != OP_FUNC || is_pure_func(node.u.func))
+            table[h] = n; /* 同じノードは新しい方を残す */
+        map[i] = n++;
+    }
 
-    x = calc->ch - '0';
-    while (readch(calc), isdigit(calc->ch)) /* 整数 */
-        x = (x * 10) + (calc->ch - '0');
-    dbglog(calc->fmt, x);
+    /* 参照されないノードの削除(ルートが共有された場合, 後ろも削除) */
+    (void)memset(epoch, 0, n * sizeof(int));
+    epoch[map[code->size - 1]] = 1;
+    for (i = map[code->size - 1]; 0 <= i; i--) {
+        if (!epoch[i])
+            continue;
+        if (0 <= code->node[i].lhs)
+            epoch[code->node[i].lhs] = 1;
+        if (0 <= code->node[i].rhs)
+            epoch[code->node[i].rhs] = 1;
+    }
+    code->size = 0;
+    pending = false;
+    for (i = 0; i < n; i++) {
+        node = code->node[i];
+        if (!epoch[i]) { /* 数値, 変数ノードまたはルートより後ろ */
+            if (node.flags & NODE_CLEARFE)
+                pending = true;
+            continue;
+        }
+        if (0 <= node.lhs)
+            node.lhs = map[node.lhs];
+        if (0 <= node.rhs)
+            node.rhs = map[node.rhs];
+        if (pending) {
+            node.flags |= NODE_CLEARFE;
+            pending = false;
+        }
+        code->node[code->size] = node;
+        map[i] = code->size++;
+    }
+    dbglog("size=%d", code->size);
+
+    if (work != stack)
+        memfree((void **)&work, NULL);
+    return EX_OK;
+}
 
-    if (calc->ch == '.') { /* 小数 */
-        while (readch(calc), isdigit(calc->ch))
-            x += (y /= 10) * (calc->ch - '0');
+/**
+ * 定数畳み込み
+ *
+ * 被演算子が全て数値の場合, 評価して数値ノードに置き換える.
+ *
+ * @param[in,out] np ノード
+ * @param[in] node ノード配列(被演算子の参照先)
+ * @retval true 置き換えた
+ * @retval false 置き換えない
+ */
+static bool
+fold_node(calcnode *np, const calcnode *node)
+{
+    calcinfo tmp;                 /* 評価用 */
+    calcnode local = *np;         /* 被演算子を付け替えたノード */
+    double arg[2] = { 0.0, 0.0 }; /* 被演算子の値 */
+    double val = 0.0;             /* 値 */
+
+    if (np->op == OP_FUNC && !is_pure_func(np->u.func))
+        return false;
+    if (0 <= np->lhs) {
+        if (node[np->lhs].op != OP_NUM)
+            return false;
+        arg[0] = node[np->lhs].u.val;
+        local.lhs = 0;
+    }
+    if (0 <= np->rhs) {
+        if (node[np->rhs].op != OP_NUM)
+            return false;
+        arg[1] = node[np->rhs].u.val;
+        local.rhs = 1;
     }
-    dbglog(calc->fmt, x);
 
-    check_validate(calc, x);
+    (void)memset(&tmp, 0, sizeof(calcinfo));
+    clear_math_feexcept();
+    val = eval_node(&tmp, &local, arg);
+    if (is_error(&tmp) || !isfinite(val) ||
+        fetestexcept(FE_DIVBYZERO | FE_OVERFLOW |
+                     FE_UNDERFLOW | FE_INVALID))
+        return false;
+
+    dbglog("op=%d, val=%.15g", (int)np->op, val);
+    np->op = OP_NUM;
+    np->lhs = np->rhs = EX_NG;
+    np->pos = EX_NG;
+    np->u.val = val;
+    return true;
+}
 
-    return x;
+/**
+ * ノードハッシュ値取得
+ *
+ * @param[in] np ノード
+ * @return ハッシュ値
+ */
+static unsigned int
+hash_node(const calcnode *np)
+{
+    uint64_t hash = np->op; /* ハッシュ値 */
+    uint64_t bits = 0;      /* 数値または関数 */
+
+    if (np->op == OP_NUM)
+        (void)memcpy(&bits, &np->u.val, sizeof(double));
+    else if (np->op == OP_FUNC)
+        bits = (uint64_t)(uintptr_t)np->u.func;
+    else if (np->op == OP_VAR)
+        bits = (uint64_t)np->u.var;
+
+    hash = hash * 31 + (uint32_t)np->lhs;
+    hash = hash * 31 + (uint32_t)np->rhs;
+    hash ^= bits;
+    hash *= 0x9e3779b97f4a7c15ULL;
+    return (unsigned int)(hash >> 32);
 }
 
 /**
- * 文字数取得
+ * ノード比較
  *
- * @param[in] val 値
- * @param[in] fmt フォーマット
- * @return 文字数
- * @retval  0 fopenエラー
- * @retval -1 fprintfエラー
+ * フラグは比較しない. 数値はビット列で比較する.
+ *
+ * @param[in] a ノード
+ * @param[in] b ノード
+ * @retval true 同じ
  */
-static int
-get_strlen(const double val, const char *fmt)
+static bool
+same_node(const calcnode *a, const calcnode *b)
+{
+    if (a->op != b->op || a->lhs != b->lhs || a->rhs != b->rhs)
+        return false;
+    if (a->op == OP_NUM)
+        return !memcmp(&a->u.val, &b->u.val, sizeof(double));
+    if (a->op == OP_FUNC)
+        return a->u.func == b->u.func;
+    if (a->op == OP_VAR)
+        return a->u.var == b->u.var;
+    return true;
+}
+
+/**
+ * ノード評価
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] np ノード
+ * @param[in] val 被演算子の値(ノード番号で参照する)
+ * @return 値
+ * @attention 計算エラーはerrorcodeに設定される.
+ */
+static inline double
+eval_node(calcinfo *calc, const calcnode *np, const double *val)
+{
+    double args[MAX_FUNC_ARGS]; /* 引数 */
+
+    switch (np->op) {
+    case OP_NUM:
+        return np->u.val;
+    case OP_VAR:
+        return calc->var[np->u.var];
+    case OP_NEG:
+        return -val[np->lhs];
+    case OP_ADD:
+        return val[np->lhs] + val[np->rhs];
+    case OP_SUB:
+        return val[np->lhs] - val[np->rhs];
+    case OP_MUL:
+        return val[np->lhs] * val[np->rhs];
+    case OP_DIV:
+        if (val[np->rhs] == 0) { /* ゼロ除算エラー */
+            set_errorcode(calc, E_DIVBYZERO);
+            return EX_ERROR;
+        }
+        return val[np->lhs] / val[np->rhs];
+    case OP_POW:
+        return get_pow(calc, val[np->lhs], val[np->rhs]);
+    case OP_FUNC:
+        args[0] = (0 <= np->lhs) ? val[np->lhs] : 0.0;
+        args[1] = (0 <= np->rhs) ? val[np->rhs] : 0.0;
+        return exec_func(calc, np->u.func, args);
+    default:
+        outlog("op=%d", (int)np->op);
+        set_errorcode(calc, E_SYNTAX);
+        return EX_ERROR;
+    }
+}
+
+/**
+ * ノード配列評価
+ *
+ * fflag が設定されている場合, 浮動小数点例外は最初の関数または指数の前で
+ * 一度だけクリアし, 評価後に一度だけ確認する. 関数の結果は有限かどうかで
+ * 確認する. クリア後の演算子で発生したオーバーフロー, アンダーフローも
+ * エラーになる点が通常と異なる.\n
+ * timeout が設定されている場合, DEADLINE_INTERVAL ノードごとに
+ * 評価の期限を確認する.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] code コード
+ * @param[out] val 評価用領域(ノード数以上)
+ * @param[out] result 値
+ * @return なし
+ * @attention 計算エラーはerrorcodeに設定される.
+ */
+static void
+eval(calcinfo *calc, const calccode *code, double *val, double *result)
 {
-    FILE *fp = NULL; /* ファイルポインタ */
-    int retval = 0;  /* fclose戻り値 */
-    int length = 0;  /* 文字数 */
+    const calcnode *np = NULL; /* ノード */
+    bool cleared = false;      /* 浮動小数点例外クリア済み */
+
+    *result = EX_ERROR;
+    set_deadline(calc);
+
+    int i;
+    for (i = 0; i < code->size && !is_error(calc); i++) {
+        np = &code->node[i];
+        if (calc->fflag) { /* 最初の関数または指数の前で一度だけクリア */
+            if (!cleared && ((np->flags & NODE_CLEARFE) || np->op == OP_POW)) {
+                clear_math_feexcept();
+                cleared = true;
+            }
+        } else if (np->flags & NODE_CLEARFE) {
+            clear_math_feexcept();
+        }
 
-    dbglog("start: fmt=%s", fmt);
-    dbglog(fmt, val);
+        val[i] = eval_node(calc, np, val);
 
-    fp = fopen("/dev/null", "w");
-    if (!fp) { /* fopen エラー */
-        outlog("fopen");
-    } else {
-        length = fprintf(fp, fmt, val);
-        if (length < 0)
-            outlog("fprintf: fp=%p, fmt=%s, val=%g", fp, fmt, val);
+        if (calc->deadline && !((i + 1) & (DEADLINE_INTERVAL - 1)))
+            (void)check_deadline(calc);
+    }
+    calc->deadline = 0;
 
-        retval = fclose(fp);
-        if (retval == EOF) /* fclose エラー */
-            outlog("fclose: fp=%p", fp);
+    if (!is_error(calc) && 0 < code->size) {
+        *result = val[code->size - 1];
+        if (cleared)
+            check_math_feexcept(calc);
+        check_validate(calc, *result);
     }
+    dbglog("result=%.15g", *result);
+}
 
-    dbglog("length=%d", length);
-    return length;
+/**
+ * 有効桁数取得
+ *
+ * 多倍長計算の場合の上限は MAX_MPDIGIT とする.
+ *
+ * @param[in] calc calcinfo構造体
+ * @return 有効桁数(未設定の場合はデフォルト値)
+ */
+long
+calc_get_digit(const calcinfo *calc)
+{
+    long max = MAX_DIGIT; /* 上限 */
+
+#ifdef HAVE_MPFR
+    if (calc->mpflag)
+        max = MAX_MPDIGIT;
+#endif /* HAVE_MPFR */
+
+    if (calc->digit <= 0)
+        return DEFAULT_DIGIT;
+    if (max < calc->digit)
+        return max;
+    return calc->digit;
+}
+
+/**
+ * 出力に必要なバッファサイズ
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] digit 有効桁数
+ * @return 結果文字列最大長(終端含む)
+ */
+static size_t
+get_answer_size(const calcinfo *calc, const long digit)
+{
+#ifdef HAVE_MPFR
+    if (calc->mpflag && MAX_ANSWER < MAX_MPANSWER(digit))
+        return MAX_MPANSWER(digit);
+#endif /* HAVE_MPFR */
+    if (calc->iflag)
+        return MAX_IANSWER;
+    return MAX_ANSWER;
 }
 
 #ifdef UNITTEST
@@ -485,7 +1781,6 @@ test_init_calc(testcalc *calc)
     calc->factor = factor;
     calc->token = token;
     calc->number = number;
-    calc->get_strlen = get_strlen;
     calc->readch = readch;
 }
 #endif /* UNITTEST */
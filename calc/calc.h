@@ -26,7 +26,9 @@
 #ifndef _CALC_H_
 #define _CALC_H_
 
-#include <stdbool.h> /* bool */
+#include <stdbool.h>   /* bool */
+#include <stddef.h>    /* size_t */
+#include <sys/types.h> /* ssize_t */
 
 #include "def.h"
 
@@ -36,9 +38,12 @@
 #  define MAX_DIGIT    15L /**< 有効桁数最大値 */
 #endif /* _DEBUG */
 #define DEFAULT_DIGIT  12L /**< 有効桁数デフォルト値 */
-
-/* 外部変数 */
-extern bool g_tflag; /**< tオプションフラグ */
+#define MAX_MPDIGIT  1000L /**< 有効桁数最大値(多倍長計算) */
+/** 結果文字列最大長(終端含む) */
+#define MAX_ANSWER     sizeof("-1.23456789012345678901234567890e+308")
+/** 結果文字列最大長(多倍長計算, 終端含む) */
+#define MAX_MPANSWER(dgt) \
+    ((size_t)(dgt) + sizeof("-0.e-9223372036854775808"))
 
 /** エラー種別 */
 enum _ER {
@@ -48,41 +53,168 @@ enum _ER {
     E_NOFUNC,    /**< 関数名なし */
     E_NAN,       /**< 領域エラー */
     E_INFINITY,  /**< 極エラーまたは範囲エラー */
+    E_LIMIT,     /**< 制限超過 */
+    E_TIMEOUT,   /**< 制限時間超過 */
     MAXERROR     /**< エラーコード最大数 */
 };
 typedef enum _ER ER;
 
+/** 命令種別 */
+enum _OP {
+    OP_NUM = 0, /**< 数値 */
+    OP_NEG,     /**< 単項マイナス */
+    OP_ADD,     /**< 加算 */
+    OP_SUB,     /**< 減算 */
+    OP_MUL,     /**< 乗算 */
+    OP_DIV,     /**< 除算 */
+    OP_POW,     /**< べき乗 */
+    OP_FUNC,    /**< 関数呼び出し */
+    OP_VAR,     /**< 変数 */
+    MAXOP       /**< 命令最大数 */
+};
+typedef enum _OP OP;
+
+/** ノードフラグ */
+#define NODE_CLEARFE  0x01 /**< 評価前に浮動小数点例外をクリア */
+
+struct funcinfo;
+
+/** ノード構造体 */
+struct _calcnode {
+    unsigned char op;                /**< 命令種別 */
+    unsigned char flags;             /**< フラグ */
+    int lhs;                         /**< 左辺または第一引数のノード番号 */
+    int rhs;                         /**< 右辺または第二引数のノード番号 */
+    int pos;                         /**< 数値の式中の位置(数値のみ) */
+    union {
+        double val;                  /**< 数値 */
+        const struct funcinfo *func; /**< 関数 */
+        int var;                     /**< 変数番号 */
+    } u;
+};
+typedef struct _calcnode calcnode;
+
+/** コード構造体 */
+struct _calccode {
+    calcnode *node; /**< ノード配列(後置順) */
+    int size;       /**< ノード数 */
+    int capacity;   /**< 確保済みノード数 */
+    int nvar;       /**< 変数の数 */
+};
+typedef struct _calccode calccode;
+
+/** 一括計算結果構造体 */
+struct _calcresult {
+    size_t offset; /**< 結果文字列の出力バッファ内位置 */
+    size_t length; /**< 結果文字列長(終端を含まない) */
+    ER errorcode;  /**< エラーコード */
+    long errorpos; /**< エラー位置(位置のないエラーとエラーなしは -1) */
+};
+typedef struct _calcresult calcresult;
+
 /** calc情報構造体 */
 struct _calcinfo {
-    int ch;                    /**< 文字 */
-    unsigned char *ptr;        /**< 文字列走査用ポインタ */
-    unsigned char *answer;     /**< 結果文字列 */
-    char fmt[sizeof("%.18g")]; /**< フォーマット */
-    ER errorcode;              /**< エラーコード */
+    int ch;                        /**< 文字 */
+    unsigned char *ptr;            /**< 文字列走査用ポインタ */
+    const unsigned char *end;      /**< 走査終端(NULLは終端文字まで) */
+    const unsigned char *top;      /**< 走査開始位置 */
+    const unsigned char *answer;   /**< 結果文字列(buf, 静的領域または alloc) */
+    unsigned char *alloc;          /**< 確保した結果文字列(destroy_answerで解放) */
+    unsigned char buf[MAX_ANSWER]; /**< 結果文字列バッファ */
+    char fmt[sizeof("%.18g")];     /**< フォーマット */
+    ER errorcode;                  /**< エラーコード */
+    long errorpos;                 /**< 最後のエラー位置(先頭からのバイト数) */
+    calccode *code;                /**< 生成中のコード */
+    const char *const *vars;       /**< 変数名(コンパイル中) */
+    int nvar;                      /**< 変数の数(コンパイル中) */
+    const double *var;             /**< 変数の値(評価中) */
+    long digit;                    /**< 有効桁数(0はデフォルト) */
+    bool tflag;                    /**< 処理時間計測 */
+    bool mpflag;                   /**< 多倍長計算(HAVE_MPFR のみ) */
+    bool iflag;                    /**< 区間演算 */
+    bool fflag;                    /**< 浮動小数点例外を式ごとに一度だけ確認 */
+    size_t maxlen;                 /**< 式の長さの上限(0は無制限) */
+    int maxdepth;                  /**< 入れ子の深さの上限(0は無制限) */
+    int maxnodes;                  /**< ノード数の上限(0は無制限) */
+    int timeout;                   /**< 評価の制限時間(ミリ秒, 0は無制限) */
+    unsigned long long deadline;   /**< 評価の期限(評価中のみ, 0はなし) */
 };
 typedef struct _calcinfo calcinfo;
 
 /** 計算結果 */
-unsigned char *create_answer(calcinfo *calc, const unsigned char *expr);
+const unsigned char *create_answer(calcinfo *calc,
+                                   const unsigned char *expr);
 
 /** メモリ解放 */
 void destroy_answer(void *calc);
 
-/** 引数解析 */
-void parse_func_args(calcinfo *calc, double *x, ...);
+/** 計算結果(長さ指定) */
+const unsigned char *create_answer_buf(calcinfo *calc, const char *buf,
+                                       const size_t len);
+
+/** 構文解析(最適化なし) */
+int calc_parse(calcinfo *calc, calccode *code, const char *buf,
+               const size_t len);
 
-/** 桁数設定 */
-void set_digit(long digit);
+/** 有効桁数取得 */
+long calc_get_digit(const calcinfo *calc);
+
+/** 式のコンパイル */
+calccode *calc_compile(calcinfo *calc, const unsigned char *expr);
+
+/** 式のコンパイル(長さ指定) */
+calccode *calc_compile_buf(calcinfo *calc, const char *buf,
+                           const size_t len);
+
+/** 式のコンパイル(変数付き) */
+calccode *calc_compile_vars(calcinfo *calc, const char *buf,
+                            const size_t len, const char *const *vars,
+                            const int nvar);
+
+/** コードから計算結果 */
+const unsigned char *calc_answer(calcinfo *calc, const calccode *code);
+
+/** 数値を文字列に変換 */
+int calc_format(char *buf, const size_t size, const double val,
+                const long dgt);
+
+/** コード評価 */
+int calc_eval(calcinfo *calc, const calccode *code, double *result);
+
+/** コード評価(変数付き) */
+int calc_eval_vars(calcinfo *calc, const calccode *code, const double *var,
+                   double *result);
+
+/** 複数の変数値でコード評価 */
+ssize_t calc_eval_many(calcinfo *calc, const calccode *code,
+                       const double *var, const size_t count,
+                       double *result, ER *errorcode);
+
+/** 列評価 */
+ssize_t calc_eval_columns(calcinfo *calc, const calccode *code,
+                          const double *const *cols, const size_t count,
+                          double *result, ER *errorcode);
+
+/** 一括計算 */
+ssize_t calc_eval_batch(calcinfo *calc, const unsigned char *const *expr,
+                        const size_t *len, const size_t count,
+                        unsigned char *out,
+                        const size_t outsize, calcresult *result);
+
+/** コード解放 */
+void calc_destroy(calccode **code);
+
+/** 引数解析 */
+int parse_func_args(calcinfo *calc, int *args, const int argc);
 
 #ifdef UNITTEST
 struct _testcalc {
     void (*readch)(calcinfo *calc);
-    double (*expression)(calcinfo *calc);
-    double (*term)(calcinfo *calc);
-    double (*factor)(calcinfo *calc);
-    double (*token)(calcinfo *calc);
+    int (*expression)(calcinfo *calc);
+    int (*term)(calcinfo *calc);
+    int (*factor)(calcinfo *calc);
+    int (*token)(calcinfo *calc);
     double (*number)(calcinfo *calc);
-    int (*get_strlen)(const double val, const char *fmt);
 };
 typedef struct _testcalc testcalc;
 
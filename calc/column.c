@@ -0,0 +1,355 @@
+/**
+ * @file  calc/column.c
+ * @brief 列評価
+ *
+ * 一つの式を, 変数ごとに並べた値の列に対して評価する.\n
+ * ノードごとに VEC_BLOCK 個の値をまとめて計算するため, 命令の分岐は
+ * 値ごとではなくブロックごとになる. 四則演算はベクトル型で書き,
+ * 実行時の CPU に合わせて SSE2/AVX2/AVX-512 の版が選ばれる.
+ * ベクトル版のある組み込み関数は vmath.c の関数で計算するため,
+ * 結果は calc_eval_many() と数 ULP 異なることがある.\n
+ * エラーや浮動小数点例外が起きたブロックは, 一行ずつ calc_eval_vars()
+ * で評価し直す. エラーの判定は calc_eval_many() と同じ規則で行う.
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2010-2011 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdlib.h>  /* posix_memalign malloc */
+#include <string.h>  /* memcpy memset */
+#include <math.h>    /* pow */
+#include <fenv.h>    /* fetestexcept */
+
+#include "def.h"
+#include "log.h"
+#include "memfree.h"
+#include "error.h"
+#include "func.h"
+#include "calc.h"
+
+#define VEC_BLOCK  128 /**< ブロック長(値の数) */
+#define VEC_LANES  8   /**< ベクトル長(値の数) */
+#define VEC_ALIGN  64  /**< 評価用領域のアラインメント */
+
+/** ブロックを通して評価できない浮動小数点例外 */
+#define VEC_FEEXCEPT  (FE_DIVBYZERO | FE_OVERFLOW | FE_UNDERFLOW | FE_INVALID)
+
+#ifdef __GNUC__
+/** ベクトル型 */
+typedef double vdouble __attribute__((vector_size(VEC_LANES * sizeof(double))));
+/** 比較結果のベクトル型 */
+typedef long long vmask __attribute__((vector_size(VEC_LANES * sizeof(double))));
+#endif /* __GNUC__ */
+
+#if defined(__GNUC__) && defined(__x86_64__)
+/** 実行時に命令セットを選ぶ */
+#  define VEC_CLONES \
+    __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#  define VEC_CLONES
+#endif /* __GNUC__ && __x86_64__ */
+
+/* 内部関数 */
+/** ブロック評価 */
+static bool eval_block(const calccode *code, double *val,
+                       const double *const *cols, const size_t base,
+                       const size_t n) VEC_CLONES;
+/** 一行ずつ評価 */
+static int eval_rows(calcinfo *calc, const calccode *code, double *row,
+                     const double *const *cols, const size_t base,
+                     const size_t n, double *result, ER *errorcode);
+
+/**
+ * 列評価
+ *
+ * 一つのコードを count 組の変数値で評価する.\n
+ * cols[i] は変数番号 i の値を count 個並べた列とする.\n
+ * エラーコードの扱いは calc_eval_many() と同じ.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] code コード
+ * @param[in] cols 変数ごとの値の列(code->nvar 個)
+ * @param[in] count 組の数
+ * @param[out] result 値の配列(count個)
+ * @param[out] errorcode エラーコードの配列(count個, NULL可)
+ * @return 評価した組の数
+ * @retval EX_NG メモリ不足または変数の値なし
+ */
+ssize_t
+calc_eval_columns(calcinfo *calc, const calccode *code,
+                  const double *const *cols, const size_t count,
+                  double *result, ER *errorcode)
+{
+    double *val = NULL;     /* 評価用領域(ノード数 * VEC_BLOCK) */
+    double *row = NULL;     /* 一行分の変数の値 */
+    const double *r = NULL; /* 結果の列 */
+    size_t base = 0;        /* ブロック先頭 */
+    size_t n = 0;           /* ブロック内の値の数 */
+    size_t i;               /* 汎用変数 */
+    int retval = 0;         /* 戻り値 */
+
+    dbglog("start: size=%d, nvar=%d, count=%zu",
+           code->size, code->nvar, count);
+
+    if (code->nvar && !cols) { /* 変数の値なし */
+        outlog("nvar=%d", code->nvar);
+        return EX_NG;
+    }
+    if (!count)
+        return 0;
+
+    if (code->size <= 0)
+        return calc_eval_many(calc, code, NULL, count, result, errorcode);
+
+    retval = posix_memalign((void **)&val, VEC_ALIGN,
+                            code->size * VEC_BLOCK * sizeof(double));
+    if (retval) {
+        outlog("posix_memalign: size=%zu",
+               code->size * VEC_BLOCK * sizeof(double));
+        return EX_NG;
+    }
+    if (code->nvar) {
+        row = (double *)malloc(code->nvar * sizeof(double));
+        if (!row) {
+            outlog("malloc: size=%zu", code->nvar * sizeof(double));
+            goto error_handler;
+        }
+    }
+
+    r = val + (size_t)(code->size - 1) * VEC_BLOCK;
+    for (base = 0; base < count; base += n) {
+        n = count - base;
+        if (VEC_BLOCK < n)
+            n = VEC_BLOCK;
+
+        if (!eval_block(code, val, cols, base, n)) {
+            retval = eval_rows(calc, code, row, cols, base, n,
+                               result + base,
+                               errorcode ? errorcode + base : NULL);
+            if (retval < 0)
+                goto error_handler;
+            continue;
+        }
+
+        (void)memcpy(result + base, r, n * sizeof(double));
+        if (errorcode) {
+            for (i = 0; i < n; i++)
+                errorcode[base + i] = E_NONE;
+        }
+    }
+    clear_error(calc);
+
+    memfree((void **)&row, (void **)&val, NULL);
+    return (ssize_t)count;
+
+error_handler:
+    memfree((void **)&row, (void **)&val, NULL);
+    return EX_NG;
+}
+
+/**
+ * ブロック評価
+ *
+ * ブロック内の n 組をノードごとにまとめて評価する.\n
+ * 端数のブロックは最後の組の値で VEC_LANES の倍数まで埋めるため,
+ * 埋めた分で余計な例外が起きることはない.\n
+ * ゼロ除算, 関数のエラー, 浮動小数点例外, 有限でない結果のいずれかが
+ * あれば評価をやめる. 途中の値は一行ずつの評価で捨てられる.
+ *
+ * @param[in] code コード
+ * @param[out] val 評価用領域(ノード数 * VEC_BLOCK, VEC_ALIGN 境界)
+ * @param[in] cols 変数ごとの値の列
+ * @param[in] base ブロック先頭の組番号
+ * @param[in] n ブロック内の組の数(1-VEC_BLOCK)
+ * @retval true 全ての組でエラーなし
+ * @retval false 一行ずつの評価が必要
+ */
+static bool
+eval_block(const calccode *code, double *val, const double *const *cols,
+           const size_t base, const size_t n)
+{
+    const size_t m = (n + VEC_LANES - 1) & ~(size_t)(VEC_LANES - 1);
+    const calcnode *np = NULL;  /* ノード */
+    double *d = NULL;           /* 結果 */
+    const double *a = NULL;     /* 左辺または第一引数 */
+    const double *b = NULL;     /* 右辺または第二引数 */
+    double args[MAX_FUNC_ARGS]; /* 引数 */
+    calcinfo tmp;               /* 関数呼び出し用 */
+    mathfunc fn = NULL;         /* 数学関数 */
+    vmathfunc vfn = NULL;       /* ベクトル数学関数 */
+    size_t k;                   /* 汎用変数 */
+    int i;                      /* 汎用変数 */
+
+    (void)memset(&tmp, 0, sizeof(calcinfo));
+    clear_math_feexcept();
+
+    for (i = 0; i < code->size; i++) {
+        np = &code->node[i];
+        d = val + (size_t)i * VEC_BLOCK;
+        a = (0 <= np->lhs) ? val + (size_t)np->lhs * VEC_BLOCK : NULL;
+        b = (0 <= np->rhs) ? val + (size_t)np->rhs * VEC_BLOCK : NULL;
+
+        switch (np->op) {
+        case OP_NUM:
+            for (k = 0; k < m; k++)
+                d[k] = np->u.val;
+            break;
+        case OP_VAR:
+            (void)memcpy(d, cols[np->u.var] + base, n * sizeof(double));
+            for (k = n; k < m; k++)
+                d[k] = d[n - 1];
+            break;
+#ifdef __GNUC__
+        case OP_NEG:
+            for (k = 0; k < m; k += VEC_LANES)
+                *(vdouble *)(d + k) = -*(const vdouble *)(a + k);
+            break;
+        case OP_ADD:
+            for (k = 0; k < m; k += VEC_LANES)
+                *(vdouble *)(d + k) =
+                    *(const vdouble *)(a + k) + *(const vdouble *)(b + k);
+            break;
+        case OP_SUB:
+            for (k = 0; k < m; k += VEC_LANES)
+                *(vdouble *)(d + k) =
+                    *(const vdouble *)(a + k) - *(const vdouble *)(b + k);
+            break;
+        case OP_MUL:
+            for (k = 0; k < m; k += VEC_LANES)
+                *(vdouble *)(d + k) =
+                    *(const vdouble *)(a + k) * *(const vdouble *)(b + k);
+            break;
+        case OP_DIV:
+        {
+            vmask zero = { 0 }; /* ゼロの位置 */
+            for (k = 0; k < m; k += VEC_LANES)
+                zero |= *(const vdouble *)(b + k) == 0.0;
+            for (k = 0; k < VEC_LANES; k++) {
+                if (zero[k]) /* ゼロ除算 */
+                    return false;
+            }
+            for (k = 0; k < m; k += VEC_LANES)
+                *(vdouble *)(d + k) =
+                    *(const vdouble *)(a + k) / *(const vdouble *)(b + k);
+            break;
+        }
+#else
+        case OP_NEG:
+            for (k = 0; k < m; k++)
+                d[k] = -a[k];
+            break;
+        case OP_ADD:
+            for (k = 0; k < m; k++)
+                d[k] = a[k] + b[k];
+            break;
+        case OP_SUB:
+            for (k = 0; k < m; k++)
+                d[k] = a[k] - b[k];
+            break;
+        case OP_MUL:
+            for (k = 0; k < m; k++)
+                d[k] = a[k] * b[k];
+            break;
+        case OP_DIV:
+            for (k = 0; k < m; k++) {
+                if (b[k] == 0) /* ゼロ除算 */
+                    return false;
+                d[k] = a[k] / b[k];
+            }
+            break;
+#endif /* __GNUC__ */
+        case OP_POW:
+            for (k = 0; k < m; k++) {
+                if (a[k] == 0 && b[k] < 0) /* 定義域エラー */
+                    return false;
+                d[k] = pow(a[k], b[k]);
+            }
+            break;
+        case OP_FUNC:
+            vfn = get_func_vmath(np->u.func);
+            if (vfn) {
+                if (vfn(a, d, NULL, m)) /* エラーあり */
+                    return false;
+                break;
+            }
+            fn = get_func_math(np->u.func);
+            if (fn) {
+                for (k = 0; k < m; k++)
+                    d[k] = fn(a[k]);
+                break;
+            }
+            for (k = 0; k < m; k++) {
+                args[0] = a ? a[k] : 0.0;
+                args[1] = b ? b[k] : 0.0;
+                d[k] = exec_func(&tmp, np->u.func, args);
+                if (is_error(&tmp))
+                    return false;
+            }
+            break;
+        default:
+            return false;
+        }
+    }
+
+    if (fetestexcept(VEC_FEEXCEPT))
+        return false;
+
+    d = val + (size_t)(code->size - 1) * VEC_BLOCK;
+    for (k = 0; k < n; k++) {
+        if (!isfinite(d[k]))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * 一行ずつ評価
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] code コード
+ * @param[out] row 一行分の変数の値(code->nvar 個)
+ * @param[in] cols 変数ごとの値の列
+ * @param[in] base 先頭の組番号
+ * @param[in] n 組の数
+ * @param[out] result 値の配列(n個)
+ * @param[out] errorcode エラーコードの配列(n個, NULL可)
+ * @retval EX_NG メモリ不足
+ */
+static int
+eval_rows(calcinfo *calc, const calccode *code, double *row,
+          const double *const *cols, const size_t base, const size_t n,
+          double *result, ER *errorcode)
+{
+    size_t i; /* 汎用変数 */
+    int j;    /* 汎用変数 */
+
+    dbglog("base=%zu, n=%zu", base, n);
+
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < code->nvar; j++)
+            row[j] = cols[j][base + i];
+        clear_error(calc);
+        if (calc_eval_vars(calc, code, row, &result[i]) < 0)
+            return EX_NG;
+        if (errorcode)
+            errorcode[i] = calc->errorcode;
+    }
+    return EX_OK;
+}
@@ -24,12 +24,12 @@
  */
 
 #include <stdio.h>  /* NULL */
-#include <string.h> /* strdup */
 #include <math.h>   /* isnan isinf fpclassify */
 #include <fenv.h>   /* fetestexcept FE_INVALID */
 #include <errno.h>  /* errno */
 #include <assert.h> /* assert */
 
+#include "timer.h"
 #include "log.h"
 #include "error.h"
 
@@ -40,55 +40,87 @@ static const char *errormsg[] = {
     "Syntax error.",
     "Function not defined.",
     "NaN.",
-    "Infinity."
+    "Infinity.",
+    "Limit exceeded.",
+    "Timed out."
 };
 
+/**
+ * エラーメッセージ文字列取得
+ *
+ * @param[in] errorcode エラーコード
+ * @return エラーメッセージ(静的領域)
+ * @retval NULL エラーなしまたは不正なエラーコード
+ */
+const char *
+get_errorstr(const ER errorcode)
+{
+    assert(MAXERROR == NELEMS(errormsg));
+
+    if (errorcode <= E_NONE || MAXERROR <= errorcode)
+        return NULL;
+    return errormsg[errorcode];
+}
+
 /**
  * エラーメッセージ取得
  *
+ * エラー時の応答が割り当てを伴わないように, 静的領域の文字列を返す.
+ *
  * @param[in] calc calcinfo構造体
- * @return エラーメッセージ
+ * @return エラーメッセージ(静的領域)
+ * @retval NULL エラーなしまたは不正なエラーコード
  * @attention 呼び出し元で, clear_error()すること.\n
- *            戻り値ポインタは解放しなければならない.
+ *            戻り値ポインタは解放してはならない.
  */
-unsigned char *
+const unsigned char *
 get_errormsg(calcinfo *calc)
 {
-    unsigned char *msg = NULL; /* エラーメッセージ */
-
     dbglog("start: errorcode=%d", (int)calc->errorcode);
-    assert(MAXERROR == NELEMS(errormsg));
-
-    if (calc->errorcode <= E_NONE ||
-        MAXERROR <= calc->errorcode)
-        return NULL;
 
-    dbglog("errormsg=%s, errorcode=%d",
-           errormsg[calc->errorcode], (int)calc->errorcode);
-
-    msg = (unsigned char *)strdup(errormsg[calc->errorcode]);
-    if (!msg) {
-        outlog("strdup");
-        return NULL;
-    }
-
-    return msg;
+    return (const unsigned char *)get_errorstr(calc->errorcode);
 }
 
 /**
  * エラーコード設定
  *
+ * 構文解析中は, 読み込み中の文字をエラー位置とする.
+ *
  * @param[in] calc calcinfo構造体
  * @param[in] error エラー種別
  * @return なし
  */
 void
 set_errorcode(calcinfo *calc, ER error)
+{
+    const unsigned char *pos = NULL; /* エラー位置 */
+
+    if (calc->top) /* 構文解析中 */
+        pos = calc->ch ? calc->ptr - 1 : calc->ptr;
+    set_errorpos(calc, error, pos);
+}
+
+/**
+ * エラーコードと位置設定
+ *
+ * 最初のエラーのみ設定する. errorpos は clear_error() 後も保持する.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] error エラー種別
+ * @param[in] pos エラー位置(NULL は位置なし)
+ * @return なし
+ */
+void
+set_errorpos(calcinfo *calc, ER error, const unsigned char *pos)
 {
     dbglog("start: %d", (int)error);
 
-    if (calc->errorcode == E_NONE)
-        calc->errorcode = error;
+    if (calc->errorcode != E_NONE)
+        return;
+
+    calc->errorcode = error;
+    calc->errorpos = (calc->top && pos) ? (long)(pos - calc->top) : -1;
+    dbglog("errorpos=%ld", calc->errorpos);
 }
 
 /**
@@ -185,6 +217,46 @@ clear_math_feexcept(void)
     errno = 0;
 }
 
+/**
+ * 評価期限設定
+ *
+ * timeout が設定されている場合, 単調増加時刻から評価の期限を設定する.
+ *
+ * @param[in] calc calcinfo構造体
+ * @return なし
+ */
+void
+set_deadline(calcinfo *calc)
+{
+    if (calc->timeout <= 0) {
+        calc->deadline = 0;
+        return;
+    }
+    calc->deadline = get_monotonic_time() +
+        (unsigned long long)calc->timeout * 1000;
+    dbglog("deadline=%llu", calc->deadline);
+}
+
+/**
+ * 評価期限チェック
+ *
+ * 期限を過ぎている場合は E_TIMEOUT を設定する.\n
+ * 時刻を取得するため, ループでは DEADLINE_INTERVAL 回に一度だけ呼ぶ.
+ *
+ * @param[in] calc calcinfo構造体
+ * @retval true 期限切れ
+ */
+bool
+check_deadline(calcinfo *calc)
+{
+    if (!calc->deadline || get_monotonic_time() < calc->deadline)
+        return false;
+
+    outlog("timeout=%dms", calc->timeout);
+    set_errorcode(calc, E_TIMEOUT);
+    return true;
+}
+
 #ifdef UNITTEST
 void
 test_init_error(testerror *error)
@@ -32,12 +32,21 @@
 #include "calc.h"
 #include "func.h"
 
+/** 評価期限を確認する間隔(ノード数, 2のべき乗) */
+#define DEADLINE_INTERVAL 1024
+
 /** エラーメッセージ取得 */
-unsigned char *get_errormsg(calcinfo *calc);
+const unsigned char *get_errormsg(calcinfo *calc);
+
+/** エラーメッセージ文字列取得 */
+const char *get_errorstr(const ER errorcode);
 
 /** エラーコード設定 */
 void set_errorcode(calcinfo *calc, ER error);
 
+/** エラーコードと位置設定 */
+void set_errorpos(calcinfo *calc, ER error, const unsigned char *pos);
+
 /** エラークリア */
 void clear_error(calcinfo *calc);
 
@@ -53,6 +62,12 @@ void check_math_feexcept(calcinfo *calc);
 /** 浮動小数点例外チェッククリア */
 void clear_math_feexcept(void);
 
+/** 評価期限設定 */
+void set_deadline(calcinfo *calc);
+
+/** 評価期限チェック */
+bool check_deadline(calcinfo *calc);
+
 #ifdef UNITTEST
 struct _testerror {
     const char **errormsg;
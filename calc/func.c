@@ -23,13 +23,22 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
  */
 
-#include <string.h> /* strcmp */
-#include <math.h>   /* sin cos tan log log10 */
-#include <assert.h> /* assert */
+#include <stdlib.h>  /* malloc calloc free */
+#include <string.h>  /* memcmp memcpy memset */
+#include <ctype.h>   /* isalpha */
+#include <stdint.h>  /* uint32_t */
+#include <math.h>    /* sin cos tan log log10 lgamma_r fmod */
+#include <float.h>   /* DBL_EPSILON DBL_MAX */
+#include <assert.h>  /* assert */
+#include <pthread.h> /* pthread_mutex_t */
 
 #include "log.h"
+#include "memfree.h"
 #include "error.h"
 #include "func.h"
+#include "vmath.h"
+#include "mpcalc.h"
+#include "interval.h"
 
 /* 内部変数 */
 /** エラー戻り値 */
@@ -39,9 +48,31 @@ static const double DEF_PI = 3.14159265358979323846264338327950288;
 /** ネイピア数(オイラー数) */
 static const double DEF_E = 2.71828182845904523536028747135266249;
 
+#define MAX_FACTORIAL   170 /**< 倍精度で表せる階乗の最大値 */
+#define MAX_EXACT_TERMS  64 /**< 対数ガンマ関数で近似しない最大項数 */
+#define MAX_PASCAL       56 /**< パスカルの三角形の最大段(2^53 未満) */
+/** パスカルの三角形の要素数 */
+#define PASCAL_SIZE ((MAX_PASCAL + 1) * (MAX_PASCAL + 2) / 2)
+/** パスカルの三角形の位置(nCr) */
+#define PASCAL_INDEX(n, r) ((n) * ((n) + 1) / 2 + (r))
+
+/** 階乗表(0! から MAX_FACTORIAL! まで) */
+static double factable[MAX_FACTORIAL + 1];
+/** パスカルの三角形(nCr, n は MAX_PASCAL まで) */
+static double pascal[PASCAL_SIZE];
+
 /* 内部関数 */
 /** 関数情報構造体初期化 */
 static void init_func(void) __attribute__((constructor));
+/** 階乗表, パスカルの三角形初期化 */
+static void init_table(void);
+/** 登録関数ハッシュ値取得 */
+static uint32_t get_func_hash(const char *name, const size_t len);
+/** 登録関数検索 */
+static const struct funcinfo *find_userfunc(const char *name,
+                                            const size_t len);
+/** 登録関数テーブル拡張 */
+static int grow_functable(void);
 /** Pi取得 */
 static double get_pi(calcinfo *calc);
 /** ネイピア数(オイラー数)取得 */
@@ -62,6 +93,15 @@ static double get_factorial(calcinfo *calc, double n);
 static double get_permutation(calcinfo *calc, double n, double r);
 /** 組み合わせ(nCr) */
 static double get_combination(calcinfo *calc, double n, double r);
+/** 整数かどうか */
+static bool is_integer(const double x);
+/** 階乗の自然対数 */
+static double get_lnfact(const double n);
+/** 対数ガンマ関数による近似 */
+static bool get_approx(calcinfo *calc, const double terms, const double ln,
+                       const double err, double *result);
+/** 最大公約数 */
+static double get_gcd(double a, double b);
 
 /** 関数種別 */
 enum functype {
@@ -105,7 +145,8 @@ union func {
     double (*func0)(calcinfo *calc);
     double (*func1)(calcinfo *calc, double x);
     double (*func2)(calcinfo *calc, double x, double y);
-    double (*math)(double x);
+    mathfunc math;
+    calcfunc user;
 };
 
 /** 関数種別列挙体 */
@@ -113,74 +154,344 @@ enum uniontype {
     FUNC0,
     FUNC1,
     FUNC2,
-    MATH
+    MATH,
+    USER
 };
 
 /** 関数情報構造体 */
 struct funcinfo {
     enum uniontype type;
     union func func;
+    int argc;              /**< 引数の数(USERのみ) */
+    vmathfunc vmath;       /**< ベクトル版(NULLはなし) */
+#ifdef HAVE_MPFR
+    mpfrfunc mpfr;         /**< 多倍長版(NULLはなし) */
+#endif /* HAVE_MPFR */
+    intervalfunc interval; /**< 区間演算版(NULLはなし) */
 };
 
 /** 関数情報構造体配列 */
 static struct funcinfo finfo[MAXFUNC];
 
+/** 登録関数構造体 */
+struct userfunc {
+    struct funcinfo info;         /**< 関数情報(先頭に置く) */
+    size_t len;                   /**< 関数名の長さ */
+    char name[MAX_FUNC_NAME + 1]; /**< 関数名 */
+};
+
+/**
+ * 登録関数テーブル構造体
+ *
+ * 開番地法のハッシュテーブル. 参照はロックせずに行うため,
+ * スロットへの書き込みと差し替えは atomic に公開する.
+ */
+struct functable {
+    size_t mask;             /**< スロット数 - 1 */
+    size_t count;            /**< 登録数 */
+    struct userfunc *slot[]; /**< スロット */
+};
+
+#define INIT_FUNCTABLE 16 /**< 登録関数テーブルの初期スロット数 */
+
+/** 登録関数テーブル */
+static struct functable *ftable = NULL;
+/** 登録用ミューテックス */
+static pthread_mutex_t fmutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * 関数検索
+ *
+ * 長さと先頭文字で分岐し, 候補を一つに絞ってから比較する.\n
+ * 関数を追加した場合は fstring と合わせてここにも追加すること.\n
+ * 組み込み関数になければ登録関数を検索する.
+ *
+ * @param[in] name 関数名(終端文字は不要)
+ * @param[in] len 関数名の長さ
+ * @return 関数情報
+ * @retval NULL 関数なし
+ */
+const struct funcinfo *
+get_func(const char *name, const size_t len)
+{
+    enum functype type = MAXFUNC; /* 関数種別 */
+
+    dbglog("start: func=%.*s", (int)len, name);
+
+    switch (len) {
+    case 1:
+        if (name[0] == 'e')
+            type = FN_E;
+        else if (name[0] == 'n')
+            type = FN_FACT;
+        break;
+    case 2:
+        if (name[0] == 'p')
+            type = FN_PI;
+        else if (name[0] == 'l')
+            type = FN_LN;
+        break;
+    case 3:
+        switch (name[0]) {
+        case 'a': type = FN_ABS;  break;
+        case 's': type = FN_SIN;  break;
+        case 'c': type = FN_COS;  break;
+        case 't': type = FN_TAN;  break;
+        case 'e': type = FN_EXP;  break;
+        case 'l': type = FN_LOG;  break;
+        case 'r': type = FN_RAD;  break;
+        case 'd': type = FN_DEG;  break;
+        case 'n': /* nPr nCr */
+            type = (name[1] == 'C') ? FN_COMB : FN_PERM;
+            break;
+        default:
+            break;
+        }
+        break;
+    case 4:
+        if (name[0] == 's')
+            type = FN_SQRT;
+        else if (name[0] == 'a' && name[1] == 's')
+            type = FN_ASIN;
+        else if (name[0] == 'a' && name[1] == 'c')
+            type = FN_ACOS;
+        else if (name[0] == 'a' && name[1] == 't')
+            type = FN_ATAN;
+        break;
+    default:
+        break;
+    }
+
+    /* 候補と一致するか確認する */
+    if (type == MAXFUNC || memcmp(fstring[type].funcname, name, len))
+        return find_userfunc(name, len);
+
+    dbglog("ftype=%d", (int)type);
+    return &finfo[type];
+}
+
+/**
+ * 引数の数取得
+ *
+ * @param[in] fp 関数情報
+ * @return 引数の数
+ */
+int
+get_func_argc(const struct funcinfo *fp)
+{
+    switch (fp->type) {
+    case FUNC0:
+        return 0;
+    case FUNC2:
+        return 2;
+    case USER:
+        return fp->argc;
+    case FUNC1:
+    case MATH:
+    default:
+        return 1;
+    }
+}
+
+/**
+ * 副作用のない関数か
+ *
+ * 組み込み関数は引数だけで結果が決まる. 登録関数は分からないため,
+ * 畳み込みや共有の対象にしない.
+ *
+ * @param[in] fp 関数情報
+ * @retval true 副作用なし
+ */
+bool
+is_pure_func(const struct funcinfo *fp)
+{
+    return fp->type != USER;
+}
+
+/**
+ * 数学関数取得
+ *
+ * libm の関数をそのまま呼び出す関数(MATH)の場合, その関数を返す.\n
+ * 呼び出し側で値をまとめて計算する場合に使う.
+ *
+ * @param[in] fp 関数情報
+ * @return 数学関数
+ * @retval NULL MATH以外
+ */
+mathfunc
+get_func_math(const struct funcinfo *fp)
+{
+    if (fp->type != MATH)
+        return NULL;
+    return fp->func.math;
+}
+
+/**
+ * ベクトル数学関数取得
+ *
+ * 値をまとめて計算するベクトル版がある組み込み関数の場合, その関数を
+ * 返す. 結果は libm と数 ULP 異なることがある.
+ *
+ * @param[in] fp 関数情報
+ * @return ベクトル数学関数
+ * @retval NULL ベクトル版なし
+ */
+vmathfunc
+get_func_vmath(const struct funcinfo *fp)
+{
+    return fp->vmath;
+}
+
+#ifdef HAVE_MPFR
+/**
+ * 多倍長関数取得
+ *
+ * @param[in] fp 関数情報
+ * @return 多倍長関数
+ * @retval NULL 多倍長版なし(登録関数)
+ */
+mpfrfunc
+get_func_mpfr(const struct funcinfo *fp)
+{
+    return fp->mpfr;
+}
+#endif /* HAVE_MPFR */
+
+/**
+ * 区間演算関数取得
+ *
+ * @param[in] fp 関数情報
+ * @return 区間演算関数
+ * @retval NULL 区間演算版なし(登録関数)
+ */
+intervalfunc
+get_func_interval(const struct funcinfo *fp)
+{
+    return fp->interval;
+}
+
 /**
  * 関数実行
  *
+ * 浮動小数点例外のクリアは, 引数の評価前に呼び出し元で行う.\n
+ * fflag が設定されている場合は例外フラグを見ずに, 結果が有限かどうかで
+ * エラーを判定する.
+ *
  * @param[in] calc calcinfo構造体
- * @param[in] func 関数名
- * return なし
+ * @param[in] fp 関数情報
+ * @param[in] args 引数
+ * @return 計算結果
  */
 double
-exec_func(calcinfo *calc, const char *func)
+exec_func(calcinfo *calc, const struct funcinfo *fp, const double *args)
 {
-    double result = 0.0;     /* 戻り値 */
-    double x = 0.0, y = 0.0; /* 値 */
-    bool exec;               /* 関数実行フラグ */
-    enum functype ftype;     /* 関数種別 */
+    double result = 0.0; /* 戻り値 */
+
+    dbglog("start: type=%d", (int)fp->type);
+
+    switch (fp->type) {
+    case FUNC0:
+        result = fp->func.func0(calc);
+        break;
+    case FUNC1:
+        result = fp->func.func1(calc, args[0]);
+        break;
+    case FUNC2:
+        result = fp->func.func2(calc, args[0], args[1]);
+        break;
+    case MATH:
+        result = fp->func.math(args[0]);
+        break;
+    case USER: /* 処理時間が分からないため呼び出すごとに期限を確認する */
+        result = fp->func.user(calc, args);
+        (void)check_deadline(calc);
+        break;
+    default:
+        outlog("no functype");
+        break;
+    }
 
-    dbglog("start: func=%s", func);
+    if (calc->fflag)
+        check_validate(calc, result);
+    else
+        check_math_feexcept(calc);
 
-    clear_math_feexcept();
+    dbglog("x=%.15g, y=%.15g", args[0], args[1]);
+    dbglog(calc->fmt, result);
+    return result;
+}
 
-    int i;
-    for (i = 0, exec = false; i < MAXFUNC && !exec; i++) {
-        if (!strcmp(fstring[i].funcname, func)) {
-            ftype = fstring[i].type;
-            dbglog("i=%d, ftype=%d", i, (int)ftype);
-            switch (finfo[ftype].type) {
-                dbglog("type=%d", (int)finfo[ftype].type);
-            case FUNC0:
-                result = finfo[ftype].func.func0(calc);
-                break;
-            case FUNC1:
-                parse_func_args(calc, &x, NULL);
-                result = finfo[ftype].func.func1(calc, x);
-                break;
-            case FUNC2:
-                parse_func_args(calc, &x, &y, NULL);
-                result = finfo[ftype].func.func2(calc, x, y);
-                break;
-            case MATH:
-                parse_func_args(calc, &x, NULL);
-                result = finfo[ftype].func.math(x);
-                break;
-            default:
-                outlog("no functype");
-                break;
-            }
-            exec = true;
-        }
+/**
+ * 関数登録
+ *
+ * 組み込み関数と同じように式から呼び出せる関数を登録する.\n
+ * 登録は評価中の他スレッドと並行して行える. 登録した関数は
+ * プロセス終了まで解除できない.\n
+ * 引数のない関数は, 組み込み関数の pi と同様に括弧を付けずに呼び出す.
+ *
+ * @param[in] name 関数名(英字のみ, MAX_FUNC_NAME 文字以内)
+ * @param[in] arity 引数の数(0-MAX_FUNC_ARGS)
+ * @param[in] fn 関数(エラーは set_errorcode で設定する)
+ * @retval EX_NG 引数不正, 登録済みまたはメモリ不足
+ */
+int
+calc_register_func(const char *name, const int arity, calcfunc fn)
+{
+    struct userfunc *uf = NULL; /* 登録関数 */
+    struct functable *t = NULL; /* 登録関数テーブル */
+    size_t len = 0;             /* 関数名の長さ */
+    size_t i = 0;               /* スロット位置 */
+
+    dbglog("start: name=%s, arity=%d", name, arity);
+
+    if (!name || !fn || arity < 0 || MAX_FUNC_ARGS < arity)
+        return EX_NG;
+    for (len = 0; name[len]; len++) {
+        if (MAX_FUNC_NAME <= len || !isalpha((unsigned char)name[len]))
+            return EX_NG;
     }
-    if (!exec) /* エラー */
-        set_errorcode(calc, E_NOFUNC);
+    if (!len)
+        return EX_NG;
 
-    check_math_feexcept(calc);
+    (void)pthread_mutex_lock(&fmutex);
 
-    dbglog("x=%.15g, y=%.15g", x, y);
-    dbglog(calc->fmt, result);
-    return result;
+    if (get_func(name, len)) { /* 登録済み */
+        dbglog("exist: name=%s", name);
+        goto error_handler;
+    }
+
+    uf = (struct userfunc *)malloc(sizeof(struct userfunc));
+    if (!uf) {
+        outlog("malloc: size=%zu", sizeof(struct userfunc));
+        goto error_handler;
+    }
+    (void)memset(uf, 0, sizeof(struct userfunc));
+    uf->info.type = USER;
+    uf->info.func.user = fn;
+    uf->info.argc = arity;
+    uf->len = len;
+    (void)memcpy(uf->name, name, len);
+
+    t = ftable;
+    if (!t || t->mask + 1 < (t->count + 1) * 2) { /* 使用率 1/2 超 */
+        if (grow_functable() < 0)
+            goto error_handler;
+        t = ftable;
+    }
+
+    i = get_func_hash(name, len) & t->mask;
+    while (t->slot[i])
+        i = (i + 1) & t->mask;
+    __atomic_store_n(&t->slot[i], uf, __ATOMIC_RELEASE);
+    t->count++;
+
+    (void)pthread_mutex_unlock(&fmutex);
+    return EX_OK;
+
+error_handler:
+    (void)pthread_mutex_unlock(&fmutex);
+    memfree((void **)&uf, NULL);
+    return EX_NG;
 }
 
 /**
@@ -207,6 +518,12 @@ get_pow(calcinfo *calc, double x, double y)
         return EX_ERROR;
     }
 
+    if (calc->fflag) { /* 結果のみ確認 */
+        result = pow(x, y);
+        check_validate(calc, result);
+        return result;
+    }
+
     clear_math_feexcept();
 
     result = pow(x, y);
@@ -227,6 +544,11 @@ init_func(void)
     assert(MAXFUNC == NELEMS(fstring));
     assert(MAXFUNC == NELEMS(finfo));
 
+    /* get_func は fstring を関数種別で引く */
+    int i;
+    for (i = 0; i < MAXFUNC; i++)
+        assert(fstring[i].type == (enum functype)i);
+
     (void)memset(finfo, 0, sizeof(struct funcinfo));
 
     /* pi */
@@ -238,18 +560,23 @@ init_func(void)
     /* 絶対値 */
     finfo[FN_ABS].type = MATH;
     finfo[FN_ABS].func.math = fabs;
+    finfo[FN_ABS].vmath = vmath_abs;
     /* 平方根 */
     finfo[FN_SQRT].type = FUNC1;
     finfo[FN_SQRT].func.func1 = get_sqrt;
+    finfo[FN_SQRT].vmath = vmath_sqrt;
     /* 三角関数(sin) */
     finfo[FN_SIN].type = MATH;
     finfo[FN_SIN].func.math = sin;
+    finfo[FN_SIN].vmath = vmath_sin;
     /* 三角関数(cosin) */
     finfo[FN_COS].type = MATH;
     finfo[FN_COS].func.math = cos;
+    finfo[FN_COS].vmath = vmath_cos;
     /* 三角関数(tangent) */
     finfo[FN_TAN].type = MATH;
     finfo[FN_TAN].func.math = tan;
+    finfo[FN_TAN].vmath = vmath_tan;
     /* 逆三角関数(arcsin) */
     finfo[FN_ASIN].type = MATH;
     finfo[FN_ASIN].func.math = asin;
@@ -262,12 +589,15 @@ init_func(void)
     /* 指数関数 */
     finfo[FN_EXP].type = MATH;
     finfo[FN_EXP].func.math = exp;
+    finfo[FN_EXP].vmath = vmath_exp;
     /* 自然対数 */
     finfo[FN_LN].type = FUNC1;
     finfo[FN_LN].func.func1 = get_ln;
+    finfo[FN_LN].vmath = vmath_ln;
     /* 常用対数 */
     finfo[FN_LOG].type = FUNC1;
     finfo[FN_LOG].func.func1 = get_log;
+    finfo[FN_LOG].vmath = vmath_log;
     /* 角度をラジアンに変換 */
     finfo[FN_RAD].type = FUNC1;
     finfo[FN_RAD].func.func1 = get_rad;
@@ -283,6 +613,183 @@ init_func(void)
     /* 組み合わせ */
     finfo[FN_COMB].type = FUNC2;
     finfo[FN_COMB].func.func2 = get_combination;
+
+#ifdef HAVE_MPFR
+    /* 多倍長版 */
+    finfo[FN_PI].mpfr = mpcalc_pi;
+    finfo[FN_E].mpfr = mpcalc_e;
+    finfo[FN_ABS].mpfr = mpcalc_abs;
+    finfo[FN_SQRT].mpfr = mpcalc_sqrt;
+    finfo[FN_SIN].mpfr = mpcalc_sin;
+    finfo[FN_COS].mpfr = mpcalc_cos;
+    finfo[FN_TAN].mpfr = mpcalc_tan;
+    finfo[FN_ASIN].mpfr = mpcalc_asin;
+    finfo[FN_ACOS].mpfr = mpcalc_acos;
+    finfo[FN_ATAN].mpfr = mpcalc_atan;
+    finfo[FN_EXP].mpfr = mpcalc_exp;
+    finfo[FN_LN].mpfr = mpcalc_ln;
+    finfo[FN_LOG].mpfr = mpcalc_log;
+    finfo[FN_RAD].mpfr = mpcalc_rad;
+    finfo[FN_DEG].mpfr = mpcalc_deg;
+    finfo[FN_FACT].mpfr = mpcalc_fact;
+    finfo[FN_PERM].mpfr = mpcalc_perm;
+    finfo[FN_COMB].mpfr = mpcalc_comb;
+#endif /* HAVE_MPFR */
+
+    /* 区間演算版 */
+    finfo[FN_PI].interval = interval_pi;
+    finfo[FN_E].interval = interval_e;
+    finfo[FN_ABS].interval = interval_abs;
+    finfo[FN_SQRT].interval = interval_sqrt;
+    finfo[FN_SIN].interval = interval_sin;
+    finfo[FN_COS].interval = interval_cos;
+    finfo[FN_TAN].interval = interval_tan;
+    finfo[FN_ASIN].interval = interval_asin;
+    finfo[FN_ACOS].interval = interval_acos;
+    finfo[FN_ATAN].interval = interval_atan;
+    finfo[FN_EXP].interval = interval_exp;
+    finfo[FN_LN].interval = interval_ln;
+    finfo[FN_LOG].interval = interval_log;
+    finfo[FN_RAD].interval = interval_rad;
+    finfo[FN_DEG].interval = interval_deg;
+    finfo[FN_FACT].interval = interval_fact;
+    finfo[FN_PERM].interval = interval_perm;
+    finfo[FN_COMB].interval = interval_comb;
+
+    init_table();
+}
+
+/**
+ * 階乗表, パスカルの三角形初期化
+ *
+ * 起動時に一度だけ作成し, 以降は全スレッドから参照のみ行う.\n
+ * 階乗は拡張精度で積を求めてから倍精度に丸める.
+ * パスカルの三角形は加算のみで作るため, 2^53 未満の値は誤差がない.
+ *
+ * @return なし
+ */
+static void
+init_table(void)
+{
+    long double fact = 1.0L; /* 階乗(丸め誤差を抑えるため拡張精度) */
+
+    factable[0] = 1.0;
+    int n;
+    for (n = 1; n <= MAX_FACTORIAL; n++) {
+        fact *= n;
+        factable[n] = (double)fact;
+    }
+
+    for (n = 0; n <= MAX_PASCAL; n++) {
+        pascal[PASCAL_INDEX(n, 0)] = 1.0;
+        pascal[PASCAL_INDEX(n, n)] = 1.0;
+        int r;
+        for (r = 1; r < n; r++)
+            pascal[PASCAL_INDEX(n, r)] =
+                pascal[PASCAL_INDEX(n - 1, r - 1)] +
+                pascal[PASCAL_INDEX(n - 1, r)];
+    }
+}
+
+/**
+ * 登録関数ハッシュ値取得
+ *
+ * FNV-1a
+ *
+ * @param[in] name 関数名
+ * @param[in] len 関数名の長さ
+ * @return ハッシュ値
+ */
+static uint32_t
+get_func_hash(const char *name, const size_t len)
+{
+    uint32_t hash = 2166136261U; /* ハッシュ値 */
+
+    size_t i;
+    for (i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+/**
+ * 登録関数検索
+ *
+ * ロックせずに参照する. 登録と並行して呼ばれても,
+ * 公開済みのテーブルとエントリだけを読む.
+ *
+ * @param[in] name 関数名(終端文字は不要)
+ * @param[in] len 関数名の長さ
+ * @return 関数情報
+ * @retval NULL 関数なし
+ */
+static const struct funcinfo *
+find_userfunc(const char *name, const size_t len)
+{
+    const struct functable *t = NULL; /* 登録関数テーブル */
+    const struct userfunc *uf = NULL; /* 登録関数 */
+    size_t i = 0;                     /* スロット位置 */
+
+    t = __atomic_load_n(&ftable, __ATOMIC_ACQUIRE);
+    if (!t)
+        return NULL;
+
+    i = get_func_hash(name, len) & t->mask;
+    while ((uf = __atomic_load_n(&t->slot[i], __ATOMIC_ACQUIRE))) {
+        if (uf->len == len && !memcmp(uf->name, name, len))
+            return &uf->info;
+        i = (i + 1) & t->mask;
+    }
+    return NULL;
+}
+
+/**
+ * 登録関数テーブル拡張
+ *
+ * スロット数を倍にした新しいテーブルに移し替えて公開する.\n
+ * 参照中のスレッドがあり得るため, 古いテーブルは解放しない.
+ * 倍々に拡張するため, 残るテーブルは合計でも現在の大きさ程度である.
+ *
+ * @retval EX_NG メモリ不足
+ * @attention fmutex をロックして呼ぶこと.
+ */
+static int
+grow_functable(void)
+{
+    struct functable *old = ftable; /* 現在のテーブル */
+    struct functable *t = NULL;     /* 新しいテーブル */
+    size_t nslot = INIT_FUNCTABLE;  /* スロット数 */
+    size_t i = 0;                   /* スロット位置 */
+
+    if (old)
+        nslot = (old->mask + 1) * 2;
+    dbglog("nslot=%zu", nslot);
+
+    t = (struct functable *)calloc(1, sizeof(struct functable) +
+                                   nslot * sizeof(struct userfunc *));
+    if (!t) {
+        outlog("calloc: nslot=%zu", nslot);
+        return EX_NG;
+    }
+    t->mask = nslot - 1;
+
+    if (old) {
+        size_t j;
+        for (j = 0; j <= old->mask; j++) {
+            if (!old->slot[j])
+                continue;
+            i = get_func_hash(old->slot[j]->name,
+                              old->slot[j]->len) & t->mask;
+            while (t->slot[i])
+                i = (i + 1) & t->mask;
+            t->slot[i] = old->slot[j];
+        }
+        t->count = old->count;
+    }
+
+    __atomic_store_n(&ftable, t, __ATOMIC_RELEASE);
+    return EX_OK;
 }
 
 /**
@@ -447,6 +954,9 @@ get_log(calcinfo *calc, double x)
 /**
  * 階乗取得
  *
+ * 階乗表から取得する.
+ * MAX_FACTORIAL より大きい値は倍精度で表せないため範囲エラーとする.
+ *
  * @param[in] calc calcinfo構造体
  * @param[in] n 値
  * @return 階乗
@@ -455,8 +965,6 @@ static double
 get_factorial(calcinfo *calc, double n)
 {
     double result = 1.0;   /* 計算結果 */
-    double decimal = 0.0;  /* 小数 */
-    double integer = 0.0;  /* 整数 */
     bool minus = false;    /* マイナスフラグ */
 
     dbglog("start");
@@ -465,9 +973,7 @@ get_factorial(calcinfo *calc, double n)
         return EX_ERROR;
 
     /* 自然数かどうかチェック */
-    decimal = modf(n, &integer);
-    dbglog("decimal=%f, integer=%f", decimal, integer);
-    if (decimal) { /* 自然数ではない */
+    if (!is_integer(n)) { /* 自然数ではない */
         set_errorcode(calc, E_NAN);
         return EX_ERROR;
     }
@@ -477,8 +983,12 @@ get_factorial(calcinfo *calc, double n)
         minus = true;
     }
 
-    while (n > 0)
-        result *= n--;
+    if (isgreater(n, MAX_FACTORIAL)) { /* 範囲エラー */
+        set_errorcode(calc, E_INFINITY);
+        return EX_ERROR;
+    }
+
+    result = factable[(int)n];
 
     if (minus)
         result *= -1;
@@ -493,7 +1003,9 @@ get_factorial(calcinfo *calc, double n)
  *
  * 異なる n 個の整数から r 個の整数を取り出す\n
  * 順列 nPr を求める関数.\n
- * nPr = n! / (n - r)！
+ * nPr = n * (n - 1) * ... * (n - r + 1)\n
+ * n が MAX_PASCAL 以下の場合は nCr * r! を表から求める.
+ * 項数が多く, 有効桁数の範囲で誤差がない場合は対数ガンマ関数で近似する.
  *
  * @param[in] calc calcinfo構造体
  * @param[in] n 値
@@ -503,8 +1015,8 @@ get_factorial(calcinfo *calc, double n)
 static double
 get_permutation(calcinfo *calc, double n, double r)
 {
-    double result = 0.0;     /* 計算結果 */
-    double x = 0.0, y = 1.0; /* 値 */
+    double result = 1.0;         /* 計算結果 */
+    double x = 0.0, y = 0.0;     /* 階乗の自然対数 */
 
     dbglog("start");
 
@@ -516,15 +1028,31 @@ get_permutation(calcinfo *calc, double n, double r)
         set_errorcode(calc, E_NAN);
         return EX_ERROR;
     }
+    if (!is_integer(n) || !is_integer(r)) { /* 自然数ではない */
+        set_errorcode(calc, E_NAN);
+        return EX_ERROR;
+    }
 
-    x = get_factorial(calc, n);
-    dbglog(calc->fmt, x);
-    if (isgreater((n - r), 0))
-        y = get_factorial(calc, n - r);
+    if (islessequal(n, MAX_PASCAL)) {
+        result = pascal[PASCAL_INDEX((int)n, (int)r)] * factable[(int)r];
+        dbglog(calc->fmt, result);
+        return result;
+    }
 
+    x = get_lnfact(n);
+    y = get_lnfact(n - r);
     dbglog("x=%.15g, y=%.15g", x, y);
+    if (get_approx(calc, r, x - y, (x + y) * 4 * DBL_EPSILON, &result))
+        return result;
 
-    result = x / y;
+    double i;
+    for (i = 0; i < r && !isinf(result); i++)
+        result *= n - i;
+
+    if (isinf(result)) { /* 範囲エラー */
+        set_errorcode(calc, E_INFINITY);
+        return EX_ERROR;
+    }
 
     dbglog(calc->fmt, result);
     return result;
@@ -535,7 +1063,11 @@ get_permutation(calcinfo *calc, double n, double r)
  *
  * 異なる n 個の整数から r 個の整数を取り出す\n
  * 組み合わせ数 nCr を求める関数.\n
- * nCr = n! / r! (n - r)！
+ * nCr = n * (n - 1) * ... * (n - k + 1) / k!, k = min(r, n - r)\n
+ * n が MAX_PASCAL 以下の場合はパスカルの三角形から取得する.
+ * 途中の値 (n - k + i)C(i) は整数で, 掛ける前に i との公約数で割るため
+ * 積は途中の値を超えない. 結果が 2^53 以下であれば誤差がない.
+ * 項数が多く, 有効桁数の範囲で誤差がない場合は対数ガンマ関数で近似する.
  *
  * @param[in] calc calcinfo構造体
  * @param[in] n 値
@@ -545,8 +1077,9 @@ get_permutation(calcinfo *calc, double n, double r)
 static double
 get_combination(calcinfo *calc, double n, double r)
 {
-    double result = 0.0;              /* 計算結果 */
-    double x = 0.0, y = 0.0, z = 1.0; /* 値 */
+    double result = 1.0;              /* 計算結果 */
+    double x = 0.0, y = 0.0, z = 0.0; /* 階乗の自然対数 */
+    double k = 0.0;                   /* 項数 */
 
     dbglog("start");
 
@@ -558,19 +1091,131 @@ get_combination(calcinfo *calc, double n, double r)
         set_errorcode(calc, E_NAN);
         return EX_ERROR;
     }
+    if (!is_integer(n) || !is_integer(r)) { /* 自然数ではない */
+        set_errorcode(calc, E_NAN);
+        return EX_ERROR;
+    }
 
-    x = get_factorial(calc, n);
-    y = get_factorial(calc, r);
-    if (isgreater((n - r), 0))
-        z = get_factorial(calc, n - r);
+    if (islessequal(n, MAX_PASCAL)) {
+        result = pascal[PASCAL_INDEX((int)n, (int)r)];
+        dbglog(calc->fmt, result);
+        return result;
+    }
+
+    k = isless(n - r, r) ? n - r : r;
+    x = get_lnfact(n);
+    y = get_lnfact(k);
+    z = get_lnfact(n - k);
     dbglog("x=%.15g, y=%.15g, z=%.15g", x, y, z);
+    if (get_approx(calc, k, x - y - z, (x + y + z) * 4 * DBL_EPSILON,
+                   &result))
+        return result;
+
+    double i, g = 0.0;
+    for (i = 1; i <= k && !isinf(result); i++) {
+        g = get_gcd(result, i); /* i / g は n - k + i を割り切る */
+        result = (result / g) * ((n - k + i) / (i / g));
+    }
 
-    result = x / (y * z);
+    if (isinf(result)) { /* 範囲エラー */
+        set_errorcode(calc, E_INFINITY);
+        return EX_ERROR;
+    }
 
     dbglog(calc->fmt, result);
     return result;
 }
 
+/**
+ * 整数かどうか
+ *
+ * @param[in] x 値
+ * @retval true 整数
+ */
+static bool
+is_integer(const double x)
+{
+    double integer = 0.0; /* 整数 */
+
+    return isfinite(x) && !modf(x, &integer);
+}
+
+/**
+ * 階乗の自然対数
+ *
+ * ln(n!) = lgamma(n + 1)
+ *
+ * @param[in] n 値(0以上)
+ * @return 階乗の自然対数
+ */
+static double
+get_lnfact(const double n)
+{
+    int sign = 0; /* 符号(未使用) */
+
+    return lgamma_r(n + 1.0, &sign);
+}
+
+/**
+ * 対数ガンマ関数による近似
+ *
+ * 結果が倍精度で表せない場合は範囲エラーとする.\n
+ * 項数が MAX_EXACT_TERMS を超え, 自然対数の誤差が有効桁数の
+ * 範囲に収まる場合は exp(ln) で近似する.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] terms 項数
+ * @param[in] ln 結果の自然対数
+ * @param[in] err 自然対数の誤差
+ * @param[out] result 計算結果
+ * @retval true 近似またはエラー
+ * @retval false 乗算で計算する
+ */
+static bool
+get_approx(calcinfo *calc, const double terms, const double ln,
+           const double err, double *result)
+{
+    if (isgreater(ln - err, log(DBL_MAX))) { /* 範囲エラー */
+        set_errorcode(calc, E_INFINITY);
+        *result = EX_ERROR;
+        return true;
+    }
+
+    if (isgreater(terms, MAX_EXACT_TERMS) &&
+        isless(err, 0.5 * pow(10, (double)-calc_get_digit(calc)))) {
+        *result = exp(ln);
+        dbglog("approx=%.15g", *result);
+        if (isinf(*result)) { /* 範囲エラー */
+            set_errorcode(calc, E_INFINITY);
+            *result = EX_ERROR;
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * 最大公約数
+ *
+ * 整数値の倍精度浮動小数点数の最大公約数をユークリッドの互除法で求める.
+ *
+ * @param[in] a 値
+ * @param[in] b 値
+ * @return 最大公約数
+ */
+static double
+get_gcd(double a, double b)
+{
+    double t = 0.0; /* 剰余 */
+
+    while (b != 0) {
+        t = fmod(a, b);
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
 #ifdef UNITTEST
 void
 test_init_func(testfunc *func)
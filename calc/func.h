@@ -26,14 +26,70 @@
 #ifndef _FUNCTION_H_
 #define _FUNCTION_H_
 
+#ifdef HAVE_MPFR
+#  include <mpfr.h> /* mpfr_t */
+#endif /* HAVE_MPFR */
+
 #include "def.h"
 #include "calc.h"
+#include "interval.h"
 
 /** 関数最大文字数 */
 #define MAX_FUNC_STRING    4
+/** 登録関数名最大文字数 */
+#define MAX_FUNC_NAME      31
+/** 関数引数最大数 */
+#define MAX_FUNC_ARGS      2
+
+/** 登録関数 */
+typedef double (*calcfunc)(calcinfo *calc, const double *args);
+
+/** 数学関数 */
+typedef double (*mathfunc)(double x);
+
+/** ベクトル数学関数(エラーの数を返す) */
+typedef size_t (*vmathfunc)(const double *x, double *y, ER *err,
+                            const size_t n);
+
+#ifdef HAVE_MPFR
+/** 多倍長関数(使用しない引数はNULL) */
+typedef void (*mpfrfunc)(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x,
+                         mpfr_srcptr z);
+#endif /* HAVE_MPFR */
+
+/** 区間演算関数(使用しない引数はNULL) */
+typedef void (*intervalfunc)(calcinfo *calc, interval *y, const interval *x,
+                             const interval *z);
+
+/** 関数登録 */
+int calc_register_func(const char *name, const int arity, calcfunc fn);
+
+/** 関数検索 */
+const struct funcinfo *get_func(const char *name, const size_t len);
+
+/** 引数の数取得 */
+int get_func_argc(const struct funcinfo *fp);
+
+/** 副作用のない関数か */
+bool is_pure_func(const struct funcinfo *fp);
+
+/** 数学関数取得 */
+mathfunc get_func_math(const struct funcinfo *fp);
+
+/** ベクトル数学関数取得 */
+vmathfunc get_func_vmath(const struct funcinfo *fp);
+
+#ifdef HAVE_MPFR
+/** 多倍長関数取得 */
+mpfrfunc get_func_mpfr(const struct funcinfo *fp);
+#endif /* HAVE_MPFR */
+
+/** 区間演算関数取得 */
+intervalfunc get_func_interval(const struct funcinfo *fp);
 
 /** 関数実行 */
-double exec_func(calcinfo *calc, const char *func);
+double exec_func(calcinfo *calc, const struct funcinfo *fp,
+                 const double *args);
 
 /** 指数取得 */
 double get_pow(calcinfo *calc, double x, double y);
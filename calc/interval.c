@@ -0,0 +1,1247 @@
+/**
+ * @file  calc/interval.c
+ * @brief 区間演算
+ *
+ * 倍精度と同じ構文解析でノード配列を作り, 各ノードを真値を含む区間
+ * [lo, hi] で評価する.\n
+ * 丸めモードは切り替えない. 最近接丸めの結果の誤差を誤差なし変換
+ * (TwoSum, fma)で求め, 丸めの向きに応じて隣の浮動小数点数に広げる.
+ * 誤差が非正規化数になる小さい値は常に広げる.\n
+ * 数値は式中の文字列から正確に表せるかを調べ, 丸められた値は前後の
+ * 浮動小数点数に広げる. 定数畳み込みは倍精度で行われるため,
+ * 最適化は行わない.\n
+ * 数学関数は単調な範囲では端点で計算し, libm の誤差(glibc の公表値は
+ * 2 ulp 以内)に余裕を持たせて IV_ULPS ulp 広げる. sin, cos は区間内の
+ * 極値, tan は区間内の極を調べる. 階乗, 順列, 組み合わせは一点の整数
+ * のみとし, 区間の積で計算する.\n
+ * 登録関数は誤差が分からないため使用できない.\n
+ * 結果は丸めモードを一度だけ切り替えて, 下端を切り捨て, 上端を
+ * 切り上げた "[lo, hi]" の形式で出力する.
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2010-2011 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>  /* snprintf */
+#include <stdlib.h> /* malloc */
+#include <string.h> /* memset */
+#include <math.h>   /* nextafter fma sin cos tan asin acos atan exp log */
+#include <fenv.h>   /* fesetround fegetround */
+
+#include "timer.h"
+#include "log.h"
+#include "memfree.h"
+#include "error.h"
+#include "func.h"
+#include "calc.h"
+#include "interval.h"
+#include "number.h"
+
+#define IV_ULPS        4  /**< 数学関数の誤差として広げる ulp 数 */
+#define IV_STACK     128  /**< スタック上に確保する区間の数 */
+#define IV_MAX_EXP10  22  /**< 倍精度で正確に表せる 10 のべき乗の最大指数 */
+/** 誤差なし変換が使える絶対値の下限(これより小さいと誤差が非正規化数) */
+#define IV_TINY   0x1p-969
+/** 誤差なし変換で正確に表せる整数の上限 */
+#define IV_EXACT_INT  0x1p53
+/** 極値, 極の判定の相対誤差(周期数に対する余裕) */
+#define IV_PERIOD_EPS 4e-15
+
+/* 内部変数 */
+/** pi(倍精度の値は真値より小さい) */
+static const double IV_PI = 3.14159265358979323846264338327950288;
+/** ネイピア数(倍精度の値は真値より小さい) */
+static const double IV_E = 2.71828182845904523536028747135266249;
+/** 10 のべき乗(正確に表せる範囲) */
+static const double pow10_exact[IV_MAX_EXP10 + 1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* 内部関数 */
+/** 隣の浮動小数点数(小さい方) */
+static inline double next_down(const double x);
+/** 隣の浮動小数点数(大きい方) */
+static inline double next_up(const double x);
+/** ulp 単位で広げる(負数は小さい方) */
+static double widen(double x, int ulps);
+/** 加算(切り捨て) */
+static inline double add_down(const double a, const double b);
+/** 加算(切り上げ) */
+static inline double add_up(const double a, const double b);
+/** 乗算(切り捨て, 切り上げ) */
+static inline void mul_round(const double a, const double b,
+                             double *lo, double *hi);
+/** 除算(切り捨て, 切り上げ) */
+static inline void div_round(const double a, const double b,
+                             double *lo, double *hi);
+/** 区間の加算 */
+static void iv_add(interval *y, const interval *x, const interval *z);
+/** 区間の減算 */
+static void iv_sub(interval *y, const interval *x, const interval *z);
+/** 区間の乗算 */
+static void iv_mul(interval *y, const interval *x, const interval *z);
+/** 区間の除算 */
+static void iv_div(calcinfo *calc, interval *y, const interval *x,
+                   const interval *z);
+/** 一点の整数乗 */
+static void iv_powi(calcinfo *calc, interval *y, const interval *x,
+                    const double n);
+/** 区間のべき乗 */
+static void iv_pow(calcinfo *calc, interval *y, const interval *x,
+                   const interval *z);
+/** 数値ノード評価 */
+static void get_number(const calcnode *np, const char *buf,
+                       const size_t len, interval *y);
+/** 数値が正確に表せるか */
+static bool is_exact(const numberinfo *num, const double val);
+/** ノード配列評価 */
+static void eval_interval(calcinfo *calc, const calccode *code,
+                          const char *buf, const size_t len, interval *val);
+/** 周期的な点を含むか */
+static bool has_period_point(const interval *x, const double offset,
+                             const double period);
+/** 単調増加な関数 */
+static void iv_increasing(interval *y, const interval *x, mathfunc f);
+/** 一点の整数かどうか */
+static bool is_point_integer(const interval *x);
+/** 結果文字列に変換 */
+static int format_interval(char *out, const size_t size, const interval *y,
+                           const long digit);
+
+/**
+ * 区間演算結果
+ *
+ * 結果文字列は結果文字列バッファに収まらないため領域確保する.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] buf 式
+ * @param[in] len 式の長さ
+ * @return 結果文字列ポインタ
+ * @retval NULL エラー
+ * @attention destroy_answerを必ず呼ぶこと.
+ */
+const unsigned char *
+calc_answer_interval(calcinfo *calc, const char *buf, const size_t len)
+{
+    calccode code;                /* コード */
+    unsigned char *answer = NULL; /* 結果文字列 */
+    int retval = 0;               /* 戻り値 */
+    unsigned int start = 0;       /* タイマ開始 */
+
+    dbglog("start: len=%zu", len);
+
+    answer = (unsigned char *)malloc(MAX_IANSWER);
+    if (!answer) {
+        outlog("malloc: size=%zu", MAX_IANSWER);
+        return NULL;
+    }
+
+    if (calc->tflag)
+        start_timer(&start);
+
+    (void)memset(&code, 0, sizeof(calccode));
+    retval = calc_eval_interval(calc, &code, buf, len, (char *)answer,
+                                MAX_IANSWER);
+    memfree((void **)&code.node, NULL);
+
+    if (calc->tflag) {
+        unsigned int calc_time = stop_timer(&start);
+        print_timer(calc_time);
+    }
+
+    if (retval < 0 || is_error(calc)) {
+        memfree((void **)&answer, NULL);
+        if (!is_error(calc)) /* メモリ不足 */
+            return NULL;
+        calc->answer = get_errormsg(calc);
+        clear_error(calc);
+        return calc->answer;
+    }
+    calc->alloc = answer;
+    calc->answer = answer;
+    dbglog("answer=%s", calc->answer);
+    return calc->answer;
+}
+
+/**
+ * 区間演算(出力バッファ指定)
+ *
+ * 式を区間で評価し, "[lo, hi]" の形式で out に書き込む.
+ * 各端点は printf の "%.<digit>g" と同じ形式とする.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in,out] code コード(ノード配列を再利用する)
+ * @param[in] buf 式
+ * @param[in] len 式の長さ
+ * @param[out] out 出力バッファ
+ * @param[in] size 出力バッファサイズ
+ * @return 文字数(終端を含まない)
+ * @retval EX_NG エラー(errorcodeが設定されていなければメモリ不足)
+ */
+int
+calc_eval_interval(calcinfo *calc, calccode *code, const char *buf,
+                   const size_t len, char *out, const size_t size)
+{
+    interval stack[IV_STACK]; /* 値 */
+    interval *val = stack;    /* 値 */
+    int retval = 0;           /* 戻り値 */
+
+    dbglog("start: len=%zu", len);
+
+    if (calc_parse(calc, code, buf, len) < 0)
+        return EX_NG;
+
+    if (NELEMS(stack) < (size_t)code->size) {
+        val = (interval *)malloc(code->size * sizeof(interval));
+        if (!val) {
+            outlog("malloc: size=%zu", code->size * sizeof(interval));
+            return EX_NG;
+        }
+    }
+
+    eval_interval(calc, code, buf, len, val);
+    if (!is_error(calc))
+        retval = format_interval(out, size, &val[code->size - 1],
+                                 calc_get_digit(calc));
+
+    if (val != stack)
+        memfree((void **)&val, NULL);
+    if (is_error(calc))
+        return EX_NG;
+    return retval;
+}
+
+/**
+ * pi
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 未使用
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+interval_pi(calcinfo *calc, interval *y, const interval *x, const interval *z)
+{
+    y->lo = IV_PI;
+    y->hi = next_up(IV_PI);
+}
+
+/**
+ * ネイピア数(オイラー数)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 未使用
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+interval_e(calcinfo *calc, interval *y, const interval *x, const interval *z)
+{
+    y->lo = IV_E;
+    y->hi = next_up(IV_E);
+}
+
+/**
+ * 絶対値
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+interval_abs(calcinfo *calc, interval *y, const interval *x,
+             const interval *z)
+{
+    if (0 <= x->lo) {
+        *y = *x;
+    } else if (x->hi <= 0) {
+        y->lo = -x->hi;
+        y->hi = -x->lo;
+    } else { /* 0 を含む */
+        y->lo = 0.0;
+        y->hi = fmax(-x->lo, x->hi);
+    }
+}
+
+/**
+ * 平方根
+ *
+ * 丸めの向きは fma で求めた残差 x - s * s の符号で決める.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+interval_sqrt(calcinfo *calc, interval *y, const interval *x,
+              const interval *z)
+{
+    double s = 0.0; /* 平方根 */
+
+    if (x->lo < 0) { /* 定義域エラー */
+        set_errorcode(calc, E_NAN);
+        return;
+    }
+
+    s = sqrt(x->lo);
+    if (x->lo < IV_TINY)
+        y->lo = x->lo ? next_down(s) : s;
+    else
+        y->lo = fma(-s, s, x->lo) < 0 ? next_down(s) : s;
+
+    s = sqrt(x->hi);
+    if (x->hi < IV_TINY)
+        y->hi = x->hi ? next_up(s) : s;
+    else
+        y->hi = 0 < fma(-s, s, x->hi) ? next_up(s) : s;
+}
+
+/**
+ * 三角関数(sin)
+ *
+ * 最大値は pi / 2 + 2kpi, 最小値は -pi / 2 + 2kpi でとる.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+interval_sin(calcinfo *calc, interval *y, const interval *x,
+             const interval *z)
+{
+    double a = sin(x->lo), b = sin(x->hi); /* 端点の値 */
+
+    y->lo = fmax(widen(fmin(a, b), -IV_ULPS), -1.0);
+    y->hi = fmin(widen(fmax(a, b), IV_ULPS), 1.0);
+    if (has_period_point(x, IV_PI / 2, 2 * IV_PI))
+        y->hi = 1.0;
+    if (has_period_point(x, -IV_PI / 2, 2 * IV_PI))
+        y->lo = -1.0;
+}
+
+/**
+ * 三角関数(cosin)
+ *
+ * 最大値は 2kpi, 最小値は pi + 2kpi でとる.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+interval_cos(calcinfo *calc, interval *y, const interval *x,
+             const interval *z)
+{
+    double a = cos(x->lo), b = cos(x->hi); /* 端点の値 */
+
+    y->lo = fmax(widen(fmin(a, b), -IV_ULPS), -1.0);
+    y->hi = fmin(widen(fmax(a, b), IV_ULPS), 1.0);
+    if (has_period_point(x, 0.0, 2 * IV_PI))
+        y->hi = 1.0;
+    if (has_period_point(x, IV_PI, 2 * IV_PI))
+        y->lo = -1.0;
+}
+
+/**
+ * 三角関数(tangent)
+ *
+ * 極 pi / 2 + kpi を含む場合は範囲エラーとする.
+ * pi は倍精度で表せないため, 一点の区間が極を含むことはない.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+interval_tan(calcinfo *calc, interval *y, const interval *x,
+             const interval *z)
+{
+    if (x->lo < x->hi &&
+        has_period_point(x, IV_PI / 2, IV_PI)) { /* 範囲エラー */
+        set_errorcode(calc, E_INFINITY);
+        return;
+    }
+    iv_increasing(y, x, tan);
+}
+
+/**
+ * 逆三角関数(arcsin)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+interval_asin(calcinfo *calc, interval *y, const interval *x,
+              const interval *z)
+{
+    if (x->lo < -1 || 1 < x->hi) { /* 定義域エラー */
+        set_errorcode(calc, E_NAN);
+        return;
+    }
+    iv_increasing(y, x, asin);
+}
+
+/**
+ * 逆三角関数(arccosin)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+interval_acos(calcinfo *calc, interval *y, const interval *x,
+              const interval *z)
+{
+    if (x->lo < -1 || 1 < x->hi) { /* 定義域エラー */
+        set_errorcode(calc, E_NAN);
+        return;
+    }
+    /* 単調減少 */
+    y->lo = fmax(widen(acos(x->hi), -IV_ULPS), 0.0);
+    y->hi = widen(acos(x->lo), IV_ULPS);
+}
+
+/**
+ * 逆三角関数(arctangent)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+interval_atan(calcinfo *calc, interval *y, const interval *x,
+              const interval *z)
+{
+    iv_increasing(y, x, atan);
+}
+
+/**
+ * 指数関数
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+interval_exp(calcinfo *calc, interval *y, const interval *x,
+             const interval *z)
+{
+    iv_increasing(y, x, exp);
+    if (y->lo < 0)
+        y->lo = 0.0;
+}
+
+/**
+ * 自然対数
+ *
+ * 0 を含む場合は, 倍精度と同じく範囲エラーになる.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+interval_ln(calcinfo *calc, interval *y, const interval *x,
+            const interval *z)
+{
+    if (x->lo < 0) { /* 定義域エラー */
+        set_errorcode(calc, E_NAN);
+        return;
+    }
+    iv_increasing(y, x, log);
+}
+
+/**
+ * 常用対数
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+interval_log(calcinfo *calc, interval *y, const interval *x,
+             const interval *z)
+{
+    if (x->lo < 0) { /* 定義域エラー */
+        set_errorcode(calc, E_NAN);
+        return;
+    }
+    iv_increasing(y, x, log10);
+}
+
+/**
+ * 角度をラジアンに変換
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+interval_rad(calcinfo *calc, interval *y, const interval *x,
+             const interval *z)
+{
+    interval t;                                    /* pi * x */
+    const interval pi = { IV_PI, next_up(IV_PI) }; /* pi */
+    const interval c = { 180.0, 180.0 };           /* 180 */
+
+    iv_mul(&t, x, &pi);
+    iv_div(calc, y, &t, &c);
+}
+
+/**
+ * ラジアンを角度に変換
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+interval_deg(calcinfo *calc, interval *y, const interval *x,
+             const interval *z)
+{
+    interval t;                                    /* x * 180 */
+    const interval pi = { IV_PI, next_up(IV_PI) }; /* pi */
+    const interval c = { 180.0, 180.0 };           /* 180 */
+
+    iv_mul(&t, x, &c);
+    iv_div(calc, y, &t, &pi);
+}
+
+/**
+ * 階乗
+ *
+ * 倍精度と同じく, 負の整数 -n の階乗は -(n!) とする.
+ * 倍精度で表せない場合は積が無限大になり, 範囲エラーとなる.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+interval_fact(calcinfo *calc, interval *y, const interval *x,
+              const interval *z)
+{
+    double n = 0.0; /* 絶対値 */
+    double t = 0.0; /* 一時変数 */
+
+    if (!is_point_integer(x)) { /* 自然数ではない */
+        set_errorcode(calc, E_NAN);
+        return;
+    }
+
+    n = fabs(x->lo);
+    y->lo = y->hi = 1.0;
+    double i;
+    for (i = 2; i <= n && isfinite(y->hi); i++) {
+        mul_round(y->lo, i, &y->lo, &t);
+        mul_round(y->hi, i, &t, &y->hi);
+    }
+
+    if (x->lo < 0) {
+        t = y->lo;
+        y->lo = -y->hi;
+        y->hi = -t;
+    }
+}
+
+/**
+ * 順列(nPr)
+ *
+ * nPr = n * (n - 1) * ... * (n - r + 1)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x n
+ * @param[in] z r
+ * @return なし
+ */
+void
+interval_perm(calcinfo *calc, interval *y, const interval *x,
+              const interval *z)
+{
+    double n = x->lo, r = z->lo; /* 値 */
+    interval t;                  /* 項 */
+
+    if (!is_point_integer(x) || !is_point_integer(z) ||
+        n < 0 || r < 0 || n < r) { /* 定義域エラー */
+        set_errorcode(calc, E_NAN);
+        return;
+    }
+
+    y->lo = y->hi = 1.0;
+    double i;
+    for (i = 0; i < r && isfinite(y->hi); i++) {
+        t.lo = add_down(n, -i);
+        t.hi = add_up(n, -i);
+        iv_mul(y, y, &t);
+    }
+}
+
+/**
+ * 組み合わせ(nCr)
+ *
+ * nCr = n * (n - 1) * ... * (n - k + 1) / k!, k = min(r, n - r)\n
+ * n - r < r の場合, n - r は正確に計算できる(Sterbenz の補題).
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x n
+ * @param[in] z r
+ * @return なし
+ */
+void
+interval_comb(calcinfo *calc, interval *y, const interval *x,
+              const interval *z)
+{
+    double n = x->lo, r = z->lo; /* 値 */
+    double k = 0.0;              /* 項数 */
+    interval base;               /* n - k */
+    interval t, d;               /* 項 */
+
+    if (!is_point_integer(x) || !is_point_integer(z) ||
+        n < 0 || r < 0 || n < r) { /* 定義域エラー */
+        set_errorcode(calc, E_NAN);
+        return;
+    }
+
+    k = n - r < r ? n - r : r;
+    base.lo = add_down(n, -k);
+    base.hi = add_up(n, -k);
+
+    y->lo = y->hi = 1.0;
+    double i;
+    for (i = 1; i <= k && isfinite(y->hi); i++) {
+        t.lo = add_down(base.lo, i);
+        t.hi = add_up(base.hi, i);
+        d.lo = d.hi = i;
+        iv_mul(y, y, &t);
+        iv_div(calc, y, y, &d);
+    }
+}
+
+/**
+ * 隣の浮動小数点数(小さい方)
+ *
+ * @param[in] x 値
+ * @return x より小さい最大の浮動小数点数
+ */
+static inline double
+next_down(const double x)
+{
+    return nextafter(x, -INFINITY);
+}
+
+/**
+ * 隣の浮動小数点数(大きい方)
+ *
+ * @param[in] x 値
+ * @return x より大きい最小の浮動小数点数
+ */
+static inline double
+next_up(const double x)
+{
+    return nextafter(x, INFINITY);
+}
+
+/**
+ * ulp 単位で広げる
+ *
+ * @param[in] x 値
+ * @param[in] ulps 広げる ulp 数(負数は小さい方)
+ * @return 値
+ */
+static double
+widen(double x, int ulps)
+{
+    for (; ulps < 0; ulps++)
+        x = next_down(x);
+    for (; 0 < ulps; ulps--)
+        x = next_up(x);
+    return x;
+}
+
+/**
+ * 加算(切り捨て)
+ *
+ * TwoSum で求めた誤差が負であれば, 和は真値より大きい.
+ *
+ * @param[in] a 値
+ * @param[in] b 値
+ * @return a + b 以下の最大の浮動小数点数
+ */
+static inline double
+add_down(const double a, const double b)
+{
+    double s = a + b;                   /* 和 */
+    double t = s - a;                   /* b の近似 */
+    double e = (a - (s - t)) + (b - t); /* 誤差 */
+
+    return e < 0 ? next_down(s) : s;
+}
+
+/**
+ * 加算(切り上げ)
+ *
+ * @param[in] a 値
+ * @param[in] b 値
+ * @return a + b 以上の最小の浮動小数点数
+ */
+static inline double
+add_up(const double a, const double b)
+{
+    double s = a + b;                   /* 和 */
+    double t = s - a;                   /* b の近似 */
+    double e = (a - (s - t)) + (b - t); /* 誤差 */
+
+    return 0 < e ? next_up(s) : s;
+}
+
+/**
+ * 乗算(切り捨て, 切り上げ)
+ *
+ * 丸めの向きは fma で求めた誤差 a * b - p の符号で決める.
+ *
+ * @param[in] a 値
+ * @param[in] b 値
+ * @param[out] lo 切り捨てた積
+ * @param[out] hi 切り上げた積
+ * @return なし
+ */
+static inline void
+mul_round(const double a, const double b, double *lo, double *hi)
+{
+    double p = a * b; /* 積 */
+    double e = 0.0;   /* 誤差 */
+
+    if (fabs(p) < IV_TINY) { /* 誤差が非正規化数 */
+        if (a == 0 || b == 0) {
+            *lo = *hi = p;
+        } else { /* 0 に丸められても符号は変わらない */
+            *lo = (p == 0 && signbit(a) == signbit(b)) ? 0.0 : next_down(p);
+            *hi = (p == 0 && signbit(a) != signbit(b)) ? 0.0 : next_up(p);
+        }
+        return;
+    }
+    e = fma(a, b, -p);
+    *lo = e < 0 ? next_down(p) : p;
+    *hi = 0 < e ? next_up(p) : p;
+}
+
+/**
+ * 除算(切り捨て, 切り上げ)
+ *
+ * 丸めの向きは fma で求めた残差 a - q * b と b の符号で決める.
+ *
+ * @param[in] a 値
+ * @param[in] b 値(0以外)
+ * @param[out] lo 切り捨てた商
+ * @param[out] hi 切り上げた商
+ * @return なし
+ */
+static inline void
+div_round(const double a, const double b, double *lo, double *hi)
+{
+    double q = a / b; /* 商 */
+    double r = 0.0;   /* 残差 */
+
+    if (fabs(q) < IV_TINY || fabs(a) < IV_TINY) { /* 残差が非正規化数 */
+        if (a == 0) {
+            *lo = *hi = q;
+        } else { /* 0 に丸められても符号は変わらない */
+            *lo = (q == 0 && signbit(a) == signbit(b)) ? 0.0 : next_down(q);
+            *hi = (q == 0 && signbit(a) != signbit(b)) ? 0.0 : next_up(q);
+        }
+        return;
+    }
+    r = fma(-q, b, a);
+    if (r == 0) {
+        *lo = *hi = q;
+    } else if (signbit(r) == signbit(b)) { /* 真値は q より大きい */
+        *lo = q;
+        *hi = next_up(q);
+    } else {
+        *lo = next_down(q);
+        *hi = q;
+    }
+}
+
+/**
+ * 区間の加算
+ *
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 値
+ * @return なし
+ */
+static void
+iv_add(interval *y, const interval *x, const interval *z)
+{
+    double lo = add_down(x->lo, z->lo); /* 下端 */
+
+    y->hi = add_up(x->hi, z->hi);
+    y->lo = lo;
+}
+
+/**
+ * 区間の減算
+ *
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 値
+ * @return なし
+ */
+static void
+iv_sub(interval *y, const interval *x, const interval *z)
+{
+    double lo = add_down(x->lo, -z->hi); /* 下端 */
+
+    y->hi = add_up(x->hi, -z->lo);
+    y->lo = lo;
+}
+
+/**
+ * 区間の乗算
+ *
+ * 一点同士の場合は積を一度だけ求める.
+ * それ以外は四隅の積の最小値と最大値とする.
+ *
+ * @param[out] y 結果(x, z と同じでもよい)
+ * @param[in] x 値
+ * @param[in] z 値
+ * @return なし
+ */
+static void
+iv_mul(interval *y, const interval *x, const interval *z)
+{
+    double lo[4], hi[4]; /* 四隅の積 */
+
+    if (x->lo == x->hi && z->lo == z->hi) { /* 一点 */
+        mul_round(x->lo, z->lo, &lo[0], &hi[0]);
+        y->lo = lo[0];
+        y->hi = hi[0];
+        return;
+    }
+
+    mul_round(x->lo, z->lo, &lo[0], &hi[0]);
+    mul_round(x->lo, z->hi, &lo[1], &hi[1]);
+    mul_round(x->hi, z->lo, &lo[2], &hi[2]);
+    mul_round(x->hi, z->hi, &lo[3], &hi[3]);
+    y->lo = fmin(fmin(lo[0], lo[1]), fmin(lo[2], lo[3]));
+    y->hi = fmax(fmax(hi[0], hi[1]), fmax(hi[2], hi[3]));
+}
+
+/**
+ * 区間の除算
+ *
+ * 除数が 0 を含む場合はゼロ除算エラーとする.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果(x, z と同じでもよい)
+ * @param[in] x 値
+ * @param[in] z 値
+ * @return なし
+ */
+static void
+iv_div(calcinfo *calc, interval *y, const interval *x, const interval *z)
+{
+    double lo[4], hi[4]; /* 四隅の商 */
+
+    if (z->lo <= 0 && 0 <= z->hi) { /* ゼロ除算エラー */
+        set_errorcode(calc, E_DIVBYZERO);
+        return;
+    }
+
+    if (x->lo == x->hi && z->lo == z->hi) { /* 一点 */
+        div_round(x->lo, z->lo, &lo[0], &hi[0]);
+        y->lo = lo[0];
+        y->hi = hi[0];
+        return;
+    }
+
+    div_round(x->lo, z->lo, &lo[0], &hi[0]);
+    div_round(x->lo, z->hi, &lo[1], &hi[1]);
+    div_round(x->hi, z->lo, &lo[2], &hi[2]);
+    div_round(x->hi, z->hi, &lo[3], &hi[3]);
+    y->lo = fmin(fmin(lo[0], lo[1]), fmin(lo[2], lo[3]));
+    y->hi = fmax(fmax(hi[0], hi[1]), fmax(hi[2], hi[3]));
+}
+
+/**
+ * 一点の整数乗
+ *
+ * 二分累乗法で区間の積を繰り返す. 途中の積が正確であれば結果も一点になる.
+ * 負の指数は逆数とする.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 底(一点, 負の指数の場合は0以外)
+ * @param[in] n 指数(整数)
+ * @return なし
+ */
+static void
+iv_powi(calcinfo *calc, interval *y, const interval *x, const double n)
+{
+    const interval one = { 1.0, 1.0 }; /* 1 */
+    interval base = *x;                /* 底 */
+    interval r = one;                  /* 結果 */
+    double m = fabs(n);                /* 残りの指数 */
+
+    while (0 < m) {
+        if (fmod(m, 2) != 0)
+            iv_mul(&r, &r, &base);
+        m = floor(m / 2);
+        if (0 < m)
+            iv_mul(&base, &base, &base);
+    }
+    if (n < 0)
+        iv_div(calc, &r, &one, &r);
+    *y = r;
+}
+
+/**
+ * 区間のべき乗
+ *
+ * 指数が一点の整数の場合は, 底が一点であれば iv_powi() で計算し,
+ * それ以外は偶奇と符号から単調な範囲の端点で計算する.
+ * それ以外は底が負を含むと定義域エラーとし, 四隅の値の最小値と最大値を
+ * とる(x^y は x, y それぞれについて単調).\n
+ * 0 の負のべき乗は倍精度と同じく定義域エラーとする.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 底
+ * @param[in] z 指数
+ * @return なし
+ */
+static void
+iv_pow(calcinfo *calc, interval *y, const interval *x, const interval *z)
+{
+    double n = z->lo;            /* 指数 */
+    double mig = 0.0, mag = 0.0; /* 絶対値の最小値, 最大値 */
+    double a = 0.0, b = 0.0;     /* 端点の値 */
+    double v[4];                 /* 四隅の値 */
+
+    if (x->lo <= 0 && 0 <= x->hi && z->lo < 0) { /* 定義域エラー */
+        set_errorcode(calc, E_NAN);
+        return;
+    }
+
+    if (is_point_integer(z)) { /* 整数乗 */
+        if (n == 0) {
+            y->lo = y->hi = 1.0;
+            return;
+        }
+        if (x->lo == x->hi && fabs(n) <= IV_EXACT_INT) { /* 一点 */
+            iv_powi(calc, y, x, n);
+            return;
+        }
+        if (fmod(n, 2) == 0) { /* 偶数乗は絶対値で単調 */
+            mig = (x->lo <= 0 && 0 <= x->hi) ? 0.0 :
+                fmin(fabs(x->lo), fabs(x->hi));
+            mag = fmax(fabs(x->lo), fabs(x->hi));
+            a = pow(mig, n);
+            b = pow(mag, n);
+        } else { /* 奇数乗は単調 */
+            a = pow(x->lo, n);
+            b = pow(x->hi, n);
+        }
+        y->lo = widen(fmin(a, b), -IV_ULPS);
+        y->hi = widen(fmax(a, b), IV_ULPS);
+        if (fmod(n, 2) == 0 && y->lo < 0)
+            y->lo = 0.0;
+        return;
+    }
+
+    if (x->lo < 0) { /* 定義域エラー */
+        set_errorcode(calc, E_NAN);
+        return;
+    }
+
+    v[0] = pow(x->lo, z->lo);
+    v[1] = pow(x->lo, z->hi);
+    v[2] = pow(x->hi, z->lo);
+    v[3] = pow(x->hi, z->hi);
+    y->lo = fmax(widen(fmin(fmin(v[0], v[1]), fmin(v[2], v[3])), -IV_ULPS),
+                 0.0);
+    y->hi = widen(fmax(fmax(v[0], v[1]), fmax(v[2], v[3])), IV_ULPS);
+}
+
+/**
+ * 数値ノード評価
+ *
+ * number() と同じ number_scan() で式中の数値を読み, 正確に表せない場合は
+ * 前後の浮動小数点数に広げる. 数値は正しく丸められているため,
+ * 真値は前後の浮動小数点数の間にある.
+ *
+ * @param[in] np ノード
+ * @param[in] buf 式
+ * @param[in] len 式の長さ
+ * @param[out] y 値
+ * @return なし
+ */
+static void
+get_number(const calcnode *np, const char *buf, const size_t len,
+           interval *y)
+{
+    char text[MAX_NUMBER_TEXT];              /* 数値文字列 */
+    numberinfo num = { text, sizeof(text) }; /* 数値文字列構造体 */
+
+    y->lo = y->hi = np->u.val;
+    if (0 <= np->pos && number_scan(buf + np->pos, len - np->pos, &num) &&
+        is_exact(&num, np->u.val))
+        return;
+
+    y->lo = next_down(np->u.val);
+    y->hi = next_up(np->u.val);
+}
+
+/**
+ * 数値が正確に表せるか
+ *
+ * 有効数字が 19 桁以内で, 仮数と 10 のべき乗が正確に表せる場合に,
+ * fma で値と 10 進表記の差を求める.
+ *
+ * @param[in] num 数値文字列構造体
+ * @param[in] val 値(正しく丸めた値)
+ * @retval true 正確
+ */
+static bool
+is_exact(const numberinfo *num, const double val)
+{
+    double mant = 0.0; /* 仮数 */
+    double v = 0.0;    /* 絶対値 */
+
+    if (!num->mant)
+        return true;
+    if (num->hex || 19 < num->ndigit || IV_EXACT_INT < num->mant ||
+        num->exp < -IV_MAX_EXP10 || IV_MAX_EXP10 < num->exp)
+        return false;
+
+    mant = (double)num->mant;
+    v = fabs(val);
+    if (0 <= num->exp) /* v == mant * 10^exp */
+        return v == mant * pow10_exact[num->exp] &&
+            fma(mant, pow10_exact[num->exp], -v) == 0;
+    /* v * 10^-exp == mant */
+    return fma(v, pow10_exact[-num->exp], -mant) == 0;
+}
+
+/**
+ * ノード配列評価
+ *
+ * eval() と同じ順に評価し, エラーになった時点で中断する.
+ * 端点が有限でない場合は倍精度と同じエラーとする.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] code コード
+ * @param[in] buf 式
+ * @param[in] len 式の長さ
+ * @param[out] val 評価用領域(ノード数以上)
+ * @return なし
+ * @attention 計算エラーはerrorcodeに設定される.
+ */
+static void
+eval_interval(calcinfo *calc, const calccode *code, const char *buf,
+              const size_t len, interval *val)
+{
+    const calcnode *np = NULL;           /* ノード */
+    intervalfunc fn = NULL;              /* 関数 */
+    interval *y = NULL;                  /* 結果 */
+    const interval *x = NULL, *z = NULL; /* 被演算子 */
+
+    set_deadline(calc);
+
+    int i;
+    for (i = 0; i < code->size && !is_error(calc); i++) {
+        np = &code->node[i];
+        y = &val[i];
+        x = (0 <= np->lhs) ? &val[np->lhs] : NULL;
+        z = (0 <= np->rhs) ? &val[np->rhs] : NULL;
+
+        switch (np->op) {
+        case OP_NUM:
+            get_number(np, buf, len, y);
+            break;
+        case OP_NEG:
+            y->lo = -x->hi;
+            y->hi = -x->lo;
+            break;
+        case OP_ADD:
+            iv_add(y, x, z);
+            break;
+        case OP_SUB:
+            iv_sub(y, x, z);
+            break;
+        case OP_MUL:
+            iv_mul(y, x, z);
+            break;
+        case OP_DIV:
+            iv_div(calc, y, x, z);
+            break;
+        case OP_POW:
+            iv_pow(calc, y, x, z);
+            break;
+        case OP_FUNC:
+            fn = get_func_interval(np->u.func);
+            if (!fn) { /* 登録関数 */
+                set_errorcode(calc, E_NOFUNC);
+                break;
+            }
+            fn(calc, y, x, z);
+            break;
+        default: /* 変数は使用できない */
+            outlog("op=%d", (int)np->op);
+            set_errorcode(calc, E_SYNTAX);
+            break;
+        }
+
+        if (!is_error(calc) && !(isfinite(y->lo) && isfinite(y->hi)))
+            set_errorcode(calc, (isnan(y->lo) || isnan(y->hi)) ?
+                          E_NAN : E_INFINITY);
+
+        if (calc->deadline && !((i + 1) & (DEADLINE_INTERVAL - 1)))
+            (void)check_deadline(calc);
+    }
+    calc->deadline = 0;
+}
+
+/**
+ * 周期的な点を含むか
+ *
+ * offset + k * period (k は整数)が区間に含まれるかを調べる.
+ * 計算誤差の分だけ広く判定する.
+ *
+ * @param[in] x 区間
+ * @param[in] offset 点
+ * @param[in] period 周期
+ * @retval true 含む(含む可能性がある)
+ */
+static bool
+has_period_point(const interval *x, const double offset, const double period)
+{
+    double lo = (x->lo - offset) / period; /* 下端の周期数 */
+    double hi = (x->hi - offset) / period; /* 上端の周期数 */
+    double eps = (fabs(lo) + fabs(hi) + 1) * IV_PERIOD_EPS; /* 余裕 */
+
+    return ceil(lo - eps) <= floor(hi + eps);
+}
+
+/**
+ * 単調増加な関数
+ *
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] f 関数
+ * @return なし
+ */
+static void
+iv_increasing(interval *y, const interval *x, mathfunc f)
+{
+    double lo = f(x->lo); /* 下端の値 */
+
+    y->hi = widen(x->lo == x->hi ? lo : f(x->hi), IV_ULPS);
+    y->lo = widen(lo, -IV_ULPS);
+}
+
+/**
+ * 一点の整数かどうか
+ *
+ * @param[in] x 区間
+ * @retval true 一点の整数
+ */
+static bool
+is_point_integer(const interval *x)
+{
+    return x->lo == x->hi && isfinite(x->lo) && x->lo == floor(x->lo);
+}
+
+/**
+ * 結果文字列に変換
+ *
+ * 下端は切り捨て, 上端は切り上げで変換する.
+ * printf は丸めモードに従うため, 端点ごとに一度だけ切り替える.
+ *
+ * @param[out] out 出力バッファ
+ * @param[in] size 出力バッファサイズ
+ * @param[in] y 区間
+ * @param[in] digit 有効桁数
+ * @return 文字数(終端を含まない)
+ * @retval EX_NG バッファ不足
+ */
+static int
+format_interval(char *out, const size_t size, const interval *y,
+                const long digit)
+{
+    char lo[MAX_ANSWER], hi[MAX_ANSWER]; /* 端点 */
+    int mode = 0;                        /* 丸めモード */
+    int retval = 0;                      /* 戻り値 */
+
+    mode = fegetround();
+    (void)fesetround(FE_DOWNWARD);
+    retval = calc_format(lo, sizeof(lo), y->lo ? y->lo : 0.0, digit);
+    (void)fesetround(FE_UPWARD);
+    if (0 <= retval)
+        retval = calc_format(hi, sizeof(hi), y->hi ? y->hi : 0.0, digit);
+    (void)fesetround(mode);
+    if (retval < 0) {
+        outlog("calc_format: lo=%g, hi=%g", y->lo, y->hi);
+        return EX_NG;
+    }
+
+    retval = snprintf(out, size, "[%s, %s]", lo, hi);
+    if (retval < 0 || size <= (size_t)retval) {
+        outlog("snprintf: size=%zu, retval=%d", size, retval);
+        return EX_NG;
+    }
+    return retval;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file  calc/interval.h
+ * @brief 区間演算
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2010-2011 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _INTERVAL_H_
+#define _INTERVAL_H_
+
+#include "calc.h"
+
+/** 結果文字列最大長(区間演算, 終端含む) */
+#define MAX_IANSWER (2 * MAX_ANSWER + sizeof("[, ]") - 2)
+
+/** 区間構造体 */
+struct _interval {
+    double lo; /**< 下端 */
+    double hi; /**< 上端 */
+};
+typedef struct _interval interval;
+
+/** 区間演算結果 */
+const unsigned char *calc_answer_interval(calcinfo *calc, const char *buf,
+                                          const size_t len);
+
+/** 区間演算(出力バッファ指定) */
+int calc_eval_interval(calcinfo *calc, calccode *code, const char *buf,
+                       const size_t len, char *out, const size_t size);
+
+/** pi */
+void interval_pi(calcinfo *calc, interval *y, const interval *x,
+                 const interval *z);
+
+/** ネイピア数(オイラー数) */
+void interval_e(calcinfo *calc, interval *y, const interval *x,
+                const interval *z);
+
+/** 絶対値 */
+void interval_abs(calcinfo *calc, interval *y, const interval *x,
+                  const interval *z);
+
+/** 平方根 */
+void interval_sqrt(calcinfo *calc, interval *y, const interval *x,
+                   const interval *z);
+
+/** 三角関数(sin) */
+void interval_sin(calcinfo *calc, interval *y, const interval *x,
+                  const interval *z);
+
+/** 三角関数(cosin) */
+void interval_cos(calcinfo *calc, interval *y, const interval *x,
+                  const interval *z);
+
+/** 三角関数(tangent) */
+void interval_tan(calcinfo *calc, interval *y, const interval *x,
+                  const interval *z);
+
+/** 逆三角関数(arcsin) */
+void interval_asin(calcinfo *calc, interval *y, const interval *x,
+                   const interval *z);
+
+/** 逆三角関数(arccosin) */
+void interval_acos(calcinfo *calc, interval *y, const interval *x,
+                   const interval *z);
+
+/** 逆三角関数(arctangent) */
+void interval_atan(calcinfo *calc, interval *y, const interval *x,
+                   const interval *z);
+
+/** 指数関数 */
+void interval_exp(calcinfo *calc, interval *y, const interval *x,
+                  const interval *z);
+
+/** 自然対数 */
+void interval_ln(calcinfo *calc, interval *y, const interval *x,
+                 const interval *z);
+
+/** 常用対数 */
+void interval_log(calcinfo *calc, interval *y, const interval *x,
+                  const interval *z);
+
+/** 角度をラジアンに変換 */
+void interval_rad(calcinfo *calc, interval *y, const interval *x,
+                  const interval *z);
+
+/** ラジアンを角度に変換 */
+void interval_deg(calcinfo *calc, interval *y, const interval *x,
+                  const interval *z);
+
+/** 階乗 */
+void interval_fact(calcinfo *calc, interval *y, const interval *x,
+                   const interval *z);
+
+/** 順列 */
+void interval_perm(calcinfo *calc, interval *y, const interval *x,
+                   const interval *z);
+
+/** 組み合わせ */
+void interval_comb(calcinfo *calc, interval *y, const interval *x,
+                   const interval *z);
+
+#endif /* _INTERVAL_H_ */
@@ -41,6 +41,7 @@
 #include "log.h"
 #include "term.h"
 #include "calc.h"
+#include "batch.h"
 
 /* 内部変数 */
 static volatile sig_atomic_t sig_handled = 0; /**< シグナル */
@@ -68,7 +69,7 @@ static void sig_handler(int signo);
  *
  * @param[in] argc 引数の数
  * @param[in] argv コマンド引数・オプション引数
- * @return 常にEXIT_SUCCESS
+ * @retval EXIT_FAILURE 一括処理エラー
  */
 int
 main(int argc, char *argv[])
@@ -80,15 +81,22 @@ main(int argc, char *argv[])
     /* シグナルハンドラ */
     set_sig_handler();
 
+    /* オプション引数 */
+    parse_args(argc, argv);
+
+    /* 一括処理 */
+    if (g_bflag) {
+        if (batch_main(g_file, &sig_handled) < 0)
+            exit(EXIT_FAILURE);
+        exit(EXIT_SUCCESS);
+    }
+
     /* バッファリングしない */
     if (setvbuf(stdin, (char *)NULL, _IONBF, 0))
         outlog("setvbuf: stdin");
     if (setvbuf(stdout, (char *)NULL, _IONBF, 0))
         outlog("setvbuf: stdout");
 
-    /* オプション引数 */
-    parse_args(argc, argv);
-
     /* メインループ */
     main_loop();
 
@@ -148,6 +156,11 @@ main_loop(void)
             break;
 
         (void)memset(&calc, 0, sizeof(calcinfo));
+        calc.digit = g_digit;
+        calc.tflag = g_tflag;
+        calc.mpflag = g_mflag;
+        calc.fflag = g_fflag;
+        calc.iflag = g_iflag;
 
         if (!create_answer(&calc, expr)) { /* メモリ不足 */
             outlog("create_calc");
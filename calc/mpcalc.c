@@ -0,0 +1,955 @@
+/**
+ * @file  calc/mpcalc.c
+ * @brief 多倍長計算(GNU MPFR)
+ *
+ * 倍精度と同じ構文解析でノード配列を作り, 各ノードを mpfr_t で評価する.\n
+ * 精度は要求ごとの有効桁数から決める(有効桁数 + ガードビット).
+ * 数値は式中の文字列から直接変換するため, 倍精度に丸めた値は使わない.
+ * 定数畳み込みは倍精度で行われるため, 最適化は行わない.\n
+ * 評価用の mpfr_t とノード配列はスレッドごとに保持して使い回すため,
+ * 同じ精度の計算ではノードごとの領域確保は行わない.\n
+ * 指数範囲は MPFR の既定値であり, 倍精度で範囲エラーになる値も計算できる.
+ * 登録関数は倍精度で計算する.\n
+ * 階乗, 順列, 組み合わせは結果が MP_EXACT_BITS ビット以下であれば
+ * GMP の多倍長整数で厳密に計算し(階乗は素数スイング法の mpz_fac_ui,
+ * 順列は二分割の積, 組み合わせは mpz_bin_uiui), それより大きい場合は
+ * 対数ガンマ関数で有効桁数分だけ近似する.
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2010-2011 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_MPFR
+
+#include <stdlib.h>  /* malloc realloc calloc */
+#include <string.h>  /* memset */
+#include <math.h>    /* signbit log log2 */
+#include <pthread.h> /* pthread_once pthread_key_t */
+#include <mpfr.h>    /* mpfr_t */
+
+#include "timer.h"
+#include "log.h"
+#include "memfree.h"
+#include "error.h"
+#include "func.h"
+#include "calc.h"
+#include "mpcalc.h"
+#include "number.h"
+
+#define MP_GUARD_BITS  32      /**< ガードビット数 */
+#define MP_EXACT_BITS  65536  /**< 多倍長整数で厳密に計算する最大ビット数 */
+#define MP_SPLIT_TERMS 16     /**< 二分割しない最大項数 */
+#define MP_INIT_VALS   16      /**< 評価用領域初期サイズ */
+#define MP_RND         MPFR_RNDN /**< 丸めモード */
+
+/** log2(10) */
+static const double LOG2_10 = 3.32192809488736234787031942948939018;
+
+/** 評価用領域構造体(スレッドごと) */
+struct mppool {
+    mpfr_t *val;      /**< 評価用領域 */
+    int nval;         /**< 確保済みの値の数 */
+    mpfr_prec_t prec; /**< 精度(ビット) */
+    calccode code;    /**< コード(ノード配列を再利用) */
+    char *text;       /**< 数値文字列 */
+    size_t ntext;     /**< 数値文字列領域サイズ */
+};
+
+/* 内部変数 */
+static pthread_once_t poolonce = PTHREAD_ONCE_INIT; /**< 初期化制御 */
+static pthread_key_t poolkey;                       /**< 評価用領域キー */
+static bool poolready = false;                      /**< キー作成済み */
+
+/* 内部関数 */
+/** 評価用領域キー作成 */
+static void create_poolkey(void);
+/** 評価用領域取得 */
+static struct mppool *get_pool(void);
+/** 評価用領域確保 */
+static int reserve_pool(struct mppool *pool, const int nval,
+                        const mpfr_prec_t prec, const size_t ntext);
+/** 評価用領域解放 */
+static void destroy_pool(void *arg);
+/** 数値ノード評価 */
+static void get_number(struct mppool *pool, const calcnode *np,
+                       const char *buf, const size_t len, mpfr_ptr y);
+/** ノード配列評価 */
+static void eval_mp(calcinfo *calc, struct mppool *pool, const char *buf,
+                    const size_t len);
+/** 登録関数評価 */
+static void exec_user(calcinfo *calc, const struct funcinfo *fp,
+                      mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+/** 階乗, 順列, 組み合わせの引数チェック */
+static bool check_terms(calcinfo *calc, mpfr_srcptr x, mpfr_srcptr z);
+/** 連続する整数の積(二分割) */
+static void get_product(mpz_ptr y, const unsigned long lo,
+                        const unsigned long hi);
+/** 対数ガンマ関数による近似 */
+static void get_lngamma(calcinfo *calc, mpfr_ptr y, mpfr_srcptr n,
+                        mpfr_srcptr r, mpfr_srcptr k);
+
+/**
+ * 多倍長計算結果
+ *
+ * 結果文字列が結果文字列バッファに収まらない場合は領域確保する.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] buf 式
+ * @param[in] len 式の長さ
+ * @return 結果文字列ポインタ
+ * @retval NULL エラー
+ * @attention destroy_answerを必ず呼ぶこと.
+ */
+const unsigned char *
+calc_answer_mp(calcinfo *calc, const char *buf, const size_t len)
+{
+    unsigned char *answer = calc->buf;  /* 結果文字列 */
+    size_t size = sizeof(calc->buf);    /* 結果文字列サイズ */
+    int retval = 0;                     /* 戻り値 */
+    unsigned int start = 0;             /* タイマ開始 */
+
+    dbglog("start: len=%zu", len);
+
+    if (size < MAX_MPANSWER(calc_get_digit(calc))) {
+        size = MAX_MPANSWER(calc_get_digit(calc));
+        answer = (unsigned char *)malloc(size);
+        if (!answer) {
+            outlog("malloc: size=%zu", size);
+            return NULL;
+        }
+    }
+
+    if (calc->tflag)
+        start_timer(&start);
+
+    retval = calc_eval_mp(calc, buf, len, (char *)answer, size);
+
+    if (calc->tflag) {
+        unsigned int calc_time = stop_timer(&start);
+        print_timer(calc_time);
+    }
+
+    if (retval < 0 || is_error(calc)) {
+        if (answer != calc->buf)
+            memfree((void **)&answer, NULL);
+        if (!is_error(calc)) /* メモリ不足 */
+            return NULL;
+        calc->answer = get_errormsg(calc);
+        clear_error(calc);
+        return calc->answer;
+    }
+    if (answer != calc->buf)
+        calc->alloc = answer;
+    calc->answer = answer;
+    dbglog("answer=%s", calc->answer);
+    return calc->answer;
+}
+
+/**
+ * 多倍長計算(出力バッファ指定)
+ *
+ * 式を多倍長で評価し, printf の "%.<digit>g" と同じ形式で out に書き込む.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] buf 式
+ * @param[in] len 式の長さ
+ * @param[out] out 出力バッファ
+ * @param[in] size 出力バッファサイズ
+ * @return 文字数(終端を含まない)
+ * @retval EX_NG エラー(errorcodeが設定されていなければメモリ不足)
+ */
+int
+calc_eval_mp(calcinfo *calc, const char *buf, const size_t len,
+             char *out, const size_t size)
+{
+    struct mppool *pool = NULL; /* 評価用領域 */
+    long digit = 0;             /* 有効桁数 */
+    mpfr_prec_t prec = 0;       /* 精度 */
+    int retval = 0;             /* 戻り値 */
+
+    digit = calc_get_digit(calc);
+    prec = (mpfr_prec_t)(digit * LOG2_10) + 1 + MP_GUARD_BITS;
+    dbglog("start: len=%zu, digit=%ld, prec=%ld", len, digit, (long)prec);
+
+    pool = get_pool();
+    if (!pool)
+        return EX_NG;
+
+    if (calc_parse(calc, &pool->code, buf, len) < 0)
+        return EX_NG;
+
+    if (reserve_pool(pool, pool->code.size, prec,
+                     len + 1 + MAX_NUMBER_EXP) < 0)
+        return EX_NG;
+
+    eval_mp(calc, pool, buf, len);
+    if (is_error(calc))
+        return EX_NG;
+
+    retval = mpfr_snprintf(out, size, "%.*Rg", (int)digit,
+                           pool->val[pool->code.size - 1]);
+    if (retval < 0 || size <= (size_t)retval) {
+        outlog("mpfr_snprintf: size=%zu, retval=%d", size, retval);
+        return EX_NG;
+    }
+    return retval;
+}
+
+/**
+ * pi
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 未使用
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+mpcalc_pi(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    (void)mpfr_const_pi(y, MP_RND);
+}
+
+/**
+ * ネイピア数(オイラー数)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 未使用
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+mpcalc_e(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    (void)mpfr_set_ui(y, 1, MP_RND);
+    (void)mpfr_exp(y, y, MP_RND);
+}
+
+/**
+ * 絶対値
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+mpcalc_abs(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    (void)mpfr_abs(y, x, MP_RND);
+}
+
+/**
+ * 平方根
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+mpcalc_sqrt(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    if (mpfr_sgn(x) < 0) { /* 定義域エラー */
+        set_errorcode(calc, E_NAN);
+        return;
+    }
+    (void)mpfr_sqrt(y, x, MP_RND);
+}
+
+/**
+ * 三角関数(sin)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+mpcalc_sin(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    (void)mpfr_sin(y, x, MP_RND);
+}
+
+/**
+ * 三角関数(cosin)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+mpcalc_cos(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    (void)mpfr_cos(y, x, MP_RND);
+}
+
+/**
+ * 三角関数(tangent)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+mpcalc_tan(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    (void)mpfr_tan(y, x, MP_RND);
+}
+
+/**
+ * 逆三角関数(arcsin)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+mpcalc_asin(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    (void)mpfr_asin(y, x, MP_RND);
+}
+
+/**
+ * 逆三角関数(arccosin)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+mpcalc_acos(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    (void)mpfr_acos(y, x, MP_RND);
+}
+
+/**
+ * 逆三角関数(arctangent)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+mpcalc_atan(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    (void)mpfr_atan(y, x, MP_RND);
+}
+
+/**
+ * 指数関数
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+mpcalc_exp(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    (void)mpfr_exp(y, x, MP_RND);
+}
+
+/**
+ * 自然対数
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+mpcalc_ln(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    if (mpfr_sgn(x) < 0) { /* 定義域エラー */
+        set_errorcode(calc, E_NAN);
+        return;
+    }
+    (void)mpfr_log(y, x, MP_RND);
+}
+
+/**
+ * 常用対数
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+mpcalc_log(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    if (mpfr_sgn(x) < 0) { /* 定義域エラー */
+        set_errorcode(calc, E_NAN);
+        return;
+    }
+    (void)mpfr_log10(y, x, MP_RND);
+}
+
+/**
+ * 角度をラジアンに変換
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+mpcalc_rad(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    (void)mpfr_const_pi(y, MP_RND);
+    (void)mpfr_mul(y, x, y, MP_RND);
+    (void)mpfr_div_ui(y, y, 180, MP_RND);
+}
+
+/**
+ * ラジアンを角度に変換
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+mpcalc_deg(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    (void)mpfr_const_pi(y, MP_RND);
+    (void)mpfr_div(y, x, y, MP_RND);
+    (void)mpfr_mul_ui(y, y, 180, MP_RND);
+}
+
+/**
+ * 階乗
+ *
+ * 倍精度と同じく, 負の整数 -n の階乗は -(n!) とする.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x 値
+ * @param[in] z 未使用
+ * @return なし
+ */
+void
+mpcalc_fact(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    mpfr_t n;          /* 絶対値 */
+    double dn = 0.0;   /* 絶対値(倍精度) */
+
+    if (!mpfr_integer_p(x)) { /* 自然数ではない */
+        set_errorcode(calc, E_NAN);
+        return;
+    }
+
+    mpfr_init2(n, mpfr_get_prec(x));
+    (void)mpfr_abs(n, x, MP_RND);
+    dn = mpfr_get_d(n, MP_RND);
+    if (dn * log2(dn + 1) <= MP_EXACT_BITS) { /* 厳密 */
+        mpz_t result;
+        mpz_init(result);
+        mpz_fac_ui(result, (unsigned long)dn);
+        (void)mpfr_set_z(y, result, MP_RND);
+        mpz_clear(result);
+    } else {
+        get_lngamma(calc, y, n, NULL, NULL);
+    }
+    mpfr_clear(n);
+
+    if (mpfr_sgn(x) < 0)
+        (void)mpfr_neg(y, y, MP_RND);
+}
+
+/**
+ * 順列(nPr)
+ *
+ * nPr = n * (n - 1) * ... * (n - r + 1)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x n
+ * @param[in] z r
+ * @return なし
+ */
+void
+mpcalc_perm(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    mpfr_t k;                  /* n - r */
+    double dn = 0.0, dr = 0.0; /* 値(倍精度) */
+
+    if (!check_terms(calc, x, z))
+        return;
+
+    dn = mpfr_get_d(x, MP_RND);
+    dr = mpfr_get_d(z, MP_RND);
+    if (mpfr_fits_ulong_p(x, MP_RND) &&
+        dr * log2(dn + 1) <= MP_EXACT_BITS) { /* 厳密 */
+        mpz_t result;
+        mpz_init_set_ui(result, 1);
+        if (0 < dr)
+            get_product(result, (unsigned long)(dn - dr) + 1,
+                        (unsigned long)dn);
+        (void)mpfr_set_z(y, result, MP_RND);
+        mpz_clear(result);
+        return;
+    }
+
+    if (!isfinite(dn)) { /* 範囲エラー */
+        set_errorcode(calc, E_INFINITY);
+        return;
+    }
+    mpfr_init2(k, (mpfr_prec_t)log2(dn + 1) + 2);
+    (void)mpfr_sub(k, x, z, MP_RND);
+    get_lngamma(calc, y, x, k, NULL);
+    mpfr_clear(k);
+}
+
+/**
+ * 組み合わせ(nCr)
+ *
+ * nCr = n * (n - 1) * ... * (n - k + 1) / k!, k = min(r, n - r)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] x n
+ * @param[in] z r
+ * @return なし
+ */
+void
+mpcalc_comb(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z)
+{
+    mpfr_t k;                  /* n - r */
+    double dn = 0.0, dk = 0.0; /* 値(倍精度) */
+
+    if (!check_terms(calc, x, z))
+        return;
+
+    dn = mpfr_get_d(x, MP_RND);
+    if (!isfinite(dn)) { /* 範囲エラー */
+        set_errorcode(calc, E_INFINITY);
+        return;
+    }
+    mpfr_init2(k, (mpfr_prec_t)log2(dn + 1) + 2);
+    (void)mpfr_sub(k, x, z, MP_RND);
+    dk = mpfr_get_d(0 < mpfr_cmp(k, z) ? z : k, MP_RND);
+    if (mpfr_fits_ulong_p(x, MP_RND) &&
+        dk * log2(dn + 1) <= MP_EXACT_BITS) { /* 厳密 */
+        mpz_t result;
+        mpz_init(result);
+        mpz_bin_uiui(result, (unsigned long)dn, (unsigned long)dk);
+        (void)mpfr_set_z(y, result, MP_RND);
+        mpz_clear(result);
+    } else {
+        get_lngamma(calc, y, x, k, z);
+    }
+    mpfr_clear(k);
+}
+
+/**
+ * 評価用領域キー作成
+ *
+ * @return なし
+ */
+static void
+create_poolkey(void)
+{
+    if (pthread_key_create(&poolkey, destroy_pool)) {
+        outlog("pthread_key_create");
+        return;
+    }
+    poolready = true;
+}
+
+/**
+ * 評価用領域取得
+ *
+ * 呼び出したスレッドの評価用領域を返す. なければ作成する.
+ *
+ * @return 評価用領域
+ * @retval NULL メモリ不足
+ */
+static struct mppool *
+get_pool(void)
+{
+    struct mppool *pool = NULL; /* 評価用領域 */
+
+    (void)pthread_once(&poolonce, create_poolkey);
+    if (!poolready)
+        return NULL;
+
+    pool = (struct mppool *)pthread_getspecific(poolkey);
+    if (pool)
+        return pool;
+
+    pool = (struct mppool *)calloc(1, sizeof(struct mppool));
+    if (!pool) {
+        outlog("calloc: size=%zu", sizeof(struct mppool));
+        return NULL;
+    }
+    if (pthread_setspecific(poolkey, pool)) {
+        outlog("pthread_setspecific");
+        memfree((void **)&pool, NULL);
+        return NULL;
+    }
+    return pool;
+}
+
+/**
+ * 評価用領域確保
+ *
+ * 値の数が足りない場合だけ拡張する. 精度が変わった場合は確保済みの
+ * 値の精度を変更する.
+ *
+ * @param[in,out] pool 評価用領域
+ * @param[in] nval 値の数
+ * @param[in] prec 精度
+ * @param[in] ntext 数値文字列領域サイズ
+ * @retval EX_NG メモリ不足
+ */
+static int
+reserve_pool(struct mppool *pool, const int nval, const mpfr_prec_t prec,
+             const size_t ntext)
+{
+    mpfr_t *val = NULL; /* 評価用領域 */
+    char *text = NULL;  /* 数値文字列 */
+    int n = 0;          /* 確保する値の数 */
+
+    if (pool->prec != prec) {
+        int i;
+        for (i = 0; i < pool->nval; i++)
+            mpfr_set_prec(pool->val[i], prec);
+        pool->prec = prec;
+    }
+
+    if (pool->nval < nval) {
+        n = pool->nval ? pool->nval : MP_INIT_VALS;
+        while (n < nval)
+            n *= 2;
+        val = (mpfr_t *)realloc(pool->val, n * sizeof(mpfr_t));
+        if (!val) {
+            outlog("realloc: nval=%d", n);
+            return EX_NG;
+        }
+        pool->val = val;
+        while (pool->nval < n)
+            mpfr_init2(pool->val[pool->nval++], prec);
+    }
+
+    if (pool->ntext < ntext) {
+        text = (char *)realloc(pool->text, ntext);
+        if (!text) {
+            outlog("realloc: ntext=%zu", ntext);
+            return EX_NG;
+        }
+        pool->text = text;
+        pool->ntext = ntext;
+    }
+    return EX_OK;
+}
+
+/**
+ * 評価用領域解放
+ *
+ * スレッド終了時に呼ばれる.
+ *
+ * @param[in] arg 評価用領域
+ * @return なし
+ */
+static void
+destroy_pool(void *arg)
+{
+    struct mppool *pool = (struct mppool *)arg; /* 評価用領域 */
+
+    int i;
+    for (i = 0; i < pool->nval; i++)
+        mpfr_clear(pool->val[i]);
+    memfree((void **)&pool->val, (void **)&pool->text,
+            (void **)&pool->code.node, (void **)&pool, NULL);
+    mpfr_free_cache();
+}
+
+/**
+ * 数値ノード評価
+ *
+ * number() と同じ number_scan() で式中の数値を読み, 文字列から直接変換する.
+ *
+ * @param[in] pool 評価用領域
+ * @param[in] np ノード
+ * @param[in] buf 式
+ * @param[in] len 式の長さ
+ * @param[out] y 値
+ * @return なし
+ */
+static void
+get_number(struct mppool *pool, const calcnode *np, const char *buf,
+           const size_t len, mpfr_ptr y)
+{
+    numberinfo num = { pool->text, pool->ntext }; /* 数値文字列構造体 */
+
+    if (np->pos < 0 ||
+        !number_scan(buf + np->pos, len - np->pos, &num)) { /* 位置なし */
+        (void)mpfr_set_d(y, np->u.val, MP_RND);
+        return;
+    }
+
+    (void)mpfr_strtofr(y, pool->text, NULL, 0, MP_RND);
+    if (signbit(np->u.val)) /* 単項マイナス */
+        (void)mpfr_neg(y, y, MP_RND);
+}
+
+/**
+ * ノード配列評価
+ *
+ * eval() と同じ順に評価し, エラーになった時点で中断する.
+ * 評価の期限は関数の後と DEADLINE_INTERVAL ノードごとに確認する.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in,out] pool 評価用領域
+ * @param[in] buf 式
+ * @param[in] len 式の長さ
+ * @return なし
+ * @attention 計算エラーはerrorcodeに設定される.
+ */
+static void
+eval_mp(calcinfo *calc, struct mppool *pool, const char *buf,
+        const size_t len)
+{
+    const calccode *code = &pool->code; /* コード */
+    const calcnode *np = NULL;          /* ノード */
+    mpfrfunc fn = NULL;                 /* 関数 */
+    mpfr_ptr y = NULL;                  /* 結果 */
+    mpfr_srcptr x = NULL, z = NULL;     /* 被演算子 */
+
+    set_deadline(calc);
+
+    int i;
+    for (i = 0; i < code->size && !is_error(calc); i++) {
+        np = &code->node[i];
+        y = pool->val[i];
+        x = (0 <= np->lhs) ? pool->val[np->lhs] : NULL;
+        z = (0 <= np->rhs) ? pool->val[np->rhs] : NULL;
+
+        switch (np->op) {
+        case OP_NUM:
+            get_number(pool, np, buf, len, y);
+            break;
+        case OP_NEG:
+            (void)mpfr_neg(y, x, MP_RND);
+            break;
+        case OP_ADD:
+            (void)mpfr_add(y, x, z, MP_RND);
+            break;
+        case OP_SUB:
+            (void)mpfr_sub(y, x, z, MP_RND);
+            break;
+        case OP_MUL:
+            (void)mpfr_mul(y, x, z, MP_RND);
+            break;
+        case OP_DIV:
+            if (mpfr_zero_p(z)) { /* ゼロ除算エラー */
+                set_errorcode(calc, E_DIVBYZERO);
+                break;
+            }
+            (void)mpfr_div(y, x, z, MP_RND);
+            break;
+        case OP_POW:
+            if (mpfr_zero_p(x) && mpfr_sgn(z) < 0) { /* 定義域エラー */
+                set_errorcode(calc, E_NAN);
+                break;
+            }
+            (void)mpfr_pow(y, x, z, MP_RND);
+            break;
+        case OP_FUNC:
+            fn = get_func_mpfr(np->u.func);
+            if (fn)
+                fn(calc, y, x, z);
+            else
+                exec_user(calc, np->u.func, y, x, z);
+            break;
+        default: /* 変数は使用できない */
+            outlog("op=%d", (int)np->op);
+            set_errorcode(calc, E_SYNTAX);
+            break;
+        }
+
+        if (!is_error(calc) && !mpfr_number_p(y))
+            set_errorcode(calc, mpfr_nan_p(y) ? E_NAN : E_INFINITY);
+
+        if (calc->deadline && (np->op == OP_FUNC ||
+                               !((i + 1) & (DEADLINE_INTERVAL - 1))))
+            (void)check_deadline(calc);
+    }
+    calc->deadline = 0;
+}
+
+/**
+ * 登録関数評価
+ *
+ * 引数を倍精度に変換して登録関数を呼ぶ.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] fp 関数情報
+ * @param[out] y 結果
+ * @param[in] x 第一引数(NULL可)
+ * @param[in] z 第二引数(NULL可)
+ * @return なし
+ */
+static void
+exec_user(calcinfo *calc, const struct funcinfo *fp, mpfr_ptr y,
+          mpfr_srcptr x, mpfr_srcptr z)
+{
+    double args[MAX_FUNC_ARGS]; /* 引数 */
+    double val = 0.0;           /* 値 */
+
+    args[0] = x ? mpfr_get_d(x, MP_RND) : 0.0;
+    args[1] = z ? mpfr_get_d(z, MP_RND) : 0.0;
+
+    clear_math_feexcept();
+    val = exec_func(calc, fp, args);
+    (void)mpfr_set_d(y, val, MP_RND);
+}
+
+/**
+ * 階乗, 順列, 組み合わせの引数チェック
+ *
+ * 負数, 整数でない場合および n < r の場合は定義域エラーとする.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] x n
+ * @param[in] z r
+ * @retval false エラー
+ */
+static bool
+check_terms(calcinfo *calc, mpfr_srcptr x, mpfr_srcptr z)
+{
+    if (mpfr_sgn(x) < 0 || mpfr_sgn(z) < 0 ||
+        mpfr_cmp(x, z) < 0) { /* 定義域エラー */
+        set_errorcode(calc, E_NAN);
+        return false;
+    }
+    if (!mpfr_integer_p(x) || !mpfr_integer_p(z)) {
+        set_errorcode(calc, E_NAN);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * 連続する整数の積(二分割)
+ *
+ * lo * (lo + 1) * ... * hi を求める.\n
+ * 大きさの近い数同士を掛けるように二分割することで,
+ * GMP の高速な乗算が使われるようにする.
+ *
+ * @param[out] y 結果
+ * @param[in] lo 最小値
+ * @param[in] hi 最大値(lo 以上)
+ * @return なし
+ */
+static void
+get_product(mpz_ptr y, const unsigned long lo, const unsigned long hi)
+{
+    mpz_t t;               /* 上半分の積 */
+    unsigned long mid = 0; /* 分割位置 */
+
+    if (hi - lo < MP_SPLIT_TERMS) {
+        mpz_set_ui(y, lo);
+        unsigned long i;
+        for (i = lo + 1; i <= hi; i++)
+            mpz_mul_ui(y, y, i);
+        return;
+    }
+
+    mid = lo + (hi - lo) / 2;
+    mpz_init(t);
+    get_product(y, lo, mid);
+    get_product(t, mid + 1, hi);
+    mpz_mul(y, y, t);
+    mpz_clear(t);
+}
+
+/**
+ * 対数ガンマ関数による近似
+ *
+ * y = exp(lngamma(n + 1) - lngamma(r + 1) - lngamma(k + 1))\n
+ * 引き算による桁落ちの分だけ精度を上げて計算する.
+ * 指数範囲を超える場合は無限大となり, 範囲エラーとなる.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[out] y 結果
+ * @param[in] n 値
+ * @param[in] r 値(NULLは省略)
+ * @param[in] k 値(NULLは省略)
+ * @return なし
+ */
+static void
+get_lngamma(calcinfo *calc, mpfr_ptr y, mpfr_srcptr n, mpfr_srcptr r,
+            mpfr_srcptr k)
+{
+    mpfr_t sum, t;         /* 値 */
+    double dn = 0.0;       /* n(倍精度) */
+    mpfr_prec_t prec = 0;  /* 精度 */
+
+    dn = mpfr_get_d(n, MP_RND) + 1;
+    if (!isfinite(dn * log(dn))) { /* 範囲エラー */
+        set_errorcode(calc, E_INFINITY);
+        return;
+    }
+    prec = mpfr_get_prec(y) + (mpfr_prec_t)log2(dn * log(dn) + 1) +
+        MP_GUARD_BITS;
+    dbglog("prec=%ld", (long)prec);
+
+    mpfr_init2(sum, prec);
+    mpfr_init2(t, prec);
+    (void)mpfr_add_ui(sum, n, 1, MP_RND);
+    (void)mpfr_lngamma(sum, sum, MP_RND);
+    if (r) {
+        (void)mpfr_add_ui(t, r, 1, MP_RND);
+        (void)mpfr_lngamma(t, t, MP_RND);
+        (void)mpfr_sub(sum, sum, t, MP_RND);
+    }
+    if (k) {
+        (void)mpfr_add_ui(t, k, 1, MP_RND);
+        (void)mpfr_lngamma(t, t, MP_RND);
+        (void)mpfr_sub(sum, sum, t, MP_RND);
+    }
+    (void)mpfr_exp(y, sum, MP_RND);
+    mpfr_clear(t);
+    mpfr_clear(sum);
+}
+
+#endif /* HAVE_MPFR */
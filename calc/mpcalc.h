@@ -0,0 +1,99 @@
+/**
+ * @file  calc/mpcalc.h
+ * @brief 多倍長計算(GNU MPFR)
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2010-2011 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _MPCALC_H_
+#define _MPCALC_H_
+
+#ifdef HAVE_MPFR
+
+#include <mpfr.h> /* mpfr_t */
+
+#include "calc.h"
+
+/** 多倍長計算結果 */
+const unsigned char *calc_answer_mp(calcinfo *calc, const char *buf,
+                                    const size_t len);
+
+/** 多倍長計算(出力バッファ指定) */
+int calc_eval_mp(calcinfo *calc, const char *buf, const size_t len,
+                 char *out, const size_t size);
+
+/** pi */
+void mpcalc_pi(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** ネイピア数(オイラー数) */
+void mpcalc_e(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** 絶対値 */
+void mpcalc_abs(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** 平方根 */
+void mpcalc_sqrt(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** 三角関数(sin) */
+void mpcalc_sin(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** 三角関数(cosin) */
+void mpcalc_cos(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** 三角関数(tangent) */
+void mpcalc_tan(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** 逆三角関数(arcsin) */
+void mpcalc_asin(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** 逆三角関数(arccosin) */
+void mpcalc_acos(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** 逆三角関数(arctangent) */
+void mpcalc_atan(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** 指数関数 */
+void mpcalc_exp(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** 自然対数 */
+void mpcalc_ln(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** 常用対数 */
+void mpcalc_log(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** 角度をラジアンに変換 */
+void mpcalc_rad(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** ラジアンを角度に変換 */
+void mpcalc_deg(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** 階乗 */
+void mpcalc_fact(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** 順列(nPr) */
+void mpcalc_perm(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+/** 組み合わせ(nCr) */
+void mpcalc_comb(calcinfo *calc, mpfr_ptr y, mpfr_srcptr x, mpfr_srcptr z);
+
+#endif /* HAVE_MPFR */
+
+#endif /* _MPCALC_H_ */
@@ -0,0 +1,566 @@
+/**
+ * @file  calc/number.c
+ * @brief 数値文字列の変換
+ *
+ * 式中の数値を走査し, 空白と桁区切り(_)を除いた文字列に正規化する.
+ * 倍精度と多倍長計算は同じ走査結果を使う.\n
+ * 使える書式は次のとおり.
+ * - 10進数: 123, 1.5, 1.5e-3, 1_000_000
+ * - 16進浮動小数点: 0x1f, 0x1.8p3
+ *
+ * 10進数は有効数字と10進指数に分け, 有効数字が 2^53 以下で
+ * 指数が小さい場合は 10 の累乗との一回の乗除算で正しく丸めた値を求める
+ * (Clinger の高速経路). 有効数字 19 桁, 指数 27 までは拡張精度で計算し,
+ * 倍精度への丸めが確定する場合はその値を使う.
+ * それ以外は strtod() で変換する.
+ * MAX_NUMBER_DIGIT 桁を超える有効数字は切り捨て, 0 以外の桁があれば
+ * 末尾に 1 を加えることで丸めの向きを保つ.
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2010-2011 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdlib.h> /* strtod */
+#include <string.h> /* memcpy */
+#include <float.h>  /* LDBL_MANT_DIG */
+
+#include "log.h"
+#include "number.h"
+
+#define NUMBER_MANT_DIGIT  19            /**< 仮数に保持する桁数 */
+#define NUMBER_FAST_EXP    22            /**< 正確に表せる 10 の累乗の最大 */
+#define NUMBER_FAST_MANT   (1ULL << 53)  /**< 正確に表せる整数の最大 */
+#define NUMBER_EXP_LIMIT   999999999L    /**< 指数の読み取り上限 */
+#define NUMBER_LDBL_EXP    27            /**< 拡張精度で正確な 10 の累乗の最大 */
+
+/*
+ * 文字種判定. ctype.h の関数はロケール表を引くため,
+ * 一文字ごとに呼ぶと変換より時間がかかる.
+ */
+/** 10進数字 */
+#define IS_DIGIT(c)  ((unsigned int)(c) - '0' < 10U)
+/** 16進数字 */
+#define IS_XDIGIT(c) (IS_DIGIT(c) || (unsigned int)((c) | 0x20) - 'a' < 6U)
+/** 空白(readch() と同じく空白とタブ) */
+#define IS_BLANK(c)  ((c) == ' ' || (c) == '\t')
+
+/* 内部変数 */
+/** 10 の累乗(倍精度で正確に表せる範囲) */
+static const double pow10tab[NUMBER_FAST_EXP + 1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#if LDBL_MANT_DIG == 64
+/** 10 の累乗(拡張精度で正確に表せる範囲) */
+static const long double pow10ldbl[NUMBER_LDBL_EXP + 1] = {
+    1e0L,  1e1L,  1e2L,  1e3L,  1e4L,  1e5L,  1e6L,  1e7L,
+    1e8L,  1e9L,  1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L,
+    1e16L, 1e17L, 1e18L, 1e19L, 1e20L, 1e21L, 1e22L, 1e23L,
+    1e24L, 1e25L, 1e26L, 1e27L
+};
+#endif /* LDBL_MANT_DIG == 64 */
+
+/* 内部関数 */
+/** 文字取得(空白は読み飛ばす) */
+static int peek_char(const char *buf, const size_t len, size_t *pos);
+/** 16進浮動小数点かどうか */
+static bool is_hex(const char *buf, const size_t len, size_t pos);
+/** 10進数の走査 */
+static size_t scan_decimal(const char *buf, const size_t len, size_t pos,
+                           numberinfo *num);
+/** 16進浮動小数点の走査 */
+static size_t scan_hex(const char *buf, const size_t len, size_t pos,
+                       numberinfo *num);
+/** 10進数の数字列の走査 */
+static bool scan_digits(const char *buf, const size_t len, size_t *pos,
+                        numberinfo *num, const bool frac, bool *sticky);
+/** 16進数の数字列の走査 */
+static bool scan_xdigits(const char *buf, const size_t len, size_t *pos,
+                         numberinfo *num, size_t *n);
+/** 指数の走査 */
+static int scan_exp(const char *buf, const size_t len, size_t *pos,
+                    long *exp);
+/** 指数の書き込み */
+static void put_exp(char *buf, const int mark, const long exp);
+/** 拡張精度による変換 */
+static bool convert_ldbl(const uint64_t mant, const long exp, double *val);
+
+/**
+ * 数値文字列の走査
+ *
+ * buf の先頭から数値を読み取り, num->text に正規化した文字列を設定する.
+ * 10進数は "有効数字e指数", 16進浮動小数点は "0x仮数p指数" となり,
+ * strtod() と mpfr_strtofr() でそのまま変換できる.\n
+ * 空白は readch() と同じく読み飛ばす. 桁区切りの _ は数字の間にだけ
+ * 置ける. 数値に続かない e, p は読み取らない.
+ *
+ * @param[in] buf 文字列(先頭は数字)
+ * @param[in] len 文字列長(終端文字でも終わる)
+ * @param[in,out] num 数値文字列構造体(text, size を設定しておく)
+ * @return 読み取った文字数
+ * @retval 0 文法エラー
+ * @attention 倍精度で正しく丸めるには size を MAX_NUMBER_TEXT 以上にすること.
+ */
+size_t
+number_scan(const char *buf, const size_t len, numberinfo *num)
+{
+    size_t pos = 0; /* 位置 */
+    int c = 0;      /* 文字 */
+
+    dbglog("start");
+
+    num->mant = 0;
+    num->ndigit = 0;
+    num->exp = 0;
+    num->hex = false;
+    if (num->size < 2 + MAX_NUMBER_EXP)
+        return 0;
+
+    c = peek_char(buf, len, &pos);
+    if (!IS_DIGIT(c))
+        return 0;
+
+    if (c == '0' && is_hex(buf, len, pos))
+        return scan_hex(buf, len, pos, num);
+    return scan_decimal(buf, len, pos, num);
+}
+
+/**
+ * 数値文字列を倍精度に変換
+ *
+ * @param[in] num 数値文字列構造体(number_scan() の結果)
+ * @return 値
+ */
+double
+number_to_double(const numberinfo *num)
+{
+    uint64_t mant = num->mant; /* 仮数 */
+    long exp = num->exp;       /* 指数 */
+    double val = 0.0;          /* 値 */
+
+    if (num->hex || NUMBER_MANT_DIGIT < num->ndigit)
+        return strtod(num->text, NULL);
+    if (!num->ndigit)
+        return 0.0;
+
+    if (mant <= NUMBER_FAST_MANT) {
+        if (0 <= exp && exp <= NUMBER_FAST_EXP)
+            return (double)mant * pow10tab[exp];
+        if (-NUMBER_FAST_EXP <= exp && exp < 0)
+            return (double)mant / pow10tab[-exp];
+
+        /* 仮数に 10 を掛けても正確な範囲であれば指数を移す */
+        if (NUMBER_FAST_EXP < exp) {
+            while (NUMBER_FAST_EXP < exp && mant <= NUMBER_FAST_MANT / 10) {
+                mant *= 10;
+                exp--;
+            }
+            if (exp <= NUMBER_FAST_EXP)
+                return (double)mant * pow10tab[exp];
+        }
+    }
+
+    if (convert_ldbl(num->mant, num->exp, &val))
+        return val;
+    return strtod(num->text, NULL);
+}
+
+/**
+ * 文字取得(空白は読み飛ばす)
+ *
+ * @param[in] buf 文字列
+ * @param[in] len 文字列長
+ * @param[in,out] pos 位置(空白の後に進む)
+ * @return 文字
+ * @retval '\0' 終端
+ */
+static int
+peek_char(const char *buf, const size_t len, size_t *pos)
+{
+    while (*pos < len && IS_BLANK(buf[*pos]))
+        (*pos)++;
+    return (*pos < len) ? (unsigned char)buf[*pos] : '\0';
+}
+
+/**
+ * 16進浮動小数点かどうか
+ *
+ * 0x の後に16進数字, または小数点と16進数字が続く場合に真.
+ *
+ * @param[in] buf 文字列
+ * @param[in] len 文字列長
+ * @param[in] pos 0 の位置
+ * @retval true 16進浮動小数点
+ */
+static bool
+is_hex(const char *buf, const size_t len, size_t pos)
+{
+    int c = 0; /* 文字 */
+
+    pos++;
+    c = peek_char(buf, len, &pos);
+    if (c != 'x' && c != 'X')
+        return false;
+    pos++;
+    c = peek_char(buf, len, &pos);
+    if (c == '.') {
+        pos++;
+        c = peek_char(buf, len, &pos);
+    }
+    return IS_XDIGIT(c);
+}
+
+/**
+ * 10進数の走査
+ *
+ * @param[in] buf 文字列
+ * @param[in] len 文字列長
+ * @param[in] pos 先頭の数字の位置
+ * @param[in,out] num 数値文字列構造体
+ * @return 読み取った文字数
+ * @retval 0 文法エラー
+ */
+static size_t
+scan_decimal(const char *buf, const size_t len, size_t pos, numberinfo *num)
+{
+    bool sticky = false; /* 切り捨てた桁に 0 以外がある */
+    long exp = 0;        /* 指数 */
+    int retval = 0;      /* 戻り値 */
+
+    if (!scan_digits(buf, len, &pos, num, false, &sticky))
+        return 0;
+
+    if (peek_char(buf, len, &pos) == '.') { /* 小数 */
+        pos++;
+        if (!scan_digits(buf, len, &pos, num, true, &sticky))
+            return 0;
+    }
+
+    if (peek_char(buf, len, &pos) == 'e' ||
+        peek_char(buf, len, &pos) == 'E') { /* 指数 */
+        retval = scan_exp(buf, len, &pos, &exp);
+        if (retval < 0)
+            return 0;
+        num->exp += exp;
+    }
+
+    if (sticky) { /* 丸めの向きを保つ */
+        num->text[num->ndigit++] = '1';
+        num->mant = num->mant * 10 + 1;
+        num->exp--;
+    }
+    if (!num->ndigit) {
+        num->text[0] = '0';
+        num->text[1] = '\0';
+    } else {
+        put_exp(num->text + num->ndigit, 'e', num->exp);
+    }
+    dbglog("text=%s, mant=%lu, exp=%ld", num->text,
+           (unsigned long)num->mant, num->exp);
+    return pos;
+}
+
+/**
+ * 16進浮動小数点の走査
+ *
+ * 数値文字列領域に収まらない場合は文法エラーとする.
+ *
+ * @param[in] buf 文字列
+ * @param[in] len 文字列長
+ * @param[in] pos 0 の位置
+ * @param[in,out] num 数値文字列構造体
+ * @return 読み取った文字数
+ * @retval 0 文法エラー
+ */
+static size_t
+scan_hex(const char *buf, const size_t len, size_t pos, numberinfo *num)
+{
+    size_t n = 0;   /* 文字数 */
+    long exp = 0;   /* 指数 */
+    int retval = 0; /* 戻り値 */
+
+    num->hex = true;
+    num->text[n++] = '0';
+    num->text[n++] = 'x';
+    pos++;
+    (void)peek_char(buf, len, &pos);
+    pos++; /* x */
+
+    if (!scan_xdigits(buf, len, &pos, num, &n))
+        return 0;
+
+    if (peek_char(buf, len, &pos) == '.') { /* 小数 */
+        pos++;
+        num->text[n++] = '.';
+        if (!scan_xdigits(buf, len, &pos, num, &n))
+            return 0;
+    }
+
+    if (peek_char(buf, len, &pos) == 'p' ||
+        peek_char(buf, len, &pos) == 'P') { /* 指数 */
+        retval = scan_exp(buf, len, &pos, &exp);
+        if (retval < 0)
+            return 0;
+    }
+    if (num->size - n < MAX_NUMBER_EXP)
+        return 0;
+
+    put_exp(num->text + n, 'p', exp);
+    num->ndigit = (int)n;
+    dbglog("text=%s", num->text);
+    return pos;
+}
+
+/**
+ * 10進数の数字列の走査
+ *
+ * 先頭の 0 は有効数字に含めない.
+ * 領域に収まらない桁は指数に繰り入れて切り捨てる.\n
+ * 数値ごとに呼ばれるため, 構造体のメンバは局所変数に写して走査する.
+ *
+ * @param[in] buf 文字列
+ * @param[in] len 文字列長
+ * @param[in,out] pos 位置
+ * @param[in,out] num 数値文字列構造体
+ * @param[in] frac 小数部
+ * @param[in,out] sticky 切り捨てた桁に 0 以外がある
+ * @retval false 桁区切りの後に数字がない
+ */
+static bool
+scan_digits(const char *buf, const size_t len, size_t *pos,
+            numberinfo *num, const bool frac, bool *sticky)
+{
+    char *text = num->text;                           /* 数値文字列 */
+    size_t cap = num->size - 1 - MAX_NUMBER_EXP;      /* 有効数字の最大 */
+    size_t ndigit = (size_t)num->ndigit;              /* 有効数字の桁数 */
+    uint64_t mant = num->mant;                        /* 仮数 */
+    long exp = num->exp;                              /* 指数 */
+    size_t i = *pos;                                  /* 位置 */
+    bool digit = false;                               /* 直前が数字 */
+    bool retval = true;                               /* 戻り値 */
+    int c = 0;                                        /* 文字 */
+
+    while (true) {
+        c = (i < len) ? (unsigned char)buf[i] : '\0';
+        if (IS_DIGIT(c)) {
+            if (ndigit < cap) {
+                if (ndigit || c != '0') { /* 先頭の 0 以外 */
+                    text[ndigit++] = (char)c;
+                    if (ndigit <= NUMBER_MANT_DIGIT)
+                        mant = mant * 10 + (uint64_t)(c - '0');
+                }
+                if (frac)
+                    exp--;
+            } else { /* 切り捨て */
+                if (!frac)
+                    exp++;
+                if (c != '0')
+                    *sticky = true;
+            }
+            digit = true;
+        } else if (IS_BLANK(c)) {
+            /* 読み飛ばす */
+        } else if (c == '_' && digit) { /* 桁区切り */
+            i++;
+            c = peek_char(buf, len, &i);
+            if (!IS_DIGIT(c)) {
+                retval = false;
+                break;
+            }
+            continue;
+        } else {
+            break;
+        }
+        i++;
+    }
+
+    num->ndigit = (int)ndigit;
+    num->mant = mant;
+    num->exp = exp;
+    *pos = i;
+    return retval;
+}
+
+/**
+ * 16進数の数字列の走査
+ *
+ * @param[in] buf 文字列
+ * @param[in] len 文字列長
+ * @param[in,out] pos 位置
+ * @param[in,out] num 数値文字列構造体
+ * @param[in,out] n 数値文字列の文字数
+ * @retval false 桁区切りの後に数字がない, または領域不足
+ */
+static bool
+scan_xdigits(const char *buf, const size_t len, size_t *pos,
+             numberinfo *num, size_t *n)
+{
+    bool digit = false; /* 直前が数字 */
+    int c = 0;          /* 文字 */
+
+    while (true) {
+        c = peek_char(buf, len, pos);
+        if (IS_XDIGIT(c)) {
+            if (num->size - MAX_NUMBER_EXP <= *n) /* 領域不足 */
+                return false;
+            num->text[(*n)++] = (char)c;
+            digit = true;
+        } else if (c == '_' && digit) { /* 桁区切り */
+            (*pos)++;
+            c = peek_char(buf, len, pos);
+            if (!IS_XDIGIT(c))
+                return false;
+            continue;
+        } else {
+            break;
+        }
+        (*pos)++;
+    }
+    return true;
+}
+
+/**
+ * 指数の走査
+ *
+ * 指数記号(e または p)の後に符号と数字が続く場合だけ読み取る.
+ * 指数の絶対値は NUMBER_EXP_LIMIT で打ち切る.
+ *
+ * @param[in] buf 文字列
+ * @param[in] len 文字列長
+ * @param[in,out] pos 指数記号の位置(読み取った場合は指数の後)
+ * @param[out] exp 指数
+ * @retval 1 読み取った
+ * @retval 0 指数ではない
+ * @retval -1 桁区切りの後に数字がない
+ */
+static int
+scan_exp(const char *buf, const size_t len, size_t *pos, long *exp)
+{
+    size_t next = *pos + 1; /* 位置 */
+    long sign = 1;          /* 符号 */
+    long val = 0;           /* 値 */
+    int c = 0;              /* 文字 */
+
+    c = peek_char(buf, len, &next);
+    if (c == '+' || c == '-') {
+        sign = (c == '-') ? -1 : 1;
+        next++;
+        c = peek_char(buf, len, &next);
+    }
+    if (!IS_DIGIT(c)) /* 指数ではない */
+        return 0;
+
+    while (true) {
+        c = peek_char(buf, len, &next);
+        if (IS_DIGIT(c)) {
+            val = val * 10 + (c - '0');
+            if (NUMBER_EXP_LIMIT < val)
+                val = NUMBER_EXP_LIMIT;
+        } else if (c == '_') { /* 桁区切り */
+            next++;
+            if (!IS_DIGIT(peek_char(buf, len, &next)))
+                return -1;
+            continue;
+        } else {
+            break;
+        }
+        next++;
+    }
+
+    *exp = sign * val;
+    *pos = next;
+    return 1;
+}
+
+/**
+ * 指数の書き込み
+ *
+ * @param[out] buf 書き込み先(MAX_NUMBER_EXP 以上)
+ * @param[in] mark 指数記号
+ * @param[in] exp 指数
+ * @return なし
+ */
+static void
+put_exp(char *buf, const int mark, const long exp)
+{
+    char digit[MAX_NUMBER_EXP];                  /* 数字(逆順) */
+    unsigned long val = (unsigned long)exp;      /* 絶対値 */
+    size_t n = 0;                                /* 桁数 */
+
+    *buf++ = (char)mark;
+    if (exp < 0) {
+        *buf++ = '-';
+        val = 0 - val;
+    }
+    do {
+        digit[n++] = (char)('0' + val % 10);
+        val /= 10;
+    } while (val);
+    while (n)
+        *buf++ = digit[--n];
+    *buf = '\0';
+}
+
+/**
+ * 拡張精度による変換
+ *
+ * 有効数字 19 桁までの仮数は x87 拡張精度(仮数 64 ビット)で正確に表せる.
+ * 10 の累乗も 10^27 までは正確なため, 一回の乗除算の誤差は拡張精度の
+ * 0.5 ULP 以内である. 倍精度への丸めが二重丸めにならないのは,
+ * 拡張精度の結果が倍精度の中間点から 1 ULP 以上離れている場合に限る.
+ * それ以外は偽を返し, strtod() で変換する.
+ *
+ * @param[in] mant 仮数
+ * @param[in] exp 10進指数
+ * @param[out] val 値
+ * @retval false 変換できない
+ */
+static bool
+convert_ldbl(const uint64_t mant, const long exp, double *val)
+{
+#if LDBL_MANT_DIG == 64
+    long double x = 0.0L; /* 値 */
+    uint64_t bits = 0;    /* 拡張精度の仮数 */
+    uint64_t low = 0;     /* 倍精度で丸められる下位 11 ビット */
+
+    if (exp < -NUMBER_LDBL_EXP || NUMBER_LDBL_EXP < exp)
+        return false;
+
+    if (exp < 0)
+        x = (long double)mant / pow10ldbl[-exp];
+    else
+        x = (long double)mant * pow10ldbl[exp];
+
+    (void)memcpy(&bits, &x, sizeof(bits));
+    low = bits & 0x7ff;
+    if (0x3ff <= low && low <= 0x401) /* 中間点の近く */
+        return false;
+
+    *val = (double)x;
+    return true;
+#else
+    (void)mant;
+    (void)exp;
+    (void)val;
+    return false;
+#endif /* LDBL_MANT_DIG == 64 */
+}
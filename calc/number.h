@@ -0,0 +1,57 @@
+/**
+ * @file  calc/number.h
+ * @brief 数値文字列の変換
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2010-2011 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _NUMBER_H_
+#define _NUMBER_H_
+
+#include <stdbool.h> /* bool */
+#include <stddef.h>  /* size_t */
+#include <stdint.h>  /* uint64_t */
+
+/** 指数部の最大長(終端含む) */
+#define MAX_NUMBER_EXP    sizeof("e-9223372036854775808")
+/** 倍精度変換で保持する有効数字の最大桁数 */
+#define MAX_NUMBER_DIGIT  800
+/** 数値文字列の最大長(倍精度変換用, 終端含む) */
+#define MAX_NUMBER_TEXT   (MAX_NUMBER_DIGIT + 1 + MAX_NUMBER_EXP)
+
+/** 数値文字列構造体 */
+struct _numberinfo {
+    char *text;    /**< 正規化した数値文字列 */
+    size_t size;   /**< 数値文字列領域サイズ */
+    uint64_t mant; /**< 仮数(有効数字 19 桁まで) */
+    int ndigit;    /**< 有効数字の桁数 */
+    long exp;      /**< 10進指数(値は mant * 10^exp) */
+    bool hex;      /**< 16進浮動小数点 */
+};
+typedef struct _numberinfo numberinfo;
+
+/** 数値文字列の走査 */
+size_t number_scan(const char *buf, const size_t len, numberinfo *num);
+
+/** 数値文字列を倍精度に変換 */
+double number_to_double(const numberinfo *num);
+
+#endif /* _NUMBER_H_ */
@@ -3,10 +3,16 @@
  * @brief オプション引数の処理
  *
  * オプション
- *  -d, --digit   有効桁数設定\n
- *  -t, --time    処理時間計測\n
- *  -h, --help    ヘルプ表示\n
- *  -V, --version バージョン情報表示\n
+ *  -d, --digit      有効桁数設定\n
+ *  -t, --time       処理時間計測\n
+ *  -b, --batch      一括処理(標準入力)\n
+ *  -f, --file       一括処理(ファイル)\n
+ *  -j, --jobs       一括処理のスレッド数\n
+ *  -m, --mpfr       多倍長計算(HAVE_MPFR のみ)\n
+ *  -I, --interval   区間演算\n
+ *  -F, --fast-check 浮動小数点例外を式ごとに一度だけ確認\n
+ *  -h, --help       ヘルプ表示\n
+ *  -V, --version    バージョン情報表示\n
  *
  * @author higashi
  * @date 2010-06-27 higashi 新規作成
@@ -37,19 +43,36 @@
 #include "version.h"
 #include "calc.h"
 #include "option.h"
+#include "batch.h"
+
+/* 外部変数 */
+long g_digit = DEFAULT_DIGIT; /**< 有効桁数 */
+bool g_tflag = false;         /**< tオプションフラグ */
+bool g_bflag = false;         /**< 一括処理フラグ */
+const char *g_file = NULL;    /**< 一括処理の入力ファイル */
+long g_jobs = 0;              /**< 一括処理のスレッド数(0は CPU 数) */
+bool g_mflag = false;         /**< 多倍長計算フラグ */
+bool g_fflag = false;         /**< 浮動小数点例外一括確認フラグ */
+bool g_iflag = false;         /**< 区間演算フラグ */
 
 /* 内部変数 */
 /** オプション情報構造体(ロング) */
 static struct option longopts[] = {
-    { "digit",   required_argument, NULL, 'd' },
-    { "time",    no_argument,       NULL, 't' },
-    { "help",    no_argument,       NULL, 'h' },
-    { "version", no_argument,       NULL, 'V' },
-    { NULL,      0,                 NULL, 0   }
+    { "digit",      required_argument, NULL, 'd' },
+    { "time",       no_argument,       NULL, 't' },
+    { "batch",      no_argument,       NULL, 'b' },
+    { "file",       required_argument, NULL, 'f' },
+    { "jobs",       required_argument, NULL, 'j' },
+    { "mpfr",       no_argument,       NULL, 'm' },
+    { "interval",   no_argument,       NULL, 'I' },
+    { "fast-check", no_argument,       NULL, 'F' },
+    { "help",       no_argument,       NULL, 'h' },
+    { "version",    no_argument,       NULL, 'V' },
+    { NULL,         0,                 NULL, 0   }
 };
 
 /** オプション情報文字列(ショート) */
-static const char *shortopts = "d:thV";
+static const char *shortopts = "d:tbf:j:mIFhV";
 
 /* 内部関数 */
 /** ヘルプの表示 */
@@ -70,24 +93,53 @@ static void parse_error(const int c, const char *msg);
 void
 parse_args(int argc, char *argv[])
 {
-    int opt = 0;         /* オプション */
-    long digit = 0;      /* 桁数 */
-    const int base = 10; /* 基数 */
+    int opt = 0;          /* オプション */
+    long digit = 0;       /* 桁数 */
+    long max = MAX_DIGIT; /* 桁数の上限 */
+    const int base = 10;  /* 基数 */
 
     while ((opt = getopt_long(argc, argv, shortopts, longopts, NULL)) != EOF) {
         dbglog("opt=%c, optarg=%s", opt, optarg);
         switch (opt) {
-        case 'd': /* 有効桁数設定 */
+        case 'd': /* 有効桁数設定(上限は全オプション解析後に確認) */
             digit = strtol(optarg, NULL, base);
-            if (digit <= 0 || MAX_DIGIT < digit) {
+            if (digit <= 0) {
                 (void)fprintf(stderr, "Digits is 1-%ld.\n", MAX_DIGIT);
                 exit(EXIT_FAILURE);
             }
-            set_digit(digit);
+            g_digit = digit;
             break;
         case 't': /* 処理時間計測 */
             g_tflag = true;
             break;
+        case 'b': /* 一括処理(標準入力) */
+            g_bflag = true;
+            break;
+        case 'f': /* 一括処理(ファイル) */
+            g_bflag = true;
+            g_file = optarg;
+            break;
+        case 'j': /* 一括処理のスレッド数 */
+            g_jobs = strtol(optarg, NULL, base);
+            if (g_jobs <= 0 || MAX_JOBS < g_jobs) {
+                (void)fprintf(stderr, "Jobs is 1-%d.\n", MAX_JOBS);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'm': /* 多倍長計算 */
+#ifdef HAVE_MPFR
+            g_mflag = true;
+            break;
+#else
+            (void)fprintf(stderr, "Not built with MPFR.\n");
+            exit(EXIT_FAILURE);
+#endif /* HAVE_MPFR */
+        case 'I': /* 区間演算 */
+            g_iflag = true;
+            break;
+        case 'F': /* 浮動小数点例外を式ごとに一度だけ確認 */
+            g_fflag = true;
+            break;
         case 'h': /* ヘルプ表示 */
             print_help(get_progname());
             exit(EXIT_SUCCESS);
@@ -103,6 +155,18 @@ parse_args(int argc, char *argv[])
             exit(EXIT_FAILURE);
         }
     }
+    if (g_mflag && g_iflag) {
+        (void)fprintf(stderr, "Cannot use -m with -I.\n");
+        exit(EXIT_FAILURE);
+    }
+#ifdef HAVE_MPFR
+    if (g_mflag)
+        max = MAX_MPDIGIT;
+#endif /* HAVE_MPFR */
+    if (max < g_digit) {
+        (void)fprintf(stderr, "Digits is 1-%ld.\n", max);
+        exit(EXIT_FAILURE);
+    }
     if (optind < argc) {
         (void)printf("non-option ARGV-elements: ");
         while (optind < argc)
@@ -126,6 +190,21 @@ print_help(const char *progname)
                   "set digit (1-", MAX_DIGIT, ")\n");
     (void)fprintf(stderr, "  -t, --time             %s",
                   "print time\n");
+    (void)fprintf(stderr, "  -b, --batch            %s",
+                  "evaluate each line of stdin without prompting\n");
+    (void)fprintf(stderr, "  -f, --file=FILE        %s",
+                  "evaluate each line of FILE\n");
+    (void)fprintf(stderr, "  -j, --jobs=N           %s%d%s",
+                  "number of batch threads (1-", MAX_JOBS,
+                  ", default: number of CPUs)\n");
+#ifdef HAVE_MPFR
+    (void)fprintf(stderr, "  -m, --mpfr             %s%ld%s",
+                  "multiple precision (digit 1-", MAX_MPDIGIT, ")\n");
+#endif /* HAVE_MPFR */
+    (void)fprintf(stderr, "  -I, --interval         %s",
+                  "print an interval enclosing the exact result\n");
+    (void)fprintf(stderr, "  -F, --fast-check       %s",
+                  "check FP exceptions once per expression\n");
     (void)fprintf(stderr, "  -h, --help             %s",
                   "display this help and exit\n");
     (void)fprintf(stderr, "  -V, --version          %s",
@@ -26,6 +26,18 @@
 #ifndef _OPTION_H_
 #define _OPTION_H_
 
+#include <stdbool.h> /* bool */
+
+/* 外部変数 */
+extern long g_digit;       /**< 有効桁数 */
+extern bool g_tflag;       /**< tオプションフラグ */
+extern bool g_bflag;       /**< 一括処理フラグ */
+extern const char *g_file; /**< 一括処理の入力ファイル */
+extern long g_jobs;        /**< 一括処理のスレッド数 */
+extern bool g_mflag;       /**< 多倍長計算フラグ */
+extern bool g_fflag;       /**< 浮動小数点例外一括確認フラグ */
+extern bool g_iflag;       /**< 区間演算フラグ */
+
 /** オプション引数 */
 void parse_args(int argc, char *argv[]);
 
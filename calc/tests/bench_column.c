@@ -0,0 +1,143 @@
+/**
+ * @file  calc/tests/bench_column.c
+ * @brief 列評価のマイクロベンチマーク
+ *
+ * 同じ式を calc_eval_many() と calc_eval_columns() で評価し,
+ * 一組あたりの時間を比較する.
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2010-2011 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* strtol malloc EXIT_SUCCESS */
+#include <string.h> /* memset strlen */
+#include <time.h>   /* clock_gettime */
+
+#include "def.h"
+#include "calc.h"
+
+#define DEFAULT_COUNT 1000000 /**< 既定の組の数 */
+
+/* 内部変数 */
+/** 変数名 */
+static const char *vars[] = { "x", "y" };
+
+/** 式 */
+static const char *exprs[] = {
+    "x*x+y*y-2*x*y",
+    "(x+1)/(y+2)*(x-y)+x*0.5",
+    "sin(x)*cos(y)+sqrt(x*x+y*y)"
+};
+
+/** 最適化による削除防止 */
+static volatile double sink = 0.0;
+
+/* 内部関数 */
+/** 経過時間(ナノ秒) */
+static double elapsed(const struct timespec *start);
+
+/**
+ * main関数
+ *
+ * @param[in] argc 引数の数
+ * @param[in] argv 組の数
+ * @return EXIT_FAILURE メモリ不足
+ */
+int
+main(int argc, char *argv[])
+{
+    struct timespec start;      /* 開始時刻 */
+    long count = DEFAULT_COUNT; /* 組の数 */
+    double *rows = NULL;        /* 行ごとの変数の値 */
+    double *x = NULL;           /* 変数xの列 */
+    double *y = NULL;           /* 変数yの列 */
+    double *result = NULL;      /* 結果 */
+    const double *cols[2];      /* 列 */
+    calcinfo calc;              /* calcinfo構造体 */
+    calccode *code = NULL;      /* コード */
+    double many = 0.0;          /* 経過時間(calc_eval_many) */
+    double column = 0.0;        /* 経過時間(calc_eval_columns) */
+    long i;                     /* 汎用変数 */
+    unsigned int j;             /* 汎用変数 */
+
+    if (1 < argc)
+        count = strtol(argv[1], NULL, 10);
+    if (count <= 0)
+        count = DEFAULT_COUNT;
+
+    rows = (double *)malloc(count * 2 * sizeof(double));
+    x = (double *)malloc(count * sizeof(double));
+    y = (double *)malloc(count * sizeof(double));
+    result = (double *)malloc(count * sizeof(double));
+    if (!rows || !x || !y || !result)
+        return EXIT_FAILURE;
+
+    for (i = 0; i < count; i++) {
+        x[i] = rows[i * 2] = (double)(i % 1000) * 0.01 + 0.5;
+        y[i] = rows[i * 2 + 1] = (double)(i % 777) * 0.02 + 1.0;
+    }
+    cols[0] = x;
+    cols[1] = y;
+
+    for (j = 0; j < NELEMS(exprs); j++) {
+        (void)memset(&calc, 0, sizeof(calcinfo));
+        code = calc_compile_vars(&calc, exprs[j], strlen(exprs[j]), vars,
+                                 NELEMS(vars));
+        if (!code)
+            return EXIT_FAILURE;
+
+        (void)clock_gettime(CLOCK_MONOTONIC, &start);
+        (void)calc_eval_many(&calc, code, rows, count, result, NULL);
+        many = elapsed(&start) / (double)count;
+        sink += result[count - 1];
+
+        (void)clock_gettime(CLOCK_MONOTONIC, &start);
+        (void)calc_eval_columns(&calc, code, cols, count, result, NULL);
+        column = elapsed(&start) / (double)count;
+        sink += result[count - 1];
+
+        (void)printf("%-28s many %6.2f ns, columns %6.2f ns (x%.1f)\n",
+                     exprs[j], many, column, many / column);
+        calc_destroy(&code);
+    }
+
+    free(rows);
+    free(x);
+    free(y);
+    free(result);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * 経過時間(ナノ秒)
+ *
+ * @param[in] start 開始時刻
+ * @return 経過時間
+ */
+static double
+elapsed(const struct timespec *start)
+{
+    struct timespec now; /* 現在時刻 */
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) * 1.0e9 +
+        (double)(now.tv_nsec - start->tv_nsec);
+}
@@ -0,0 +1,141 @@
+/**
+ * @file  calc/tests/bench_fecheck.c
+ * @brief 浮動小数点例外確認のマイクロベンチマーク
+ *
+ * 関数を多く含む式を, 関数ごとに浮動小数点例外を確認する通常の評価と
+ * 式ごとに一度だけ確認する評価(fflag)で比較する.
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2010-2011 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* strtol EXIT_SUCCESS EXIT_FAILURE */
+#include <string.h> /* strlen memset */
+#include <time.h>   /* clock_gettime */
+
+#include "def.h"
+#include "calc.h"
+
+#define DEFAULT_LOOP 1000000 /**< 既定の繰り返し回数 */
+
+/* 内部変数 */
+/** 変数名 */
+static const char *const vars[] = { "x" };
+
+/** 評価する式 */
+static const char *exprs[] = {
+    "x+1",
+    "sin(x)+cos(x)",
+    "sin(cos(sqrt(x)))+atan(tan(x))*log(exp(x))+acos(cos(x/4))",
+    "x^2+x^0.5+x^x"
+};
+
+/** 最適化による削除防止 */
+static volatile double sink = 0.0;
+
+/* 内部関数 */
+/** 評価時間(ナノ秒) */
+static double bench(calcinfo *calc, const calccode *code, const long loop);
+/** 経過時間(ナノ秒) */
+static double elapsed(const struct timespec *start);
+
+/**
+ * main関数
+ *
+ * @param[in] argc 引数の数
+ * @param[in] argv 繰り返し回数
+ * @return EXIT_FAILURE コンパイルエラー
+ */
+int
+main(int argc, char *argv[])
+{
+    long loop = DEFAULT_LOOP; /* 繰り返し回数 */
+    calcinfo calc;            /* calcinfo構造体 */
+    calccode *code = NULL;    /* コード */
+    double each = 0.0;        /* 関数ごとに確認 */
+    double once = 0.0;        /* 式ごとに確認 */
+    unsigned int j;           /* 汎用変数 */
+
+    if (1 < argc)
+        loop = strtol(argv[1], NULL, 10);
+    if (loop <= 0)
+        loop = DEFAULT_LOOP;
+
+    for (j = 0; j < NELEMS(exprs); j++) {
+        (void)memset(&calc, 0, sizeof(calcinfo));
+        code = calc_compile_vars(&calc, exprs[j], strlen(exprs[j]),
+                                 vars, NELEMS(vars));
+        if (!code)
+            return EXIT_FAILURE;
+
+        calc.fflag = false;
+        each = bench(&calc, code, loop);
+        calc.fflag = true;
+        once = bench(&calc, code, loop);
+        calc_destroy(&code);
+
+        (void)printf("per-function %8.2f ns, per-expression %8.2f ns "
+                     "(x%.2f): %s\n", each, once, each / once, exprs[j]);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * 評価時間(ナノ秒)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] code コード
+ * @param[in] loop 繰り返し回数
+ * @return 一回あたりの評価時間
+ */
+static double
+bench(calcinfo *calc, const calccode *code, const long loop)
+{
+    struct timespec start; /* 開始時刻 */
+    double x = 0.0;        /* 変数の値 */
+    double val = 0.0;      /* 値 */
+    long i;                /* 汎用変数 */
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < loop; i++) {
+        x = 0.5 + (double)(i & 0xff) / 256.0;
+        (void)calc_eval_vars(calc, code, &x, &val);
+        sink += val;
+    }
+    return elapsed(&start) / (double)loop;
+}
+
+/**
+ * 経過時間(ナノ秒)
+ *
+ * @param[in] start 開始時刻
+ * @return 経過時間
+ */
+static double
+elapsed(const struct timespec *start)
+{
+    struct timespec now; /* 現在時刻 */
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) * 1.0e9 +
+        (double)(now.tv_nsec - start->tv_nsec);
+}
@@ -0,0 +1,156 @@
+/**
+ * @file  calc/tests/bench_func.c
+ * @brief 関数検索のマイクロベンチマーク
+ *
+ * get_func() と, 以前の実装と同じ strcmp による線形探索を比較する.\n
+ * あわせて関数を多く含む式のコンパイル時間を計測する.
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2010-2011 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* strtol EXIT_SUCCESS */
+#include <string.h> /* strcmp strlen memset */
+#include <time.h>   /* clock_gettime */
+
+#include "def.h"
+#include "calc.h"
+#include "func.h"
+
+#define DEFAULT_LOOP 2000000 /**< 既定の繰り返し回数 */
+
+/* 内部変数 */
+/** 関数名(fstring と同じ順序) */
+static const char *names[] = {
+    "pi", "e", "abs", "sqrt", "sin", "cos", "tan", "asin", "acos",
+    "atan", "exp", "ln", "log", "rad", "deg", "n", "nPr", "nCr"
+};
+
+/** 関数を多く含む式 */
+static const char *expr =
+    "sin(cos(sqrt(2)))+atan(tan(1))*log(exp(2))+acos(cos(0.5))+nCr(10,3)";
+
+/** 最適化による削除防止 */
+static volatile unsigned long sink = 0;
+
+/* 内部関数 */
+/** 線形探索(以前の実装) */
+static int linear_func(const char *func);
+/** 経過時間(ナノ秒) */
+static double elapsed(const struct timespec *start);
+
+/**
+ * main関数
+ *
+ * @param[in] argc 引数の数
+ * @param[in] argv 繰り返し回数
+ * @return 常にEXIT_SUCCESS
+ */
+int
+main(int argc, char *argv[])
+{
+    struct timespec start;     /* 開始時刻 */
+    long loop = DEFAULT_LOOP;  /* 繰り返し回数 */
+    size_t len[NELEMS(names)]; /* 関数名の長さ */
+    calcinfo calc;             /* calcinfo構造体 */
+    calccode *code = NULL;     /* コード */
+    double ns = 0.0;           /* 経過時間 */
+    long i;                    /* 汎用変数 */
+    unsigned int j;            /* 汎用変数 */
+
+    if (1 < argc)
+        loop = strtol(argv[1], NULL, 10);
+    if (loop <= 0)
+        loop = DEFAULT_LOOP;
+
+    for (j = 0; j < NELEMS(names); j++)
+        len[j] = strlen(names[j]);
+
+    /* 線形探索 */
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < loop; i++) {
+        for (j = 0; j < NELEMS(names); j++)
+            sink += (unsigned long)linear_func(names[j]);
+    }
+    ns = elapsed(&start) / ((double)loop * NELEMS(names));
+    (void)printf("strcmp scan : %8.2f ns/lookup\n", ns);
+
+    /* get_func */
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < loop; i++) {
+        for (j = 0; j < NELEMS(names); j++)
+            sink += (unsigned long)get_func(names[j], len[j]);
+    }
+    ns = elapsed(&start) / ((double)loop * NELEMS(names));
+    (void)printf("get_func    : %8.2f ns/lookup\n", ns);
+
+    /* コンパイル */
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < loop / 20; i++) {
+        (void)memset(&calc, 0, sizeof(calcinfo));
+        code = calc_compile(&calc, (const unsigned char *)expr);
+        sink += (unsigned long)code;
+        calc_destroy(&code);
+    }
+    ns = elapsed(&start) / (double)(loop / 20);
+    (void)printf("calc_compile: %8.2f ns/expr (%s)\n", ns, expr);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * 線形探索(以前の実装)
+ *
+ * @param[in] func 関数名
+ * @return 関数番号
+ * @retval EX_NG 関数なし
+ */
+static int
+linear_func(const char *func)
+{
+    char buf[MAX_FUNC_STRING + 2]; /* 関数文字列 */
+
+    (void)memset(buf, 0, sizeof(buf));
+    (void)strncpy(buf, func, MAX_FUNC_STRING + 1);
+
+    int i;
+    for (i = 0; i < (int)NELEMS(names); i++) {
+        if (!strcmp(names[i], buf))
+            return i;
+    }
+    return EX_NG;
+}
+
+/**
+ * 経過時間(ナノ秒)
+ *
+ * @param[in] start 開始時刻
+ * @return 経過時間
+ */
+static double
+elapsed(const struct timespec *start)
+{
+    struct timespec now; /* 現在時刻 */
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) * 1.0e9 +
+        (double)(now.tv_nsec - start->tv_nsec);
+}
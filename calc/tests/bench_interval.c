@@ -0,0 +1,137 @@
+/**
+ * @file  calc/tests/bench_interval.c
+ * @brief 区間演算のベンチマーク
+ *
+ * 同じ式を倍精度と区間演算で一括計算し, 一式あたりの処理時間を比較する.\n
+ * どちらもコードを使い回すため, 差は評価と結果文字列の作成による.
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2011-2018 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* strtol EXIT_SUCCESS */
+#include <string.h> /* memset */
+#include <time.h>   /* clock_gettime */
+
+#include "def.h"
+#include "calc.h"
+#include "interval.h"
+
+#define DEFAULT_COUNT 200000 /**< 既定の繰り返し数 */
+#define BATCH_COUNT     1000 /**< 一括計算の式の数 */
+
+/** 式 */
+static const char *exprs[] = {
+    "1+2*3-4/5",
+    "0.1+0.2*0.3-0.4/0.7",
+    "sqrt(2)*sqrt(3)+2^0.5",
+    "sin(1)+cos(2)*tan(0.5)",
+    "exp(1.5)-ln(3)+log(7)*atan(0.3)",
+    "nCr(30,12)/n(10)"
+};
+
+/** 式の配列 */
+static const unsigned char *expr[BATCH_COUNT];
+/** 出力バッファ */
+static unsigned char out[BATCH_COUNT * MAX_IANSWER];
+/** 結果の配列 */
+static calcresult result[BATCH_COUNT];
+
+/* 内部関数 */
+/** 計算時間(ナノ秒) */
+static double run(const bool iflag, const long count);
+/** 経過時間(ナノ秒) */
+static double elapsed(const struct timespec *start);
+
+/**
+ * main関数
+ *
+ * @param[in] argc 引数の数
+ * @param[in] argv 繰り返し数
+ * @return EXIT_SUCCESS
+ */
+int
+main(int argc, char *argv[])
+{
+    long count = DEFAULT_COUNT; /* 繰り返し数 */
+    double dbl = 0.0, iv = 0.0; /* 経過時間 */
+
+    if (1 < argc)
+        count = strtol(argv[1], NULL, 10);
+    if (count <= 0)
+        count = DEFAULT_COUNT;
+
+    unsigned int i, j;
+    for (i = 0; i < NELEMS(exprs); i++) {
+        for (j = 0; j < BATCH_COUNT; j++)
+            expr[j] = (const unsigned char *)exprs[i];
+        dbl = run(false, count);
+        iv = run(true, count);
+        (void)printf("%-34s double %7.1f ns, interval %7.1f ns (x%.1f)\n",
+                     exprs[i], dbl, iv, iv / dbl);
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * 計算時間(ナノ秒)
+ *
+ * 構文解析と結果文字列の作成を含めて, 一式あたりの時間を求める.
+ *
+ * @param[in] iflag 区間演算
+ * @param[in] count 式の数
+ * @return 一式あたりの経過時間
+ */
+static double
+run(const bool iflag, const long count)
+{
+    struct timespec start; /* 開始時刻 */
+    calcinfo calc;         /* calc情報構造体 */
+    long done = 0;         /* 計算した式の数 */
+
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    calc.iflag = iflag;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    while (done < count) {
+        if (calc_eval_batch(&calc, expr, NULL, BATCH_COUNT, out,
+                            sizeof(out), result) != BATCH_COUNT)
+            break;
+        done += BATCH_COUNT;
+    }
+    return elapsed(&start) / (double)done;
+}
+
+/**
+ * 経過時間(ナノ秒)
+ *
+ * @param[in] start 開始時刻
+ * @return 経過時間
+ */
+static double
+elapsed(const struct timespec *start)
+{
+    struct timespec now; /* 現在時刻 */
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) * 1.0e9 +
+        (double)(now.tv_nsec - start->tv_nsec);
+}
@@ -0,0 +1,194 @@
+/**
+ * @file  calc/tests/bench_number.c
+ * @brief 数値変換のマイクロベンチマーク
+ *
+ * 数値の多い入力で, 従来の一桁ずつ加算する変換と
+ * number_scan() + number_to_double() を比較する.
+ * strtod() と値が異なる数も表示する.
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2010-2011 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>  /* printf snprintf */
+#include <stdlib.h> /* strtol strtod malloc EXIT_SUCCESS */
+#include <string.h> /* strlen */
+#include <ctype.h>  /* isdigit */
+#include <time.h>   /* clock_gettime */
+
+#include "def.h"
+#include "number.h"
+
+#define DEFAULT_COUNT 1000000 /**< 既定の数値の数 */
+#define MAX_LITERAL   32      /**< 数値の最大長 */
+
+/** 入力の種類 */
+static const char *kinds[] = {
+    "integer (1-6 digits)",
+    "decimal (2.2 digits)",
+    "decimal (17 digits)"
+};
+
+/** 最適化による削除防止 */
+static volatile double sink = 0.0;
+
+/* 内部関数 */
+/** 従来の変換 */
+static double old_number(const char *buf);
+/** 数値生成 */
+static void make_literal(char *buf, const int kind, unsigned int *seed);
+/** 経過時間(ナノ秒) */
+static double elapsed(const struct timespec *start);
+
+/**
+ * main関数
+ *
+ * @param[in] argc 引数の数
+ * @param[in] argv 数値の数
+ * @return EXIT_FAILURE メモリ不足
+ */
+int
+main(int argc, char *argv[])
+{
+    struct timespec start;              /* 開始時刻 */
+    long count = DEFAULT_COUNT;         /* 数値の数 */
+    char *literal = NULL;               /* 数値 */
+    char text[MAX_NUMBER_TEXT];         /* 数値文字列 */
+    numberinfo num = { text, sizeof(text) }; /* 数値文字列構造体 */
+    double old = 0.0, new = 0.0;        /* 経過時間 */
+    long oldbad = 0, newbad = 0;        /* strtod() と異なる数 */
+    double expect = 0.0, val = 0.0;     /* 値 */
+    unsigned int seed = 1;              /* 乱数の種 */
+    long i;                             /* 汎用変数 */
+    unsigned int j;                     /* 汎用変数 */
+
+    if (1 < argc)
+        count = strtol(argv[1], NULL, 10);
+    if (count <= 0)
+        count = DEFAULT_COUNT;
+
+    literal = (char *)malloc(count * MAX_LITERAL);
+    if (!literal)
+        return EXIT_FAILURE;
+
+    for (j = 0; j < NELEMS(kinds); j++) {
+        for (i = 0; i < count; i++)
+            make_literal(literal + i * MAX_LITERAL, (int)j, &seed);
+
+        (void)clock_gettime(CLOCK_MONOTONIC, &start);
+        for (i = 0; i < count; i++)
+            sink += old_number(literal + i * MAX_LITERAL);
+        old = elapsed(&start) / (double)count;
+
+        (void)clock_gettime(CLOCK_MONOTONIC, &start);
+        for (i = 0; i < count; i++) {
+            const char *p = literal + i * MAX_LITERAL;
+            (void)number_scan(p, MAX_LITERAL, &num);
+            sink += number_to_double(&num);
+        }
+        new = elapsed(&start) / (double)count;
+
+        oldbad = newbad = 0;
+        for (i = 0; i < count; i++) {
+            const char *p = literal + i * MAX_LITERAL;
+            expect = strtod(p, NULL);
+            if (old_number(p) != expect)
+                oldbad++;
+            (void)number_scan(p, MAX_LITERAL, &num);
+            val = number_to_double(&num);
+            if (val != expect)
+                newbad++;
+        }
+
+        (void)printf("%-22s old %6.2f ns, new %6.2f ns (x%.1f), "
+                     "inexact old %ld, new %ld\n",
+                     kinds[j], old, new, old / new, oldbad, newbad);
+    }
+
+    free(literal);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * 従来の変換
+ *
+ * number() の以前の実装と同じく一桁ずつ加算する.
+ *
+ * @param[in] buf 数値
+ * @return 値
+ */
+static double
+old_number(const char *buf)
+{
+    double x = 0.0, y = 1.0; /* 値 */
+
+    x = *buf - '0';
+    while (isdigit(*++buf))
+        x = (x * 10) + (*buf - '0');
+    if (*buf == '.') {
+        while (isdigit(*++buf))
+            x += (y /= 10) * (*buf - '0');
+    }
+    return x;
+}
+
+/**
+ * 数値生成
+ *
+ * @param[out] buf 数値
+ * @param[in] kind 種類
+ * @param[in,out] seed 乱数の種
+ * @return なし
+ */
+static void
+make_literal(char *buf, const int kind, unsigned int *seed)
+{
+    switch (kind) {
+    case 0:
+        (void)snprintf(buf, MAX_LITERAL, "%d",
+                       rand_r(seed) % ((rand_r(seed) % 6 == 0) ? 10 : 1000000));
+        break;
+    case 1:
+        (void)snprintf(buf, MAX_LITERAL, "%d.%02d",
+                       rand_r(seed) % 100, rand_r(seed) % 100);
+        break;
+    default:
+        (void)snprintf(buf, MAX_LITERAL, "%d.%09d%07d",
+                       rand_r(seed) % 10, rand_r(seed) % 1000000000,
+                       rand_r(seed) % 10000000);
+        break;
+    }
+}
+
+/**
+ * 経過時間(ナノ秒)
+ *
+ * @param[in] start 開始時刻
+ * @return 経過時間
+ */
+static double
+elapsed(const struct timespec *start)
+{
+    struct timespec now; /* 現在時刻 */
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) * 1.0e9 +
+        (double)(now.tv_nsec - start->tv_nsec);
+}
@@ -23,11 +23,16 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
  */
 
+#include <stdio.h>  /* sprintf */
+#include <stdlib.h> /* malloc */
+#include <math.h>   /* sqrt */
 #include <cutter.h> /* cutter library */
 
 #include "def.h"
 #include "log.h"
+#include "timer.h"
 #include "error.h"
+#include "func.h"
 #include "memfree.h"
 #include "calc.h"
 #include "test_common.h"
@@ -41,9 +46,27 @@ void test_answer_func(void);
 void test_answer_four_func(void);
 /** 関数エラー時テスト */
 void test_answer_error(void);
+/** エラー位置テスト */
+void test_answer_errorpos(void);
+/** 深い入れ子のテスト */
+void test_answer_nest(void);
+/** 上限のテスト */
+void test_answer_limit(void);
+/** 制限時間のテスト */
+void test_answer_timeout(void);
+/** calc_compile() calc_eval() 関数テスト */
+void test_calc_compile(void);
+/** calc_compile() 最適化テスト */
+void test_calc_optimize(void);
+/** calc_compile_vars() calc_eval_many() 関数テスト */
+void test_calc_eval_vars(void);
+/** calc_eval_batch() 関数テスト */
+void test_calc_eval_batch(void);
+/** 浮動小数点例外の一括確認テスト */
+void test_calc_eval_fflag(void);
 /** parse_func_args() 関数テスト */
 void test_parse_func_args(void);
-/** set_digit() 関数テスト */
+/** 有効桁数設定テスト */
 void test_set_digit(void);
 /** readch() 関数テスト */
 void test_readch(void);
@@ -57,8 +80,8 @@ void test_factor(void);
 void test_token(void);
 /** number() 関数テスト */
 void test_number(void);
-/** get_strlen() 関数テスト */
-void test_get_strlen(void);
+/** calc_format() 関数テスト */
+void test_calc_format(void);
 
 /* 内部変数 */
 static testcalc st_calc; /**< 関数構造体 */
@@ -66,6 +89,8 @@ static testcalc st_calc; /**< 関数構造体 */
 /* 内部関数 */
 /** バッファセット */
 static void exec_calc(calcinfo *calc, const char *str);
+/** 指定ミリ秒待つ登録関数 */
+static double user_spin(calcinfo *calc, const double *args);
 
 /** テストデータ構造体(answer char) */
 struct test_data_char {
@@ -169,6 +194,30 @@ static const struct test_data_char error_data [] = {
     { "n(-5000)",   "Infinity."             }
 };
 
+/** 浮動小数点例外の一括確認テスト用データ */
+static const char *fflag_data[] = {
+    "x+1", "sqrt(x)", "ln(x)", "log(x)", "asin(x)", "acos(x)",
+    "exp(x*1000)", "x^-1", "x^0.5", "x^x", "tan(x)+sin(x)", "n(x*200)",
+    "nCr(x*60,x)", "sqrt(x)+ln(x)"
+};
+
+/** エラー位置テスト用データ */
+static const struct {
+    const char *expr; /**< 式 */
+    ER errorcode;     /**< エラーコード */
+    long errorpos;    /**< エラー位置 */
+} errorpos_data[] = {
+    { "1+*2",       E_SYNTAX,    2  },
+    { "(1+2",       E_SYNTAX,    4  },
+    { "1+2)",       E_SYNTAX,    3  },
+    { "2 * nofunc", E_NOFUNC,    4  },
+    { "sin(1,2)",   E_SYNTAX,    5  },
+    { "3+1_",       E_SYNTAX,    2  },
+    { "1+1e999",    E_INFINITY,  2  },
+    { "5/0",        E_DIVBYZERO, -1 },
+    { "sqrt(-1)",   E_NAN,       -1 }
+};
+
 /** expression() 関数テスト用データ */
 static const struct test_data_double expression_data [] = {
     { "5+7", 12, E_NONE },
@@ -202,6 +251,11 @@ static const struct test_data_double token_data [] = {
 static const struct test_data_double number_data [] = {
     { "54321",  54321,     E_NONE },
     { "543.21",   543.21,  E_NONE },
+    { "1.5e-3",   0.0015,  E_NONE },
+    { "2.5E+2",   250,     E_NONE },
+    { "0x1.8p3",  12,      E_NONE },
+    { "1_000_000", 1000000, E_NONE },
+    { "0.1",      0.1,     E_NONE },
 };
 
 /**
@@ -313,6 +367,556 @@ test_answer_error(void)
     }
 }
 
+/**
+ * エラー位置テスト
+ *
+ * @return なし
+ */
+void
+test_answer_errorpos(void)
+{
+    calcinfo calc;             /* calc情報構造体 */
+    char *expr = NULL;         /* 式 */
+    size_t size = 1024 * 1024; /* 式の長さ */
+
+    unsigned int i;
+    for (i = 0; i < NELEMS(errorpos_data); i++) {
+        (void)memset(&calc, 0, sizeof(calcinfo));
+        exec_calc(&calc, errorpos_data[i].expr);
+        cut_assert_equal_string(get_errorstr(errorpos_data[i].errorcode),
+                                (char *)calc.answer,
+                                cut_message("%s", errorpos_data[i].expr));
+        cut_assert_equal_int(errorpos_data[i].errorpos, calc.errorpos,
+                             cut_message("%s", errorpos_data[i].expr));
+        destroy_answer(&calc);
+    }
+
+    /* 長い式の先頭のエラー */
+    expr = (char *)cut_take_memory(malloc(size + 1));
+    cut_assert_not_null(expr);
+    (void)memset(expr, '1', size);
+    (void)memcpy(expr, "1+)", 3);
+    expr[size] = '\0';
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    exec_calc(&calc, expr);
+    cut_assert_equal_string("Syntax error.", (char *)calc.answer);
+    cut_assert_equal_int(2, calc.errorpos);
+    destroy_answer(&calc);
+}
+
+/**
+ * 深い入れ子のテスト
+ *
+ * 入れ子の深さによらずスタックを使い果たさないことを確認する.
+ *
+ * @return なし
+ */
+void
+test_answer_nest(void)
+{
+    calcinfo calc;            /* calc情報構造体 */
+    const int depth = 200000; /* 入れ子の深さ */
+    char *expr = NULL;        /* 式 */
+    int n = 0;                /* 文字数 */
+
+    expr = (char *)cut_take_memory(malloc((size_t)depth * 8 + 16));
+    cut_assert_not_null(expr);
+
+    /* 括弧 */
+    int i;
+    for (i = 0; i < depth; i++)
+        expr[n++] = '(';
+    n += sprintf(expr + n, "2");
+    for (i = 0; i < depth; i++)
+        expr[n++] = ')';
+    n += sprintf(expr + n, "*3");
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    exec_calc(&calc, expr);
+    cut_assert_equal_string("6", (char *)calc.answer);
+    destroy_answer(&calc);
+
+    /* 閉じ括弧不足 */
+    expr[n - 3] = '\0';
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    exec_calc(&calc, expr);
+    cut_assert_equal_string("Syntax error.", (char *)calc.answer);
+    destroy_answer(&calc);
+
+    /* 関数と単項マイナス */
+    n = 0;
+    for (i = 0; i < depth; i++)
+        n += sprintf(expr + n, "-abs(");
+    n += sprintf(expr + n, "2");
+    for (i = 0; i < depth; i++)
+        expr[n++] = ')';
+    expr[n] = '\0';
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    exec_calc(&calc, expr);
+    cut_assert_equal_string("-2", (char *)calc.answer);
+    destroy_answer(&calc);
+}
+
+/**
+ * 上限のテスト
+ *
+ * @return なし
+ */
+void
+test_answer_limit(void)
+{
+    calcinfo calc; /* calc情報構造体 */
+
+    /* 式の長さ */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    calc.maxlen = 5;
+    exec_calc(&calc, "1+2+3");
+    cut_assert_equal_string("6", (char *)calc.answer);
+    destroy_answer(&calc);
+    exec_calc(&calc, "1+2+34");
+    cut_assert_equal_string("Limit exceeded.", (char *)calc.answer);
+    cut_assert_equal_int(5, calc.errorpos);
+    destroy_answer(&calc);
+
+    /* 入れ子の深さ(関数の引数を含む) */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    calc.maxdepth = 2;
+    exec_calc(&calc, "((1))+(sqrt(4))");
+    cut_assert_equal_string("3", (char *)calc.answer);
+    destroy_answer(&calc);
+    exec_calc(&calc, "1+((sqrt(4)))");
+    cut_assert_equal_string("Limit exceeded.", (char *)calc.answer);
+    cut_assert_equal_int(8, calc.errorpos);
+    destroy_answer(&calc);
+
+    /* ノード数 */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    calc.maxnodes = 5;
+    exec_calc(&calc, "1+2*3");
+    cut_assert_equal_string("7", (char *)calc.answer);
+    destroy_answer(&calc);
+    exec_calc(&calc, "1+2*3-4");
+    cut_assert_equal_string("Limit exceeded.", (char *)calc.answer);
+    destroy_answer(&calc);
+}
+
+/**
+ * 制限時間のテスト
+ *
+ * @return なし
+ */
+void
+test_answer_timeout(void)
+{
+    calcinfo calc;                     /* calc情報構造体 */
+    const unsigned char *expr[2];      /* 式 */
+    calcresult result[2];              /* 結果 */
+    unsigned char out[2 * MAX_ANSWER]; /* 出力バッファ */
+
+    (void)calc_register_func("spin", 1, user_spin);
+
+    /* 無制限 */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    exec_calc(&calc, "spin(2)+spin(2)");
+    cut_assert_equal_string("4", (char *)calc.answer);
+    destroy_answer(&calc);
+
+    /* 登録関数の後で期限切れ */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    calc.timeout = 1;
+    exec_calc(&calc, "spin(2)+spin(2)");
+    cut_assert_equal_string("Timed out.", (char *)calc.answer);
+    cut_assert_equal_int(-1, calc.errorpos);
+    cut_assert_equal_int(0, (int)calc.deadline);
+    destroy_answer(&calc);
+
+    /* 期限は式ごと */
+    expr[0] = (const unsigned char *)"spin(2)";
+    expr[1] = (const unsigned char *)"1+1";
+    cut_assert_equal_int(2, (int)calc_eval_batch(&calc, expr, NULL, 2, out,
+                                                 sizeof(out), result));
+    cut_assert_equal_int((int)E_TIMEOUT, (int)result[0].errorcode);
+    cut_assert_equal_int((int)E_NONE, (int)result[1].errorcode);
+    cut_assert_equal_string("2", (char *)out + result[1].offset);
+}
+
+/**
+ * calc_compile() calc_eval() 関数テスト
+ *
+ * 一度コンパイルしたコードを繰り返し評価できることを確認する.
+ *
+ * @return なし
+ */
+void
+test_calc_compile(void)
+{
+    calcinfo calc;         /* calc情報構造体 */
+    calccode *code = NULL; /* コード */
+    double result = 0.0;   /* 結果 */
+    int retval = 0;        /* 戻り値 */
+
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    code = calc_compile(&calc, (unsigned char *)"(105+312)+2*sin(2)");
+    cut_assert_not_null(code);
+    cut_assert_null(calc.code);
+
+    int i;
+    for (i = 0; i < 3; i++) {
+        retval = calc_eval(&calc, code, &result);
+        cut_assert_equal_int(EX_OK, retval);
+        cut_assert_equal_int((int)E_NONE, (int)calc.errorcode);
+        cut_assert_equal_double(418.818594853, 0.000000001, result);
+    }
+    calc_destroy(&code);
+    cut_assert_null(code);
+
+    /* 評価時エラー */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    code = calc_compile(&calc, (unsigned char *)"5/(2-2)");
+    cut_assert_not_null(code);
+    retval = calc_eval(&calc, code, &result);
+    cut_assert_equal_int(EX_OK, retval);
+    cut_assert_equal_int((int)E_DIVBYZERO, (int)calc.errorcode);
+    calc_destroy(&code);
+
+    /* コンパイル時エラー */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    code = calc_compile(&calc, (unsigned char *)"sin(5");
+    cut_assert_null(code);
+    cut_assert_equal_int((int)E_SYNTAX, (int)calc.errorcode);
+
+    /* 長さ指定(終端文字なし) */
+    const char buf[] = { '1', '+', '2', '*', '3', 'x', 'y', 'z' };
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    code = calc_compile_buf(&calc, buf, 5);
+    cut_assert_not_null(code);
+    cut_assert_null(calc.end);
+    retval = calc_eval(&calc, code, &result);
+    cut_assert_equal_int(EX_OK, retval);
+    cut_assert_equal_double(7.0, 0.0, result);
+    calc_destroy(&code);
+
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    cut_assert_equal_string("7", (char *)create_answer_buf(&calc, buf, 5));
+    destroy_answer(&calc);
+
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    code = calc_compile_buf(&calc, buf, 4); /* "1+2*" */
+    cut_assert_null(code);
+    cut_assert_equal_int((int)E_SYNTAX, (int)calc.errorcode);
+}
+
+/**
+ * calc_compile() 最適化テスト
+ *
+ * 定数の畳み込みと共通部分式の共有でノード数が減り,
+ * エラーは実行時に同じように検出されることを確認する.
+ *
+ * @return なし
+ */
+void
+test_calc_optimize(void)
+{
+    calcinfo calc;                /* calc情報構造体 */
+    calccode *code = NULL;        /* コード */
+    double result = 0.0;          /* 結果 */
+    const char *vars[] = { "x" }; /* 変数名 */
+    const double var = 2.0;       /* 変数の値 */
+
+    /* 全て畳み込む */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    code = calc_compile(&calc, (unsigned char *)"rad(45)*2*pi+sqrt(2)");
+    cut_assert_not_null(code);
+    cut_assert_equal_int(1, code->size);
+    cut_assert_equal_int(EX_OK, calc_eval(&calc, code, &result));
+    cut_assert_equal_double(6.34901576, 0.00000001, result);
+    calc_destroy(&code);
+
+    /* 溢れる部分式は畳み込まずに共有する */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    code = calc_compile(&calc, (unsigned char *)"2^2000+2^2000");
+    cut_assert_not_null(code);
+    cut_assert_equal_int(4, code->size);
+    cut_assert_equal_int(EX_OK, calc_eval(&calc, code, &result));
+    cut_assert_equal_int((int)E_INFINITY, (int)calc.errorcode);
+    calc_destroy(&code);
+
+    /* 畳み込めない部分だけ残す */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    code = calc_compile(&calc, (unsigned char *)"1+2*3+2^2000");
+    cut_assert_not_null(code);
+    cut_assert_equal_int(5, code->size);
+    cut_assert_equal_int(EX_OK, calc_eval(&calc, code, &result));
+    cut_assert_equal_int((int)E_INFINITY, (int)calc.errorcode);
+    calc_destroy(&code);
+
+    /* 関数の引数では例外フラグのクリアを跨いで共有しない */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    code = calc_compile(&calc, (unsigned char *)"sin(0.1^400)+sin(0.1^400)");
+    cut_assert_not_null(code);
+    cut_assert_equal_int(7, code->size);
+    cut_assert_equal_int(EX_OK, calc_eval(&calc, code, &result));
+    cut_assert_equal_int((int)E_INFINITY, (int)calc.errorcode);
+    calc_destroy(&code);
+
+    /* 組み込み関数はクリアを跨いで共有する */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    code = calc_compile_vars(&calc, "sqrt(x)*sqrt(x)", 15, vars, 1);
+    cut_assert_not_null(code);
+    cut_assert_equal_int(3, code->size);
+    cut_assert_equal_int(EX_OK, calc_eval_vars(&calc, code, &var, &result));
+    cut_assert_equal_double(2.0, 0.0000001, result);
+    calc_destroy(&code);
+
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    code = calc_compile_vars(&calc, "sin(x)*2+sin(x)*2", 17, vars, 1);
+    cut_assert_not_null(code);
+    cut_assert_equal_int(6, code->size);
+    cut_assert_equal_int(EX_OK, calc_eval_vars(&calc, code, &var, &result));
+    cut_assert_equal_double(4.0 * sin(2.0), 0.0000001, result);
+    calc_destroy(&code);
+
+    /* 関数の結果はクリア後も検出する */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    code = calc_compile_vars(&calc, "1+ln(x-2)+ln(x-2)", 17, vars, 1);
+    cut_assert_not_null(code);
+    cut_assert_equal_int(EX_OK, calc_eval_vars(&calc, code, &var, &result));
+    cut_assert_equal_int((int)E_INFINITY, (int)calc.errorcode);
+    calc_destroy(&code);
+
+    /* ゼロ除算は実行時に検出する */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    code = calc_compile(&calc, (unsigned char *)"1/(2-2)");
+    cut_assert_not_null(code);
+    cut_assert_equal_int(EX_OK, calc_eval(&calc, code, &result));
+    cut_assert_equal_int((int)E_DIVBYZERO, (int)calc.errorcode);
+    calc_destroy(&code);
+}
+
+/**
+ * calc_compile_vars() calc_eval_many() 関数テスト
+ *
+ * 一度コンパイルした式を複数の変数値で評価できることを確認する.
+ *
+ * @return なし
+ */
+void
+test_calc_eval_vars(void)
+{
+    calcinfo calc;                             /* calc情報構造体 */
+    calccode *code = NULL;                     /* コード */
+    const char *vars[] = { "x", "rate", "e" }; /* 変数名 */
+    const char *expr = NULL;                   /* 式 */
+    const double var[] = {                     /* 変数の値 */
+        3.0, 0.5, 1.0,
+        0.0, 2.0, 1.0,
+        -1.0, 1.0, 2.0
+    };
+    double result[3];                          /* 結果 */
+    ER errorcode[3];                           /* エラーコード */
+    ssize_t retval = 0;                        /* 戻り値 */
+    const char *badvars[] = {                  /* 不正な変数名 */
+        "", "x1", "rate_", "a b",
+        "abcdefghijklmnopqrstuvwxyzabcdef" /* 32 文字 */
+    };
+
+    /* 単一の値 */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    expr = "x*x+rate*2*(1+1)";
+    code = calc_compile_vars(&calc, expr, strlen(expr), vars, 2);
+    cut_assert_not_null(code);
+    cut_assert_equal_int(2, code->nvar);
+    cut_assert_null(calc.vars);
+    cut_assert_equal_int(EX_OK, calc_eval_vars(&calc, code, var, &result[0]));
+    cut_assert_equal_int((int)E_NONE, (int)calc.errorcode);
+    cut_assert_equal_double(11.0, 0.0, result[0]);
+    cut_assert_null(calc.var);
+
+    /* 値なしで評価 */
+    cut_assert_equal_int(EX_OK, calc_eval(&calc, code, &result[0]));
+    cut_assert_equal_int((int)E_SYNTAX, (int)calc.errorcode);
+    calc_destroy(&code);
+
+    /* 複数の値(変数は関数より優先) */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    expr = "sqrt(x)/x+e";
+    code = calc_compile_vars(&calc, expr, strlen(expr), vars, 3);
+    cut_assert_not_null(code);
+    retval = calc_eval_many(&calc, code, var, 3, result, errorcode);
+    cut_assert_equal_int(3, (int)retval);
+    cut_assert_equal_int((int)E_NONE, (int)calc.errorcode);
+    cut_assert_equal_int((int)E_NONE, (int)errorcode[0]);
+    cut_assert_equal_double(sqrt(3.0) / 3.0 + 1.0, 0.0, result[0]);
+    cut_assert_equal_int((int)E_DIVBYZERO, (int)errorcode[1]);
+    cut_assert_equal_int((int)E_NAN, (int)errorcode[2]);
+    calc_destroy(&code);
+
+    /* 同じ変数は共有する */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    expr = "x*x+x*x";
+    code = calc_compile_vars(&calc, expr, strlen(expr), vars, 1);
+    cut_assert_not_null(code);
+    cut_assert_equal_int(3, code->size);
+    calc_destroy(&code);
+
+    /* 宣言していない名前 */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    expr = "x+y";
+    code = calc_compile_vars(&calc, expr, strlen(expr), vars, 1);
+    cut_assert_null(code);
+    cut_assert_equal_int((int)E_NOFUNC, (int)calc.errorcode);
+
+    /* 式中に書けない変数名 */
+    unsigned int i;
+    for (i = 0; i < NELEMS(badvars); i++) {
+        (void)memset(&calc, 0, sizeof(calcinfo));
+        code = calc_compile_vars(&calc, "1", 1, &badvars[i], 1);
+        cut_assert_null(code, cut_message("%s", badvars[i]));
+        cut_assert_equal_int((int)E_SYNTAX, (int)calc.errorcode,
+                             cut_message("%s", badvars[i]));
+    }
+}
+
+/**
+ * calc_eval_batch() 関数テスト
+ *
+ * create_answer() と同じ結果になることを確認する.
+ *
+ * @return なし
+ */
+void
+test_calc_eval_batch(void)
+{
+    calcinfo calc;                      /* calc情報構造体 */
+    const unsigned char *expr[64];      /* 式 */
+    calcresult result[64];              /* 結果 */
+    unsigned char out[64 * MAX_ANSWER]; /* 出力バッファ */
+    char *large = NULL;                 /* ノード数の多い式 */
+    const unsigned int nterm = 1000;    /* 項の数 */
+    size_t count = 0;                   /* 式の数 */
+    ssize_t retval = 0;                 /* 戻り値 */
+    unsigned int i;                     /* 汎用変数 */
+
+    for (i = 0; i < NELEMS(four_func_data); i++)
+        expr[count++] = (unsigned char *)four_func_data[i].expr;
+    for (i = 0; i < NELEMS(error_data); i++)
+        expr[count++] = (unsigned char *)error_data[i].expr;
+
+    /* 評価用領域がスタックに収まらない式 */
+    large = (char *)cut_take_memory(malloc(nterm * 2 + 2));
+    (void)memset(large, 0, nterm * 2 + 2);
+    (void)strcat(large, "1");
+    for (i = 0; i < nterm; i++)
+        (void)strcat(large, "+1");
+    expr[count++] = (unsigned char *)large;
+
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    retval = calc_eval_batch(&calc, expr, NULL, count, out, sizeof(out),
+                             result);
+    cut_assert_equal_int((int)count, (int)retval);
+    cut_assert_equal_int((int)E_NONE, (int)calc.errorcode);
+
+    for (i = 0; i < NELEMS(four_func_data); i++) {
+        cut_assert_equal_int((int)E_NONE, (int)result[i].errorcode);
+        cut_assert_equal_int(-1, result[i].errorpos);
+        cut_assert_equal_string(four_func_data[i].answer,
+                                (char *)out + result[i].offset,
+                                cut_message("%s", expr[i]));
+        cut_assert_equal_int((int)strlen(four_func_data[i].answer),
+                             (int)result[i].length);
+    }
+    for (; i < count - 1; i++) {
+        cut_assert_not_equal_int((int)E_NONE, (int)result[i].errorcode);
+        cut_assert_equal_string(
+            error_data[i - NELEMS(four_func_data)].answer,
+            (char *)out + result[i].offset, cut_message("%s", expr[i]));
+    }
+    cut_assert_equal_string("1001", (char *)out + result[i].offset);
+    /* "sin(5" は終端がエラー位置 */
+    cut_assert_equal_int(5, result[NELEMS(four_func_data) + 1].errorpos);
+
+    /* 出力バッファ不足で中断 */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    retval = calc_eval_batch(&calc, expr, NULL, count, out, MAX_ANSWER,
+                             result);
+    cut_assert_equal_int(1, (int)retval);
+    cut_assert_equal_string(four_func_data[0].answer, (char *)out);
+
+    /* 長さ指定(改行区切りのバッファをそのまま渡す) */
+    const char lines[] = "1+2\n3*4\nsqrt(16)";
+    const size_t len[] = { 3, 3, 8 };
+    expr[0] = (const unsigned char *)lines;
+    expr[1] = (const unsigned char *)lines + 4;
+    expr[2] = (const unsigned char *)lines + 8;
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    retval = calc_eval_batch(&calc, expr, len, 3, out, sizeof(out), result);
+    cut_assert_equal_int(3, (int)retval);
+    cut_assert_equal_string("3", (char *)out + result[0].offset);
+    cut_assert_equal_string("12", (char *)out + result[1].offset);
+    cut_assert_equal_string("4", (char *)out + result[2].offset);
+}
+
+/**
+ * 浮動小数点例外の一括確認テスト
+ *
+ * fflag を設定しても, 関数と指数の結果とエラーが変わらないことを確認する.\n
+ * 演算子で発生した例外もエラーになる点だけが異なる.
+ *
+ * @return なし
+ */
+void
+test_calc_eval_fflag(void)
+{
+    calcinfo calc;                       /* calc情報構造体 */
+    calccode *code = NULL;               /* コード */
+    const char *vars[] = { "x" };        /* 変数名 */
+    const double var[] = {               /* 変数の値 */
+        -2.0, -1.0, -0.5, 0.0, 0.5, 1.0, 2.0, 1e-300
+    };
+    const char *expr = NULL;             /* 式 */
+    const double tiny = 1e-200;          /* 値 */
+    double expect = 0.0, actual = 0.0;   /* 結果 */
+    ER experr = E_NONE;                  /* エラーコード */
+
+    unsigned int i, j;
+    for (i = 0; i < NELEMS(fflag_data); i++) {
+        (void)memset(&calc, 0, sizeof(calcinfo));
+        code = calc_compile_vars(&calc, fflag_data[i],
+                                 strlen(fflag_data[i]), vars, 1);
+        cut_assert_not_null(code, cut_message("%s", fflag_data[i]));
+
+        for (j = 0; j < NELEMS(var); j++) {
+            calc.fflag = false;
+            (void)calc_eval_vars(&calc, code, &var[j], &expect);
+            experr = calc.errorcode;
+            clear_error(&calc);
+
+            calc.fflag = true;
+            (void)calc_eval_vars(&calc, code, &var[j], &actual);
+            cut_assert_equal_int((int)experr, (int)calc.errorcode,
+                                 cut_message("%s, x=%g", fflag_data[i],
+                                             var[j]));
+            if (experr == E_NONE)
+                cut_assert_equal_double(expect, 0.0, actual,
+                                        cut_message("%s, x=%g",
+                                                    fflag_data[i], var[j]));
+            clear_error(&calc);
+        }
+        calc_destroy(&code);
+    }
+
+    /* 関数の後の演算子で発生したアンダーフローもエラーになる */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    expr = "sin(x)*x";
+    code = calc_compile_vars(&calc, expr, strlen(expr), vars, 1);
+    cut_assert_not_null(code);
+    (void)calc_eval_vars(&calc, code, &tiny, &actual);
+    cut_assert_equal_int((int)E_NONE, (int)calc.errorcode);
+    calc.fflag = true;
+    (void)calc_eval_vars(&calc, code, &tiny, &actual);
+    cut_assert_equal_int((int)E_INFINITY, (int)calc.errorcode);
+    calc_destroy(&code);
+}
+
 /**
  * parse_func_args() 関数テスト
  *
@@ -321,29 +925,36 @@ test_answer_error(void)
 void
 test_parse_func_args(void)
 {
-    double x = 0.0, y = 0.0; /* 値 */
-    calcinfo calc;           /* calc情報構造体 */
+    int args[2] = { EX_NG, EX_NG }; /* 引数ノード */
+    calcinfo calc;                  /* calc情報構造体 */
 
     (void)memset(&calc, 0, sizeof(calcinfo));
     set_string(&calc, "(235)");
     st_calc.readch(&calc);
 
     dbglog("ch=%c", calc.ch);
-    parse_func_args(&calc, &x, NULL);
-    cut_assert_equal_double(235, 0.0, x);
+    cut_assert_equal_int(EX_OK, parse_func_args(&calc, args, 1));
+    cut_assert_equal_double(235, 0.0, calc.code->node[args[0]].u.val);
 
     (void)memset(&calc, 0, sizeof(calcinfo));
     set_string(&calc, "(123,235)");
     st_calc.readch(&calc);
 
     dbglog("ch=%c", calc.ch);
-    parse_func_args(&calc, &x, &y, NULL);
-    cut_assert_equal_double(123, 0.0, x);
-    cut_assert_equal_double(235, 0.0, y);
+    cut_assert_equal_int(EX_OK, parse_func_args(&calc, args, 2));
+    cut_assert_equal_double(123, 0.0, calc.code->node[args[0]].u.val);
+    cut_assert_equal_double(235, 0.0, calc.code->node[args[1]].u.val);
+
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    set_string(&calc, "(123)");
+    st_calc.readch(&calc);
+
+    cut_assert_equal_int(EX_NG, parse_func_args(&calc, args, 2));
+    cut_assert_equal_int((int)E_SYNTAX, (int)calc.errorcode);
 }
 
 /**
- * set_digit() 関数テスト
+ * 有効桁数設定テスト
  *
  * @return なし
  */
@@ -354,12 +965,26 @@ test_set_digit(void)
     const char *expr = "sin(2)";              /* 式 */
     const char *expect = "0.909297426825682"; /* 期待する文字列 */
 
-    set_digit(15L);
     (void)memset(&calc, 0, sizeof(calcinfo));
+    calc.digit = 15L;
     exec_calc(&calc, expr);
     cut_assert_equal_string(expect, (char *)calc.answer,
                             cut_message("%s=%s",
                                         expect, calc.answer));
+    destroy_answer(&calc);
+
+    /* 0はデフォルト値 */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    exec_calc(&calc, expr);
+    cut_assert_equal_string("0.909297426826", (char *)calc.answer);
+    destroy_answer(&calc);
+
+    /* 最大値を超える場合は最大値 */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    calc.digit = MAX_DIGIT + 1;
+    exec_calc(&calc, "1/3");
+    cut_assert_equal_int(MAX_DIGIT + 2, (int)strlen((char *)calc.answer));
+    destroy_answer(&calc);
 }
 
 /**
@@ -418,7 +1043,8 @@ test_expression(void)
         set_string(&calc, expression_data[i].expr);
         st_calc.readch(&calc);
 
-        result = st_calc.expression(&calc);
+        (void)st_calc.expression(&calc);
+        result = eval_code(&calc);
         cut_assert_equal_double(expression_data[i].answer,
                                 0.0,
                                 result,
@@ -445,7 +1071,8 @@ test_term(void)
         set_string(&calc, term_data[i].expr);
         st_calc.readch(&calc);
 
-        result = st_calc.term(&calc);
+        (void)st_calc.term(&calc);
+        result = eval_code(&calc);
         cut_assert_equal_double(term_data[i].answer,
                                 0.0,
                                 result,
@@ -477,7 +1104,8 @@ test_factor(void)
         set_string(&calc, factor_data[i].expr);
         st_calc.readch(&calc);
 
-        result = st_calc.factor(&calc);
+        (void)st_calc.factor(&calc);
+        result = eval_code(&calc);
         cut_assert_equal_double(factor_data[i].answer,
                                 0.0,
                                 result,
@@ -509,7 +1137,8 @@ test_token(void)
         set_string(&calc, token_data[i].expr);
         st_calc.readch(&calc);
 
-        result = st_calc.token(&calc);
+        (void)st_calc.token(&calc);
+        result = eval_code(&calc);
         cut_assert_equal_double(token_data[i].answer,
                                 0.0,
                                 result,
@@ -552,42 +1181,45 @@ test_number(void)
 }
 
 /**
- * get_strlen() 関数テスト
+ * calc_format() 関数テスト
  *
  * @return なし
  */
 void
-test_get_strlen(void)
+test_calc_format(void)
 {
-    cut_assert_equal_int(5, st_calc.get_strlen(50000, "%.18g"));
-    cut_assert_equal_int(15, st_calc.get_strlen(123456789012345LL, "%.18g"));
-    // 12345678.9000000004
-    cut_assert_equal_int(19, st_calc.get_strlen(12345678.9, "%.18g"));
-    // 1234567.89012344996
-    cut_assert_equal_int(19, st_calc.get_strlen(1234567.89012345, "%.18g"));
-
-    cut_assert_equal_int(5, st_calc.get_strlen(50000, "%.15g"));
-    cut_assert_equal_int(15, st_calc.get_strlen(123456789012345LL, "%.15g"));
-    // 12345678.9
-    cut_assert_equal_int(10, st_calc.get_strlen(12345678.9, "%.15g"));
-    // 1234567.89012345
-    cut_assert_equal_int(16, st_calc.get_strlen(1234567.89012345, "%.15g"));
-
-    // 5e+04
-    cut_assert_equal_int(5, st_calc.get_strlen(50000, "%.1g"));
-    // 1e+14
-    cut_assert_equal_int(5, st_calc.get_strlen(123456789012345LL, "%.1g"));
-    // 1e+07
-    cut_assert_equal_int(5, st_calc.get_strlen(12345678.9, "%.1g"));
-    // 1e+06
-    cut_assert_equal_int(5, st_calc.get_strlen(1234567.89012345, "%.1g"));
-
-    cut_assert_equal_int(5, st_calc.get_strlen(50000, "%.30g"));
-    cut_assert_equal_int(15, st_calc.get_strlen(123456789012345LL, "%.30g"));
-    // 12345678.9000000003725290298462
-    cut_assert_equal_int(31, st_calc.get_strlen(12345678.9, "%.30g"));
-    // 1234567.89012344996444880962372
-    cut_assert_equal_int(31, st_calc.get_strlen(1234567.89012345, "%.30g"));
+    char buf[MAX_ANSWER];    /* バッファ */
+    char expect[MAX_ANSWER]; /* 期待値 */
+    const double val[] = { /* 値 */
+        0.0, -0.0, 1.0, -1.0, 50000, 123456789012345LL,
+        999999999999999LL, 1e15, -1e15, 12345678.9,
+        1234567.89012345, 0.1, -0.000012345, 1e-300, 1.7976931348623157e308,
+        -1.7976931348623157e308, 4.9e-324
+    };
+    const long dgt[] = { 1L, 12L, 15L, 16L, 18L, 30L }; /* 桁数 */
+    int retval = 0;    /* 戻り値 */
+    unsigned int i, j; /* 汎用変数 */
+
+    for (j = 0; j < NELEMS(dgt); j++) {
+        for (i = 0; i < NELEMS(val); i++) {
+            (void)snprintf(expect, sizeof(expect), "%.*g", (int)dgt[j], val[i]);
+            retval = calc_format(buf, sizeof(buf), val[i], dgt[j]);
+            cut_assert_equal_int((int)strlen(expect), retval,
+                                 cut_message("%.*g", (int)dgt[j], val[i]));
+            cut_assert_equal_string(expect, buf,
+                                    cut_message("%.*g", (int)dgt[j], val[i]));
+        }
+    }
+
+    /* バッファ不足 */
+    cut_assert_equal_int(EX_NG, calc_format(buf, 5, 50000, 12L));
+    cut_assert_equal_int(EX_NG, calc_format(buf, 5, 0.125, 12L));
+    cut_assert_equal_int(4, calc_format(buf, 5, 1234, 12L));
+
+    /* 有効桁数不正 */
+    cut_assert_equal_int(EX_NG, calc_format(buf, sizeof(buf), 1234, 0L));
+    cut_assert_equal_int(EX_NG, calc_format(buf, sizeof(buf), 1234, -1L));
+    cut_assert_equal_int(EX_NG, calc_format(buf, sizeof(buf), 0.5, -100L));
 }
 
 /**
@@ -605,3 +1237,21 @@ exec_calc(calcinfo *calc, const char *str)
     dbglog("%p answer=%s", calc->answer, calc->answer);
 }
 
+/**
+ * 指定ミリ秒待つ登録関数
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] args 待つ時間(ミリ秒)
+ * @return 待った時間(ミリ秒)
+ */
+static double
+user_spin(calcinfo *calc, const double *args)
+{
+    unsigned long long end = get_monotonic_time() +
+        (unsigned long long)(args[0] * 1000);
+
+    while (get_monotonic_time() < end)
+        ;
+    return args[0];
+}
+
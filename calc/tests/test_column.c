@@ -0,0 +1,135 @@
+/**
+ * @file  calc/tests/test_column.c
+ * @brief 単体テスト
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2011-2018 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <string.h> /* memset strlen */
+#include <math.h>   /* fabs */
+#include <float.h>  /* DBL_EPSILON */
+#include <cutter.h> /* cutter library */
+
+#include "def.h"
+#include "calc.h"
+#include "test_common.h"
+
+#define COLUMN_COUNT  300 /**< 組の数(端数のブロックを含む) */
+#define ULP_TOLERANCE (8 * DBL_EPSILON) /**< 許容する相対誤差 */
+
+/* プロトタイプ */
+/** calc_eval_columns() 関数テスト */
+void test_calc_eval_columns(void);
+
+/* 内部変数 */
+/** 変数名 */
+static const char *vars[] = { "x", "y" };
+
+/** 式 */
+static const char *exprs[] = {
+    "x+y*2-x/3",                /* 四則演算のみ */
+    "sin(x)*cos(y)+exp(x/100)", /* 数学関数 */
+    "sqrt(x)+ln(y+1)",          /* 定義域エラー */
+    "x/y",                      /* ゼロ除算 */
+    "x^y",                      /* べき乗 */
+    "nCr(10,3)*x-y",            /* 畳み込み後の定数 */
+    "exp(x*y)"                  /* 範囲エラー */
+};
+
+/**
+ * calc_eval_columns() 関数テスト
+ *
+ * calc_eval_many() と同じエラーコードになることを確認する.\n
+ * ベクトル版の関数は libm と数 ULP 異なるため, 値は相対誤差で比較する.
+ *
+ * @return なし
+ */
+void
+test_calc_eval_columns(void)
+{
+    calcinfo calc;                     /* calc情報構造体 */
+    calccode *code = NULL;             /* コード */
+    double x[COLUMN_COUNT];            /* 変数xの列 */
+    double y[COLUMN_COUNT];            /* 変数yの列 */
+    double rows[COLUMN_COUNT * 2];     /* 行ごとの変数の値 */
+    const double *cols[] = { x, y };   /* 列 */
+    double expected[COLUMN_COUNT];     /* 期待値 */
+    double actual[COLUMN_COUNT];       /* 実行結果 */
+    ER experr[COLUMN_COUNT];           /* 期待するエラーコード */
+    ER acterr[COLUMN_COUNT];           /* エラーコード */
+    ssize_t retval = 0;                /* 戻り値 */
+
+    int i;
+    for (i = 0; i < COLUMN_COUNT; i++) {
+        x[i] = (double)(i % 37) - 5.0;
+        y[i] = (double)(i % 11) * 0.5 - 1.0;
+        /* 後半のブロックはエラーなし */
+        if (256 <= i) {
+            x[i] = (double)i / 10.0;
+            y[i] = 1.5;
+        }
+        rows[i * 2] = x[i];
+        rows[i * 2 + 1] = y[i];
+    }
+
+    unsigned int j;
+    for (j = 0; j < NELEMS(exprs); j++) {
+        (void)memset(&calc, 0, sizeof(calcinfo));
+        code = calc_compile_vars(&calc, exprs[j], strlen(exprs[j]), vars,
+                                 NELEMS(vars));
+        cut_assert_not_null(code, cut_message("%s", exprs[j]));
+
+        retval = calc_eval_many(&calc, code, rows, COLUMN_COUNT,
+                                expected, experr);
+        cut_assert_equal_int(COLUMN_COUNT, (int)retval);
+        retval = calc_eval_columns(&calc, code, cols, COLUMN_COUNT,
+                                   actual, acterr);
+        cut_assert_equal_int(COLUMN_COUNT, (int)retval);
+        cut_assert_equal_int((int)E_NONE, (int)calc.errorcode);
+
+        for (i = 0; i < COLUMN_COUNT; i++) {
+            cut_assert_equal_int((int)experr[i], (int)acterr[i],
+                                 cut_message("%s[%d]", exprs[j], i));
+            cut_assert_equal_double(expected[i],
+                                    fabs(expected[i]) * ULP_TOLERANCE,
+                                    actual[i],
+                                    cut_message("%s[%d]", exprs[j], i));
+        }
+        calc_destroy(&code);
+    }
+
+    /* 変数なし */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    code = calc_compile_vars(&calc, "2*3", 3, NULL, 0);
+    cut_assert_not_null(code);
+    retval = calc_eval_columns(&calc, code, NULL, 3, actual, NULL);
+    cut_assert_equal_int(3, (int)retval);
+    cut_assert_equal_double(6.0, 0.0, actual[2]);
+    calc_destroy(&code);
+
+    /* 列なし */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    code = calc_compile_vars(&calc, "x", 1, vars, 1);
+    cut_assert_not_null(code);
+    retval = calc_eval_columns(&calc, code, NULL, 3, actual, NULL);
+    cut_assert_equal_int(EX_NG, (int)retval);
+    calc_destroy(&code);
+}
@@ -25,6 +25,7 @@
 
 
 #include <stdio.h>  /* snprintf */
+#include <stdlib.h> /* malloc */
 #include <cutter.h> /* cutter library */
 
 #include "log.h"
@@ -32,6 +33,10 @@
 #include "calc.h"
 #include "test_common.h"
 
+/* 内部関数 */
+/** コード解放 */
+static void destroy_code(void *code);
+
 /**
  * 文字列設定
  *
@@ -45,6 +50,7 @@ set_string(calcinfo *calc, const char *str)
     size_t length = 0;          /* 文字列長 */
     unsigned char *expr = NULL; /* 式 */
     int retval = 0;             /* 戻り値 */
+    calccode *code = NULL;      /* コード */
 
     length = strlen(str);
     expr = (unsigned char *)cut_take_strndup(str, length);
@@ -53,6 +59,13 @@ set_string(calcinfo *calc, const char *str)
 
     calc->ptr = expr;
 
+    /* コード生成 */
+    code = (calccode *)malloc(sizeof(calccode));
+    if (!code)
+        cut_error("malloc=%p", code);
+    (void)memset(code, 0, sizeof(calccode));
+    calc->code = (calccode *)cut_take(code, destroy_code);
+
     /* フォーマット設定 */
     retval = snprintf(calc->fmt, sizeof(calc->fmt),
                       "%s%ld%s", "%.", 12L, "g");
@@ -64,3 +77,36 @@ set_string(calcinfo *calc, const char *str)
     dbglog("%p expr=%s, length=%u", expr, expr, length);
 }
 
+
+/**
+ * コード評価
+ *
+ * 生成中のコードを評価する.
+ *
+ * @param[in] calc calcinfo構造体
+ * @return 値
+ */
+double
+eval_code(calcinfo *calc)
+{
+    double result = 0.0; /* 結果 */
+
+    if (calc_eval(calc, calc->code, &result) < 0)
+        cut_error("calc_eval");
+
+    dbglog("result=%.15g", result);
+    return result;
+}
+
+/**
+ * コード解放
+ *
+ * @param[in] code コード
+ * @return なし
+ */
+static void
+destroy_code(void *code)
+{
+    calccode *ptr = (calccode *)code; /* コード */
+    calc_destroy(&ptr);
+}
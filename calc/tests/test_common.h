@@ -33,5 +33,8 @@
 /** 文字列設定 */
 void set_string(calcinfo *calc, const char *str);
 
+/** コード評価 */
+double eval_code(calcinfo *calc);
+
 #endif /* _TEST_COMMON_H_ */
 
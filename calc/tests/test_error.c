@@ -87,9 +87,25 @@ test_get_errormsg(void)
                                 cut_message("%s==%s",
                                             (char *)calc.answer,
                                             (char *)st_error.errormsg));
+        /* 複製せず静的領域を返す */
+        cut_assert_equal_pointer(st_error.errormsg[i], calc.answer);
+        cut_assert_null(calc.alloc);
         clear_error(&calc);
         destroy_answer(&calc);
+        cut_assert_null(calc.answer);
     }
+
+    /* エラー時の結果文字列は確保しない */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    cut_assert_not_null(create_answer(&calc, (unsigned char *)"1/0"));
+    cut_assert_null(calc.alloc);
+    destroy_answer(&calc);
+
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    calc.iflag = true;
+    cut_assert_not_null(create_answer(&calc, (unsigned char *)"1/0"));
+    cut_assert_null(calc.alloc);
+    destroy_answer(&calc);
 }
 
 /**
@@ -132,7 +148,8 @@ test_clear_error(void)
     set_string(&calc, "dammy");
     st_calc.readch(&calc);
 
-    calc.answer = (unsigned char *)strdup("dammy");
+    calc.alloc = (unsigned char *)strdup("dammy");
+    calc.answer = calc.alloc;
     clear_error(&calc);
 
     cut_assert_equal_int((int)E_NONE, (int)calc.errorcode);
@@ -23,7 +23,7 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
  */
 
-#include <ctype.h>  /* isalpha */
+#include <math.h>   /* hypot */
 #include <cutter.h> /* cutter library */
 
 #include "def.h"
@@ -36,6 +36,10 @@
 /* プロトタイプ */
 /** exec_func() 関数テスト */
 void test_exec_func(void);
+/** get_func() 関数テスト */
+void test_get_func(void);
+/** calc_register_func() 関数テスト */
+void test_calc_register_func(void);
 /** get_pi() 関数テスト */
 void test_get_pi(void);
 /** get_e() 関数テスト */
@@ -64,6 +68,14 @@ static testcalc st_calc; /**< calc関数構造体 */
 static testfunc st_func; /**< func関数構造体 */
 
 /* 内部関数 */
+/** 登録関数(2倍) */
+static double user_twice(calcinfo *calc, const double *args);
+/** 登録関数(斜辺) */
+static double user_hypot(calcinfo *calc, const double *args);
+/** 登録関数(定数) */
+static double user_answer(calcinfo *calc, const double *args);
+/** 登録関数(エラー) */
+static double user_error(calcinfo *calc, const double *args);
 
 /** テストデータ構造体 */
 struct test_data {
@@ -156,7 +168,12 @@ static const struct test_data factorial_data[] = {
     { "n(9)",    362880,    9,   0, E_NONE, 0.0 },
     { "n(-3)",       -6,   -3,   0, E_NONE, 0.0 },
     { "n(-9)",  -362880,   -9,   0, E_NONE, 0.0 },
-    { "n(0.5)",       0.0,  0.5, 0, E_NAN,  0.0 }
+    { "n(0.5)",       0.0,  0.5, 0, E_NAN,  0.0 },
+    { "n(22)", 1124000727777607680000.0, 22, 0, E_NONE, 0.0 },
+    { "n(170)", 7.25741561530799e+306, 170, 0, E_NONE, 1e+293 },
+    { "n(171)",       0.0,  171, 0, E_INFINITY, 0.0 },
+    { "n(-171)",      0.0, -171, 0, E_INFINITY, 0.0 },
+    { "n(10^300)",    0.0, 1e300, 0, E_INFINITY, 0.0 }
 };
 
 /** get_permutation() 関数テスト用データ */
@@ -164,7 +181,16 @@ static const struct test_data permutation_data[] = {
     { "nPr(5,2)",  20,    5,  2, E_NONE, 0.0 },
     { "nPr(-5,2)",  0.0, -5,  2, E_NAN,  0.0 },
     { "nPr(5,-2)",  0.0,  5, -2, E_NAN,  0.0 },
-    { "nPr(2,5)",   0.0,  2,  5, E_NAN,  0.0 }
+    { "nPr(2,5)",   0.0,  2,  5, E_NAN,  0.0 },
+    { "nPr(20,5)", 1860480, 20, 5, E_NONE, 0.0 },
+    { "nPr(5,0)",   1,    5,  0, E_NONE, 0.0 },
+    { "nPr(56,3)", 166320, 56, 3, E_NONE, 0.0 },
+    { "nPr(57,3)", 175560, 57, 3, E_NONE, 0.0 },
+    { "nPr(30,30)", 265252859812191058636308480000000.0, 30, 30, E_NONE,
+      0.0 },
+    { "nPr(5.5,2)", 0.0, 5.5, 2, E_NAN,  0.0 },
+    { "nPr(10^15,2)", 9.99999999999999e+29, 1e15, 2, E_NONE, 1e+16 },
+    { "nPr(10^6,10^6)", 0.0, 1e6, 1e6, E_INFINITY, 0.0 }
 };
 
 /** get_combination() 関数テスト用データ */
@@ -172,7 +198,20 @@ static const struct test_data combination_data[] = {
     { "nCr(5,2)",  10,    5,  2, E_NONE, 0.0 },
     { "nCr(-5,2)",  0.0, -5,  2, E_NAN,  0.0 },
     { "nCr(5,-2)",  0.0,  5, -2, E_NAN,  0.0 },
-    { "nCr(2,5)",   0.0,  2,  5, E_NAN,  0.0 }
+    { "nCr(2,5)",   0.0,  2,  5, E_NAN,  0.0 },
+    { "nCr(52,5)", 2598960, 52, 5, E_NONE, 0.0 },
+    { "nCr(50,25)", 126410606437752.0, 50, 25, E_NONE, 0.0 },
+    { "nCr(5,5)",   1,    5,  5, E_NONE, 0.0 },
+    { "nCr(56,28)", 7648690600760440.0, 56, 28, E_NONE, 0.0 },
+    { "nCr(57,28)", 15033633249770520.0, 57, 28, E_NONE, 4.0 },
+    { "nCr(57,24)", 7522327487513475.0, 57, 24, E_NONE, 0.0 },
+    { "nCr(60,19)", 2044802197953900.0, 60, 19, E_NONE, 0.0 },
+    { "nCr(56,0)",  1,   56,  0, E_NONE, 0.0 },
+    { "nCr(5,2.5)", 0.0,  5, 2.5, E_NAN, 0.0 },
+    { "nCr(1000,500)", 2.70288240945437e+299, 1000, 500, E_NONE, 1e+287 },
+    { "nCr(10^15,3)", 1.66666666666666e+44, 1e15, 3, E_NONE, 1e+31 },
+    { "nCr(2000,1000)", 0.0, 2000, 1000, E_INFINITY, 0.0 },
+    { "nCr(10^15,10^14)", 0.0, 1e15, 1e14, E_INFINITY, 0.0 }
 };
 
 /**
@@ -196,28 +235,22 @@ void cut_startup(void)
 void
 test_exec_func(void)
 {
-    double result = 0.0;            /* 結果 */
-    calcinfo calc;                  /* calcinfo構造体 */
-    char func[MAX_FUNC_STRING + 1]; /* 関数文字列 */
-    int pos = 0;                    /* 配列位置 */
+    double result = 0.0;   /* 結果 */
+    calcinfo calc;         /* calcinfo構造体 */
+    calccode *code = NULL; /* コード */
 
     unsigned int i;
     for (i = 0; i < NELEMS(func_data); i++) {
         (void)memset(&calc, 0, sizeof(calcinfo));
-        set_string(&calc, func_data[i].expr);
-        st_calc.readch(&calc);
 
-        pos = 0;
-        (void)memset(func, 0, sizeof(func));
-        while (isalpha(calc.ch) && calc.ch != '\0' &&
-               pos <= MAX_FUNC_STRING) {
-            func[pos++] = calc.ch;
-            st_calc.readch(&calc);
+        result = 0.0;
+        code = calc_compile(&calc, (unsigned char *)func_data[i].expr);
+        if (code) {
+            if (calc_eval(&calc, code, &result) < 0)
+                cut_error("calc_eval");
+            calc_destroy(&code);
         }
-        dbglog("func=%s", func);
-
-        result = exec_func(&calc, func);
-        dbglog(calc.fmt, result);
+        dbglog("result=%.15g", result);
         cut_assert_equal_double(func_data[i].answer,
                                 func_data[i].error,
                                 result,
@@ -232,6 +265,131 @@ test_exec_func(void)
     }
 }
 
+/**
+ * get_func() 関数テスト
+ *
+ * @return なし
+ */
+void
+test_get_func(void)
+{
+    const struct funcinfo *fp = NULL; /* 関数情報 */
+    const char *names[] = {
+        "pi", "e", "abs", "sqrt", "sin", "cos", "tan", "asin", "acos",
+        "atan", "exp", "ln", "log", "rad", "deg", "n", "nPr", "nCr"
+    };
+    const char *miss[] = {
+        "nofu", "sqr", "sqrtx", "nXr", "asim", "p", "x", "sinh", "NCR"
+    };
+
+    fp = get_func("sqrt", 4);
+    cut_assert_not_null(fp);
+    cut_assert_equal_int(1, get_func_argc(fp));
+
+    fp = get_func("pi", 2);
+    cut_assert_not_null(fp);
+    cut_assert_equal_int(0, get_func_argc(fp));
+
+    fp = get_func("nCr", 3);
+    cut_assert_not_null(fp);
+    cut_assert_equal_int(2, get_func_argc(fp));
+
+    /* 全関数が別々に見つかる */
+    unsigned int i, j;
+    for (i = 0; i < NELEMS(names); i++) {
+        fp = get_func(names[i], strlen(names[i]));
+        cut_assert_not_null(fp, cut_message("%s", names[i]));
+        for (j = 0; j < i; j++)
+            cut_assert_operator(get_func(names[j], strlen(names[j])), !=, fp,
+                                cut_message("%s %s", names[i], names[j]));
+    }
+
+    for (i = 0; i < NELEMS(miss); i++)
+        cut_assert_null(get_func(miss[i], strlen(miss[i])),
+                        cut_message("%s", miss[i]));
+
+    /* 終端文字なし */
+    cut_assert_operator(get_func("sin", 3), ==, get_func("sinh", 3));
+}
+
+/**
+ * calc_register_func() 関数テスト
+ *
+ * @return なし
+ */
+void
+test_calc_register_func(void)
+{
+    calcinfo calc;                    /* calc情報構造体 */
+    char name[MAX_FUNC_NAME + 2];     /* 関数名 */
+    const unsigned int nfunc = 100;   /* 拡張確認用の登録数 */
+    const struct funcinfo *fp = NULL; /* 関数情報 */
+    unsigned int i;                   /* 汎用変数 */
+
+    cut_assert_equal_int(EX_OK,
+                         calc_register_func("twice", 1, user_twice));
+    cut_assert_equal_int(EX_OK,
+                         calc_register_func("hyp", 2, user_hypot));
+    cut_assert_equal_int(EX_OK,
+                         calc_register_func("answer", 0, user_answer));
+    cut_assert_equal_int(EX_OK,
+                         calc_register_func("fail", 1, user_error));
+
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    cut_assert_equal_string("11", (char *)create_answer(
+                                &calc, (unsigned char *)"twice(3)+hyp(3,4)"));
+    destroy_answer(&calc);
+
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    cut_assert_equal_string("84", (char *)create_answer(
+                                &calc, (unsigned char *)"answer*2"));
+    destroy_answer(&calc);
+
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    cut_assert_equal_string("NaN.", (char *)create_answer(
+                                &calc, (unsigned char *)"1+fail(2)"));
+    destroy_answer(&calc);
+
+    fp = get_func("hyp", 3);
+    cut_assert_not_null(fp);
+    cut_assert_equal_int(2, get_func_argc(fp));
+
+    /* 登録できない */
+    cut_assert_equal_int(EX_NG, calc_register_func("twice", 1, user_twice));
+    cut_assert_equal_int(EX_NG, calc_register_func("sin", 1, user_twice));
+    cut_assert_equal_int(EX_NG, calc_register_func("", 1, user_twice));
+    cut_assert_equal_int(EX_NG, calc_register_func("f1", 1, user_twice));
+    cut_assert_equal_int(EX_NG, calc_register_func("tri", 3, user_twice));
+    cut_assert_equal_int(EX_NG, calc_register_func("nul", 1, NULL));
+    (void)memset(name, 'x', sizeof(name));
+    name[MAX_FUNC_NAME + 1] = '\0';
+    cut_assert_equal_int(EX_NG, calc_register_func(name, 1, user_twice));
+    name[MAX_FUNC_NAME] = '\0';
+    cut_assert_equal_int(EX_OK, calc_register_func(name, 1, user_twice));
+
+    /* テーブル拡張後も全て見つかる */
+    (void)memset(name, 0, sizeof(name));
+    for (i = 0; i < nfunc; i++) {
+        name[0] = 'g';
+        name[1] = (char)('a' + i / 26);
+        name[2] = (char)('a' + i % 26);
+        cut_assert_equal_int(EX_OK,
+                             calc_register_func(name, 1, user_twice));
+    }
+    for (i = 0; i < nfunc; i++) {
+        name[1] = (char)('a' + i / 26);
+        name[2] = (char)('a' + i % 26);
+        cut_assert_not_null(get_func(name, 3), cut_message("%s", name));
+    }
+    cut_assert_not_null(get_func("twice", 5));
+    cut_assert_null(get_func("gzz", 3));
+
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    cut_assert_equal_string("Function not defined.", (char *)create_answer(
+                                &calc, (unsigned char *)"nofunc(1)"));
+    destroy_answer(&calc);
+}
+
 /**
  * get_pow() 関数テスト
  *
@@ -564,3 +722,55 @@ test_get_combination(void)
     }
 }
 
+/**
+ * 登録関数(2倍)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] args 引数
+ * @return 計算結果
+ */
+static double
+user_twice(calcinfo *calc, const double *args)
+{
+    return args[0] * 2;
+}
+
+/**
+ * 登録関数(斜辺)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] args 引数
+ * @return 計算結果
+ */
+static double
+user_hypot(calcinfo *calc, const double *args)
+{
+    return hypot(args[0], args[1]);
+}
+
+/**
+ * 登録関数(定数)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] args 引数
+ * @return 計算結果
+ */
+static double
+user_answer(calcinfo *calc, const double *args)
+{
+    return 42;
+}
+
+/**
+ * 登録関数(エラー)
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] args 引数
+ * @return 計算結果
+ */
+static double
+user_error(calcinfo *calc, const double *args)
+{
+    set_errorcode(calc, E_NAN);
+    return 0.0;
+}
@@ -0,0 +1,238 @@
+/**
+ * @file  calc/tests/test_interval.c
+ * @brief 単体テスト
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2011-2018 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <string.h> /* memset strlen */
+#include <math.h>   /* fma */
+#include <cutter.h> /* cutter library */
+
+#include "def.h"
+#include "calc.h"
+#include "error.h"
+#include "interval.h"
+#include "test_common.h"
+
+/* プロトタイプ */
+/** calc_answer_interval() 関数テスト */
+void test_calc_answer_interval(void);
+/** 区間演算関数テスト */
+void test_interval_func(void);
+/** calc_eval_batch() 関数テスト(区間演算) */
+void test_calc_eval_batch_interval(void);
+
+/** テスト用データ */
+struct itest {
+    const char *expr;   /**< 式 */
+    long digit;         /**< 有効桁数 */
+    const char *answer; /**< 結果 */
+};
+
+/** 区間演算の結果 */
+static const struct itest iresult[] = {
+    { "0.1+0.2", 12, "[0.299999999999, 0.300000000001]" },
+    { "0.1+0.2", 15, "[0.299999999999999, 0.300000000000001]" },
+    { "1/3", 12, "[0.333333333333, 0.333333333334]" },
+    { "sqrt(2)", 15, "[1.41421356237309, 1.4142135623731]" },
+    { "pi", 12, "[3.14159265358, 3.14159265359]" },
+    { "1+2", 12, "[3, 3]" },
+    { "2^10", 12, "[1024, 1024]" },
+    { "0.5*0.25", 12, "[0.125, 0.125]" },
+    { "sqrt(16)", 12, "[4, 4]" },
+    { "n(10)", 12, "[3628800, 3628800]" },
+    { "n(-5)", 12, "[-120, -120]" },
+    { "nCr(10,3)", 12, "[120, 120]" },
+    { "nPr(5,2)", 12, "[20, 20]" },
+    { "-3+1.5", 12, "[-1.5, -1.5]" },
+    { "0x1.8p3+1_000", 12, "[1012, 1012]" },
+    { "1e-300*1e-300", 12, "[0, 4.94065645842e-324]" }
+};
+
+/** 区間演算のエラー */
+static const struct itest ierror[] = {
+    { "1/0", 12, "Divide by zero." },
+    { "1/(1-0.1*10)", 12, "Divide by zero." },
+    { "sqrt(-1)", 12, "NaN." },
+    { "ln(0)", 12, "Infinity." },
+    { "asin(2)", 12, "NaN." },
+    { "0^-1", 12, "NaN." },
+    { "n(2.5)", 12, "NaN." },
+    { "nCr(5,2.5)", 12, "NaN." },
+    { "n(171)", 12, "Infinity." },
+    { "tan(pi/2)", 12, "Infinity." },
+    { "(1+2", 12, "Syntax error." },
+    { "foo(1)", 12, "Function not defined." }
+};
+
+/**
+ * calc_answer_interval() 関数テスト
+ *
+ * 正確に表せる計算は一点, それ以外は真値を含む区間になることを
+ * 確認する.\n
+ * 区間が 0 を含む除算はエラーになる.
+ *
+ * @return なし
+ */
+void
+test_calc_answer_interval(void)
+{
+    calcinfo calc;                      /* calc情報構造体 */
+    const unsigned char *result = NULL; /* 結果 */
+
+    unsigned int i;
+    for (i = 0; i < NELEMS(iresult); i++) {
+        (void)memset(&calc, 0, sizeof(calcinfo));
+        calc.digit = iresult[i].digit;
+        calc.iflag = true;
+        result = create_answer(&calc, (unsigned char *)iresult[i].expr);
+        cut_assert_equal_string(iresult[i].answer, (char *)result,
+                                cut_message("%s", iresult[i].expr));
+        destroy_answer(&calc);
+    }
+
+    for (i = 0; i < NELEMS(ierror); i++) {
+        (void)memset(&calc, 0, sizeof(calcinfo));
+        calc.digit = ierror[i].digit;
+        calc.iflag = true;
+        result = create_answer(&calc, (unsigned char *)ierror[i].expr);
+        cut_assert_equal_string(ierror[i].answer, (char *)result,
+                                cut_message("%s", ierror[i].expr));
+        cut_assert_equal_int((int)E_NONE, (int)calc.errorcode);
+        destroy_answer(&calc);
+    }
+
+    /* 倍精度 */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    calc.digit = 17;
+    result = create_answer(&calc, (unsigned char *)"0.1+0.2");
+    cut_assert_equal_string("0.30000000000000004", (char *)result);
+    destroy_answer(&calc);
+}
+
+/**
+ * 区間演算関数テスト
+ *
+ * 区間内の極値, 極と丸めの向きを確認する.
+ *
+ * @return なし
+ */
+void
+test_interval_func(void)
+{
+    calcinfo calc;  /* calc情報構造体 */
+    interval x, y;  /* 区間 */
+    double v = 0.0; /* 値 */
+
+    (void)memset(&calc, 0, sizeof(calcinfo));
+
+    /* sin は [1, 2] で pi/2 の最大値をとる */
+    x.lo = 1.0;
+    x.hi = 2.0;
+    interval_sin(&calc, &y, &x, NULL);
+    cut_assert_equal_double(1.0, 0.0, y.hi);
+    cut_assert_true(y.lo <= sin(2.0));
+
+    /* cos は [3, 4] で pi の最小値をとる */
+    x.lo = 3.0;
+    x.hi = 4.0;
+    interval_cos(&calc, &y, &x, NULL);
+    cut_assert_equal_double(-1.0, 0.0, y.lo);
+    cut_assert_true(cos(4.0) <= y.hi);
+
+    /* 極値を含まない */
+    x.lo = 0.1;
+    x.hi = 0.2;
+    interval_sin(&calc, &y, &x, NULL);
+    cut_assert_true(y.lo <= sin(0.1) && y.lo > 0.09);
+    cut_assert_true(sin(0.2) <= y.hi && y.hi < 0.2);
+    interval_cos(&calc, &y, &x, NULL);
+    cut_assert_true(y.lo <= cos(0.2) && cos(0.1) <= y.hi && y.hi < 1.0);
+
+    /* 2pi 以上の幅 */
+    x.lo = 0.0;
+    x.hi = 7.0;
+    interval_sin(&calc, &y, &x, NULL);
+    cut_assert_equal_double(-1.0, 0.0, y.lo);
+    cut_assert_equal_double(1.0, 0.0, y.hi);
+    cut_assert_equal_int((int)E_NONE, (int)calc.errorcode);
+
+    /* tan は [1, 2] で極 pi/2 を含む */
+    x.lo = 1.0;
+    x.hi = 2.0;
+    interval_tan(&calc, &y, &x, NULL);
+    cut_assert_equal_int((int)E_INFINITY, (int)calc.errorcode);
+    clear_error(&calc);
+
+    /* 平方根の丸めの向き */
+    unsigned int i;
+    for (i = 2; i < 1000; i++) {
+        v = (double)i / 7;
+        x.lo = x.hi = v;
+        interval_sqrt(&calc, &y, &x, NULL);
+        cut_assert_true(fma(y.lo, y.lo, -v) <= 0 &&
+                        0 <= fma(y.hi, y.hi, -v),
+                        cut_message("%.17g", v));
+        cut_assert_true(nextafter(y.lo, INFINITY) >= y.hi,
+                        cut_message("%.17g", v));
+    }
+
+    /* 定義域 */
+    x.lo = -0.5;
+    x.hi = 2.0;
+    interval_acos(&calc, &y, &x, NULL);
+    cut_assert_equal_int((int)E_NAN, (int)calc.errorcode);
+}
+
+/**
+ * calc_eval_batch() 関数テスト(区間演算)
+ *
+ * @return なし
+ */
+void
+test_calc_eval_batch_interval(void)
+{
+    calcinfo calc;                     /* calc情報構造体 */
+    const unsigned char *expr[] = {
+        (const unsigned char *)"1/3",
+        (const unsigned char *)"1/0",
+        (const unsigned char *)"sqrt(2)*sqrt(2)"
+    };
+    unsigned char out[MAX_IANSWER * NELEMS(expr)]; /* 出力 */
+    calcresult result[NELEMS(expr)];   /* 結果 */
+    ssize_t retval = 0;                /* 戻り値 */
+
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    calc.iflag = true;
+    retval = calc_eval_batch(&calc, expr, NULL, NELEMS(expr), out,
+                             sizeof(out), result);
+    cut_assert_equal_int(NELEMS(expr), (int)retval);
+    cut_assert_equal_string("[0.333333333333, 0.333333333334]",
+                            (char *)out + result[0].offset);
+    cut_assert_equal_int((int)E_DIVBYZERO, (int)result[1].errorcode);
+    cut_assert_equal_string("Divide by zero.",
+                            (char *)out + result[1].offset);
+    cut_assert_equal_string("[1.99999999999, 2.00000000001]",
+                            (char *)out + result[2].offset);
+    cut_assert_equal_int((int)strlen("[1.99999999999, 2.00000000001]"),
+                         (int)result[2].length);
+}
@@ -0,0 +1,181 @@
+/**
+ * @file  calc/tests/test_mpcalc.c
+ * @brief 単体テスト
+ *
+ * make MPFR=1 でビルドした場合のみテストする.
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2011-2018 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_MPFR
+
+#include <string.h> /* memset strlen */
+#include <cutter.h> /* cutter library */
+
+#include "def.h"
+#include "calc.h"
+#include "error.h"
+#include "mpcalc.h"
+#include "test_common.h"
+
+/* プロトタイプ */
+/** calc_answer_mp() 関数テスト */
+void test_calc_answer_mp(void);
+/** calc_eval_batch() 関数テスト(多倍長計算) */
+void test_calc_eval_batch_mp(void);
+
+/** テスト用データ */
+struct mptest {
+    const char *expr;   /**< 式 */
+    long digit;         /**< 有効桁数 */
+    const char *answer; /**< 結果 */
+};
+
+/** 多倍長計算の結果 */
+static const struct mptest mpresult[] = {
+    { "1/3", 30, "0.333333333333333333333333333333" },
+    { "pi", 40, "3.141592653589793238462643383279502884197" },
+    { "sqrt(2)", 25, "1.414213562373095048801689" },
+    { "0.1+0.2", 30, "0.3" },
+    { "n(25)", 30, "15511210043330985984000000" },
+    { "nCr(100,50)", 30, "100891344545564193334812497256" },
+    { "nPr(20,5)", 12, "1860480" },
+    { "exp(1000)", 12, "1.97007111402e+434" },
+    { "-3+1.5", 12, "-1.5" },
+    { "1 2+3", 12, "15" },
+    { "rad(180)", 20, "3.1415926535897932385" },
+    { "n(-5)", 12, "-120" },
+    { "sqrt(2)*sqrt(2)", 20, "2" },
+    { "n(3000)", 30, "4.14935960343785408555686709309e+9130" },
+    { "n(100000)", 30, "2.82422940796034787429342157802e+456573" },
+    { "nPr(100000,50000)", 30, "8.43728408995482843708427164019e+243336" },
+    { "nCr(100000,50000)", 30, "2.52060836892200338850090011673e+30100" },
+    { "nPr(10^30,2)", 30, "9.99999999999999999999999999999e+59" },
+    { "nCr(10^300,1)", 12, "1e+300" },
+    { "nPr(5,0)", 12, "1" },
+    { "1.5e-3*2", 30, "0.003" },
+    { "0x1.8p3+1_000", 12, "1012" },
+    { "1234567890.123456789012345678901", 31,
+      "1234567890.123456789012345678901" }
+};
+
+/** 多倍長計算のエラー */
+static const struct mptest mperror[] = {
+    { "1/0", 12, "Divide by zero." },
+    { "sqrt(-1)", 12, "NaN." },
+    { "ln(0)", 12, "Infinity." },
+    { "asin(2)", 12, "NaN." },
+    { "0^-1", 12, "NaN." },
+    { "n(2.5)", 12, "NaN." },
+    { "nCr(5,2.5)", 12, "NaN." },
+    { "n(10^15)", 12, "Infinity." },
+    { "(1+2", 12, "Syntax error." },
+    { "foo(1)", 12, "Function not defined." }
+};
+
+/**
+ * calc_answer_mp() 関数テスト
+ *
+ * 有効桁数に応じた精度で計算されることを確認する.\n
+ * 結果文字列バッファより長い結果は領域確保される.
+ *
+ * @return なし
+ */
+void
+test_calc_answer_mp(void)
+{
+    calcinfo calc;                      /* calc情報構造体 */
+    const unsigned char *result = NULL; /* 結果 */
+
+    unsigned int i;
+    for (i = 0; i < NELEMS(mpresult); i++) {
+        (void)memset(&calc, 0, sizeof(calcinfo));
+        calc.digit = mpresult[i].digit;
+        calc.mpflag = true;
+        result = create_answer(&calc, (unsigned char *)mpresult[i].expr);
+        cut_assert_equal_string(mpresult[i].answer, (char *)result,
+                                cut_message("%s", mpresult[i].expr));
+        destroy_answer(&calc);
+    }
+
+    for (i = 0; i < NELEMS(mperror); i++) {
+        (void)memset(&calc, 0, sizeof(calcinfo));
+        calc.digit = mperror[i].digit;
+        calc.mpflag = true;
+        result = create_answer(&calc, (unsigned char *)mperror[i].expr);
+        cut_assert_equal_string(mperror[i].answer, (char *)result,
+                                cut_message("%s", mperror[i].expr));
+        cut_assert_equal_int((int)E_NONE, (int)calc.errorcode);
+        destroy_answer(&calc);
+    }
+
+    /* 長い結果 */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    calc.digit = MAX_MPDIGIT;
+    calc.mpflag = true;
+    result = create_answer(&calc, (unsigned char *)"1/7");
+    cut_assert_not_null(result);
+    cut_assert_equal_int(MAX_MPDIGIT + 2, (int)strlen((char *)result));
+    cut_assert_equal_string("0.142857142857",
+                            cut_take_strndup((char *)result, 14));
+    destroy_answer(&calc);
+
+    /* 倍精度 */
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    calc.digit = 12;
+    result = create_answer(&calc, (unsigned char *)"n(25)");
+    cut_assert_equal_string("1.55112100433e+25", (char *)result);
+    destroy_answer(&calc);
+}
+
+/**
+ * calc_eval_batch() 関数テスト(多倍長計算)
+ *
+ * @return なし
+ */
+void
+test_calc_eval_batch_mp(void)
+{
+    calcinfo calc;                     /* calc情報構造体 */
+    const unsigned char *expr[] = {
+        (const unsigned char *)"1/3",
+        (const unsigned char *)"1/0",
+        (const unsigned char *)"2^100"
+    };
+    unsigned char out[MAX_MPANSWER(40) * NELEMS(expr)]; /* 出力 */
+    calcresult result[NELEMS(expr)];   /* 結果 */
+    ssize_t retval = 0;                /* 戻り値 */
+
+    (void)memset(&calc, 0, sizeof(calcinfo));
+    calc.digit = 40;
+    calc.mpflag = true;
+    retval = calc_eval_batch(&calc, expr, NULL, NELEMS(expr), out,
+                             sizeof(out), result);
+    cut_assert_equal_int(NELEMS(expr), (int)retval);
+    cut_assert_equal_string("0.3333333333333333333333333333333333333333",
+                            (char *)out + result[0].offset);
+    cut_assert_equal_int((int)E_DIVBYZERO, (int)result[1].errorcode);
+    cut_assert_equal_string("1267650600228229401496703205376",
+                            (char *)out + result[2].offset);
+    cut_assert_equal_int(31, (int)result[2].length);
+}
+
+#endif /* HAVE_MPFR */
@@ -0,0 +1,210 @@
+/**
+ * @file  calc/tests/test_number.c
+ * @brief 単体テスト
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2011-2018 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>  /* snprintf */
+#include <stdlib.h> /* strtod */
+#include <string.h> /* memset strlen */
+#include <cutter.h> /* cutter library */
+
+#include "def.h"
+#include "number.h"
+#include "test_common.h"
+
+#define RANDOM_COUNT 200000 /**< 無作為抽出の数 */
+
+/* プロトタイプ */
+/** number_scan() 関数テスト */
+void test_number_scan(void);
+/** number_to_double() 関数テスト */
+void test_number_to_double(void);
+/** number_to_double() 関数テスト(長い数値) */
+void test_number_to_double_long(void);
+
+/** テスト用データ */
+struct scantest {
+    const char *expr; /**< 式 */
+    const char *text; /**< 正規化した数値文字列(NULL はエラー) */
+    size_t used;      /**< 読み取った文字数 */
+};
+
+/** number_scan() 関数テスト用データ */
+static const struct scantest scan_data[] = {
+    { "123",       "123e0",   3 },
+    { "543.21",    "54321e-2", 6 },
+    { "0.00120",   "120e-5",  7 },
+    { "007",       "7e0",     3 },
+    { "0.0",       "0",       3 },
+    { "1.",        "1e0",     2 },
+    { "1.5e-3",    "15e-4",   6 },
+    { "1.5E+2",    "15e1",    6 },
+    { "2e10*3",    "2e10",    4 },
+    { "1_000_000", "1000000e0", 9 },
+    { "1 2+3",     "12e0",    3 },
+    { "0x1f",      "0x1fp0",  4 },
+    { "0x1.8p3",   "0x1.8p3", 7 },
+    { "0x.8",      "0x.8p0",  4 },
+    { "0xF_F",     "0xFFp0",  5 },
+    { "2e",        "2e0",     1 },
+    { "2e+",       "2e0",     1 },
+    { "2ex",       "2e0",     1 },
+    { "0x",        "0",       1 },
+    { "0xg",       "0",       1 },
+    { "1_",        NULL,      0 },
+    { "1__0",      NULL,      0 },
+    { "1e1_",      NULL,      0 },
+    { "0x1_",      NULL,      0 }
+};
+
+/** number_to_double() 関数テスト用データ */
+static const char *conv_data[] = {
+    "0", "1", "54321", "543.21", "0.1", "0.3", "1e23", "8.41e21",
+    "9007199254740993", "9007199254740992.5", "123456789012345678901",
+    "2.2250738585072011e-308", "4.9406564584124654e-324", "1e-400",
+    "1.7976931348623157e308", "1e400", "0x1p-1074", "0x1.fffffffffffffp1023",
+    "0x1.00000000000008p0", "0x1.000000000000081p0", "3.14159265358979323846"
+};
+
+/**
+ * number_scan() 関数テスト
+ *
+ * @return なし
+ */
+void
+test_number_scan(void)
+{
+    char text[MAX_NUMBER_TEXT];              /* 数値文字列 */
+    numberinfo num = { text, sizeof(text) }; /* 数値文字列構造体 */
+    size_t used = 0;                         /* 読み取った文字数 */
+
+    unsigned int i;
+    for (i = 0; i < NELEMS(scan_data); i++) {
+        used = number_scan(scan_data[i].expr, strlen(scan_data[i].expr),
+                           &num);
+        cut_assert_equal_uint(scan_data[i].used, used,
+                              cut_message("%s", scan_data[i].expr));
+        if (scan_data[i].text)
+            cut_assert_equal_string(scan_data[i].text, text,
+                                    cut_message("%s", scan_data[i].expr));
+    }
+
+    /* 長さ指定 */
+    used = number_scan("1234", 2, &num);
+    cut_assert_equal_uint(2, used);
+    cut_assert_equal_string("12e0", text);
+
+    /* 領域不足 */
+    num.size = MAX_NUMBER_EXP;
+    cut_assert_equal_uint(0, number_scan("1", 1, &num));
+}
+
+/**
+ * number_to_double() 関数テスト
+ *
+ * strtod() と同じ値になることを確認する.
+ *
+ * @return なし
+ */
+void
+test_number_to_double(void)
+{
+    char text[MAX_NUMBER_TEXT];              /* 数値文字列 */
+    numberinfo num = { text, sizeof(text) }; /* 数値文字列構造体 */
+    char expr[64];                           /* 式 */
+    double expect = 0.0, actual = 0.0;       /* 値 */
+    unsigned int seed = 1;                   /* 乱数の種 */
+
+    unsigned int i;
+    for (i = 0; i < NELEMS(conv_data); i++) {
+        (void)number_scan(conv_data[i], strlen(conv_data[i]), &num);
+        expect = strtod(conv_data[i], NULL);
+        actual = number_to_double(&num);
+        cut_assert_true(!memcmp(&expect, &actual, sizeof(double)),
+                        cut_message("%s=%a, %a", conv_data[i],
+                                    expect, actual));
+    }
+
+    /* 無作為抽出 */
+    for (i = 0; i < RANDOM_COUNT; i++) {
+        int ndigit = rand_r(&seed) % 25 + 1;
+        int point = rand_r(&seed) % (ndigit + 1);
+        int n = 0;
+        int j;
+        for (j = 0; j < ndigit; j++) {
+            if (j && j == point)
+                expr[n++] = '.';
+            expr[n++] = (char)('0' + rand_r(&seed) % 10);
+        }
+        if (rand_r(&seed) % 2)
+            n += snprintf(expr + n, sizeof(expr) - n, "e%d",
+                          rand_r(&seed) % 660 - 330);
+        expr[n] = '\0';
+
+        (void)number_scan(expr, (size_t)n, &num);
+        expect = strtod(expr, NULL);
+        actual = number_to_double(&num);
+        cut_assert_true(!memcmp(&expect, &actual, sizeof(double)),
+                        cut_message("%s=%a, %a", expr, expect, actual));
+    }
+}
+
+/**
+ * number_to_double() 関数テスト(長い数値)
+ *
+ * MAX_NUMBER_DIGIT 桁を超える桁も丸めに反映されることを確認する.
+ *
+ * @return なし
+ */
+void
+test_number_to_double_long(void)
+{
+    char text[MAX_NUMBER_TEXT];              /* 数値文字列 */
+    numberinfo num = { text, sizeof(text) }; /* 数値文字列構造体 */
+    char expr[MAX_NUMBER_DIGIT * 2];         /* 式 */
+    size_t n = 0;                            /* 文字数 */
+
+    /* 2^53 + 1 は偶数丸めで 2^53 になる */
+    n = (size_t)snprintf(expr, sizeof(expr), "9007199254740993.");
+    (void)memset(expr + n, '0', MAX_NUMBER_DIGIT);
+    n += MAX_NUMBER_DIGIT;
+    expr[n] = '\0';
+    cut_assert_equal_uint(n, number_scan(expr, n, &num));
+    cut_assert_equal_double(9007199254740992.0, 0.0,
+                            number_to_double(&num));
+
+    /* 切り捨てた桁に 0 以外があれば切り上げる */
+    expr[n++] = '1';
+    expr[n] = '\0';
+    cut_assert_equal_uint(n, number_scan(expr, n, &num));
+    cut_assert_equal_double(9007199254740994.0, 0.0,
+                            number_to_double(&num));
+
+    /* 切り捨てた整数部の桁は指数に繰り入れる */
+    (void)memset(expr, '1', MAX_NUMBER_DIGIT + 10);
+    n = MAX_NUMBER_DIGIT + 10;
+    n += (size_t)snprintf(expr + n, sizeof(expr) - n, "e-700");
+    cut_assert_equal_uint(n, number_scan(expr, n, &num));
+    cut_assert_equal_double(strtod(expr, NULL), 0.0,
+                            number_to_double(&num));
+}
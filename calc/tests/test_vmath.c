@@ -0,0 +1,175 @@
+/**
+ * @file  calc/tests/test_vmath.c
+ * @brief 単体テスト
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2011-2018 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <math.h>   /* sin cos tan exp log log10 sqrt */
+#include <cutter.h> /* cutter library */
+
+#include "def.h"
+#include "calc.h"
+#include "vmath.h"
+#include "test_common.h"
+
+#define VMATH_COUNT  1001 /**< 値の数(端数を含む) */
+
+/* プロトタイプ */
+/** vmath_*() 関数精度テスト */
+void test_vmath_ulp(void);
+/** vmath_*() 関数エラーテスト */
+void test_vmath_error(void);
+
+/* 内部関数 */
+/** ULP 単位の差 */
+static double get_ulp(const double expected, const double actual);
+
+/** テスト対象 */
+struct vmathtest {
+    const char *name;                            /**< 関数名 */
+    size_t (*vfunc)(const double *, double *, ER *, const size_t);
+    double (*func)(double);                      /**< libm の関数 */
+    double min;                                  /**< 最小値 */
+    double max;                                  /**< 最大値 */
+    double ulp;                                  /**< libm との許容差 */
+};
+
+/** テスト対象 */
+static const struct vmathtest vtests[] = {
+    { "abs",  vmath_abs,  fabs,  -1e300, 1e300, 0.0 },
+    { "sqrt", vmath_sqrt, sqrt,  0.0,    1e300, 0.0 },
+    { "sin",  vmath_sin,  sin,   -1e6,   1e6,   1.0 },
+    { "cos",  vmath_cos,  cos,   -1e6,   1e6,   1.0 },
+    { "tan",  vmath_tan,  tan,   -1e6,   1e6,   3.0 },
+    { "exp",  vmath_exp,  exp,   -700.0, 700.0, 1.0 },
+    { "ln",   vmath_ln,   log,   1e-300, 1e300, 1.0 },
+    { "log",  vmath_log,  log10, 1e-300, 1e300, 2.0 }
+};
+
+/**
+ * vmath_*() 関数精度テスト
+ *
+ * 範囲内の値で libm との差が許容範囲内であることを確認する.
+ *
+ * @return なし
+ */
+void
+test_vmath_ulp(void)
+{
+    double x[VMATH_COUNT]; /* 値 */
+    double y[VMATH_COUNT]; /* 結果 */
+    ER err[VMATH_COUNT];   /* エラーコード */
+    double t = 0.0;        /* 0-1 の値 */
+    size_t retval = 0;     /* 戻り値 */
+
+    unsigned int i;
+    for (i = 0; i < NELEMS(vtests); i++) {
+        const struct vmathtest *vt = &vtests[i];
+        int j;
+        for (j = 0; j < VMATH_COUNT; j++) {
+            t = (double)j / (VMATH_COUNT - 1);
+            if (0 < vt->min) /* 対数の間隔 */
+                x[j] = exp(log(vt->min) + t * (log(vt->max) - log(vt->min)));
+            else
+                x[j] = vt->min + t * (vt->max - vt->min);
+        }
+        retval = vt->vfunc(x, y, err, VMATH_COUNT);
+        cut_assert_equal_uint(0, (unsigned int)retval,
+                              cut_message("%s", vt->name));
+        for (j = 0; j < VMATH_COUNT; j++) {
+            cut_assert_equal_int((int)E_NONE, (int)err[j],
+                                 cut_message("%s(%.17g)", vt->name, x[j]));
+            cut_assert_operator(get_ulp(vt->func(x[j]), y[j]), <=, vt->ulp,
+                                cut_message("%s(%.17g)=%.17g",
+                                            vt->name, x[j], y[j]));
+        }
+    }
+}
+
+/**
+ * vmath_*() 関数エラーテスト
+ *
+ * エラーになる値だけに組み込み関数と同じエラーコードが設定されることを
+ * 確認する.
+ *
+ * @return なし
+ */
+void
+test_vmath_error(void)
+{
+    double x[5];  /* 値 */
+    double y[5];  /* 結果 */
+    ER err[5];    /* エラーコード */
+    size_t retval = 0; /* 戻り値 */
+
+    /* 定義域エラー, 極エラー */
+    x[0] = -1.0; x[1] = 0.0; x[2] = 1.0; x[3] = INFINITY; x[4] = NAN;
+    retval = vmath_ln(x, y, err, 5);
+    cut_assert_equal_uint(4, (unsigned int)retval);
+    cut_assert_equal_int((int)E_NAN, (int)err[0]);
+    cut_assert_equal_int((int)E_INFINITY, (int)err[1]);
+    cut_assert_equal_int((int)E_NONE, (int)err[2]);
+    cut_assert_equal_double(0.0, 0.0, y[2]);
+    cut_assert_equal_int((int)E_INFINITY, (int)err[3]);
+    cut_assert_equal_int((int)E_NAN, (int)err[4]);
+
+    retval = vmath_sqrt(x, y, err, 3);
+    cut_assert_equal_uint(1, (unsigned int)retval);
+    cut_assert_equal_int((int)E_NAN, (int)err[0]);
+    cut_assert_equal_double(1.0, 0.0, y[2]);
+
+    /* 範囲エラー(アンダーフローを含む) */
+    x[0] = 710.0; x[1] = -710.0; x[2] = -INFINITY; x[3] = 1.0; x[4] = NAN;
+    retval = vmath_exp(x, y, err, 5);
+    cut_assert_equal_uint(3, (unsigned int)retval);
+    cut_assert_equal_int((int)E_INFINITY, (int)err[0]);
+    cut_assert_equal_int((int)E_INFINITY, (int)err[1]);
+    cut_assert_equal_int((int)E_NONE, (int)err[2]);
+    cut_assert_equal_double(0.0, 0.0, y[2]);
+    cut_assert_operator(get_ulp(exp(1.0), y[3]), <=, 1.0);
+    cut_assert_equal_int((int)E_NAN, (int)err[4]);
+
+    /* 無限大の三角関数 */
+    x[0] = INFINITY; x[1] = -0.0; x[2] = 1e300;
+    retval = vmath_sin(x, y, NULL, 3);
+    cut_assert_equal_uint(1, (unsigned int)retval);
+    cut_assert_true(signbit(y[1]));
+    cut_assert_operator(get_ulp(sin(1e300), y[2]), <=, 1.0);
+}
+
+/**
+ * ULP 単位の差
+ *
+ * @param[in] expected 期待値
+ * @param[in] actual 実行結果
+ * @return 差
+ */
+static double
+get_ulp(const double expected, const double actual)
+{
+    double ulp = 0.0; /* 期待値の ULP */
+
+    if (expected == actual)
+        return 0.0;
+    ulp = nextafter(fabs(expected), INFINITY) - fabs(expected);
+    return fabs(expected - actual) / ulp;
+}
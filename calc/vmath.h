@@ -0,0 +1,57 @@
+/**
+ * @file  calc/vmath.h
+ * @brief ベクトル数学関数
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2010-2011 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _VMATH_H_
+#define _VMATH_H_
+
+#include <stddef.h> /* size_t */
+
+#include "calc.h"
+
+/** 絶対値 */
+size_t vmath_abs(const double *x, double *y, ER *err, const size_t n);
+
+/** 平方根 */
+size_t vmath_sqrt(const double *x, double *y, ER *err, const size_t n);
+
+/** 三角関数(sin) */
+size_t vmath_sin(const double *x, double *y, ER *err, const size_t n);
+
+/** 三角関数(cosin) */
+size_t vmath_cos(const double *x, double *y, ER *err, const size_t n);
+
+/** 三角関数(tangent) */
+size_t vmath_tan(const double *x, double *y, ER *err, const size_t n);
+
+/** 指数関数 */
+size_t vmath_exp(const double *x, double *y, ER *err, const size_t n);
+
+/** 自然対数 */
+size_t vmath_ln(const double *x, double *y, ER *err, const size_t n);
+
+/** 常用対数 */
+size_t vmath_log(const double *x, double *y, ER *err, const size_t n);
+
+#endif /* _VMATH_H_ */
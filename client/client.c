@@ -60,6 +60,10 @@ enum {
 volatile sig_atomic_t g_sig_handled = 0; /**< シグナル */
 bool g_gflag = false;                    /**< gオプションフラグ */
 bool g_tflag = false;                    /**< tオプションフラグ */
+unsigned char g_digit = 0;               /**< 有効桁数(0はサーバの設定) */
+bool g_mflag = false;                    /**< mオプションフラグ */
+bool g_fflag = false;                    /**< Fオプションフラグ */
+bool g_iflag = false;                    /**< Iオプションフラグ */
 
 /* 内部変数 */
 static char hostname[HOST_SIZE];         /**< ホスト名 */
@@ -292,6 +296,9 @@ send_sock(int sock)
     slen = set_client_data(&sdata, expr, length);
     if (slen < 0) /* メモリ確保できない */
         return EX_ALLOC_ERR;
+    sdata->hd.digit = g_digit;
+    sdata->hd.flags = (g_mflag ? HD_MPFR : 0) | (g_fflag ? HD_FASTFE : 0) |
+        (g_iflag ? HD_INTERVAL : 0);
     dbglog("slen=%zd", slen);
 
     if (g_gflag)
@@ -39,6 +39,10 @@ extern volatile sig_atomic_t g_sig_handled; /**< シグナル */
 extern struct sigaction g_sigaction;        /**< sigaction構造体 */
 extern bool g_gflag;                        /**< gオプションフラグ */
 extern bool g_tflag;                        /**< tオプションフラグ */
+extern unsigned char g_digit;               /**< 有効桁数(0はサーバの設定) */
+extern bool g_mflag;                        /**< mオプションフラグ */
+extern bool g_fflag;                        /**< Fオプションフラグ */
+extern bool g_iflag;                        /**< Iオプションフラグ */
 
 /** ステータス */
 enum _st_client {
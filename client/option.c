@@ -5,7 +5,11 @@
  * オプション
  *  -i, --ipaddress  IPアドレス指定\n
  *  -p, --port       ポート番号指定\n
+ *  -d, --digit      有効桁数指定\n
  *  -t, --time       処理時間計測\n
+ *  -m, --mpfr       多倍長計算\n
+ *  -I, --interval   区間演算\n
+ *  -F, --fast-check 浮動小数点例外を式ごとに一度だけ確認\n
  *  -g, --debug      デバッグモード\n
  *  -h, --help       ヘルプ表示\n
  *  -V, --version    バージョン情報表示\n
@@ -33,6 +37,7 @@
 
 #include <stdio.h>  /* fprintf */
 #include <stdlib.h> /* EXIT_SUCCESS */
+#include <limits.h> /* UCHAR_MAX */
 #include <getopt.h> /* getopt_long */
 
 #include "log.h"
@@ -43,17 +48,21 @@
 /* 内部変数 */
 /** オプション情報構造体(ロング) */
 static struct option longopts[] = {
-    { "ipaddress", required_argument, NULL, 'i' },
-    { "port",      required_argument, NULL, 'p' },
-    { "time",      no_argument,       NULL, 't' },
-    { "debug",     no_argument,       NULL, 'g' },
-    { "help",      no_argument,       NULL, 'h' },
-    { "version",   no_argument,       NULL, 'V' },
-    { NULL,        0,                 NULL, 0   }
+    { "ipaddress",  required_argument, NULL, 'i' },
+    { "port",       required_argument, NULL, 'p' },
+    { "digit",      required_argument, NULL, 'd' },
+    { "time",       no_argument,       NULL, 't' },
+    { "mpfr",       no_argument,       NULL, 'm' },
+    { "interval",   no_argument,       NULL, 'I' },
+    { "fast-check", no_argument,       NULL, 'F' },
+    { "debug",      no_argument,       NULL, 'g' },
+    { "help",       no_argument,       NULL, 'h' },
+    { "version",    no_argument,       NULL, 'V' },
+    { NULL,         0,                 NULL, 0   }
 };
 
 /** オプション情報文字列(ショート) */
-static const char *shortopts = "p:i:thVg";
+static const char *shortopts = "p:i:d:tmIFhVg";
 
 /* 内部関数 */
 /** ヘルプの表示 */
@@ -74,7 +83,9 @@ static void parse_error(const int c, const char *msg);
 void
 parse_args(int argc, char *argv[])
 {
-    int opt = 0; /* オプション */
+    int opt = 0;         /* オプション */
+    long digit = 0;      /* 桁数 */
+    const int base = 10; /* 基数 */
 
     dbglog("start");
 
@@ -101,9 +112,26 @@ parse_args(int argc, char *argv[])
                 exit(EXIT_FAILURE);
             }
             break;
+        case 'd': /* 有効桁数設定 */
+            digit = strtol(optarg, NULL, base);
+            if (digit <= 0 || UCHAR_MAX < digit) {
+                (void)fprintf(stderr, "Digits is 1-%d.\n", UCHAR_MAX);
+                exit(EXIT_FAILURE);
+            }
+            g_digit = (unsigned char)digit;
+            break;
         case 't': /* 処理時間計測 */
             g_tflag = true;
             break;
+        case 'm': /* 多倍長計算 */
+            g_mflag = true;
+            break;
+        case 'I': /* 区間演算 */
+            g_iflag = true;
+            break;
+        case 'F': /* 浮動小数点例外を式ごとに一度だけ確認 */
+            g_fflag = true;
+            break;
         case 'g': /* デバッグモード */
             g_gflag = true;
             break;
@@ -122,6 +150,10 @@ parse_args(int argc, char *argv[])
             exit(EXIT_FAILURE);
         }
     }
+    if (g_mflag && g_iflag) {
+        (void)fprintf(stderr, "Cannot use -m with -I.\n");
+        exit(EXIT_FAILURE);
+    }
     if (optind < argc) {
         (void)printf("non-option ARGV-elements: ");
         while (optind < argc)
@@ -147,10 +179,18 @@ print_help(const char *progname)
     (void)fprintf(stderr, "  -p, --port             %s%s%s",
                   "set port number or service name (default: ",
                   DEFAULT_PORTNO, ")\n");
+    (void)fprintf(stderr, "  -d, --digit            %s",
+                  "set digit (default: server setting)\n");
     (void)fprintf(stderr, "  -g, --debug            %s",
                   "execute for debug mode\n");
     (void)fprintf(stderr, "  -t, --time             %s",
                   "print time\n");
+    (void)fprintf(stderr, "  -m, --mpfr             %s",
+                  "multiple precision (if the server supports it)\n");
+    (void)fprintf(stderr, "  -I, --interval         %s",
+                  "print an interval enclosing the exact result\n");
+    (void)fprintf(stderr, "  -F, --fast-check       %s",
+                  "check FP exceptions once per expression\n");
     (void)fprintf(stderr, "  -h, --help             %s",
                   "display this help and exit\n");
     (void)fprintf(stderr, "  -V, --version          %s",
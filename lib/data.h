@@ -33,9 +33,16 @@
 /** ヘッダ構造体 */
 struct header {
     uint32_t length;          /**< データ長 */
-    unsigned char padding[4]; /**< パディング */
+    unsigned char digit;      /**< 有効桁数(0は受信側の設定) */
+    unsigned char flags;      /**< 評価フラグ */
+    unsigned char padding[2]; /**< パディング */
 };
 
+/** 評価フラグ */
+#define HD_MPFR     0x01 /**< 多倍長計算 */
+#define HD_FASTFE   0x02 /**< 浮動小数点例外を式ごとに一度だけ確認 */
+#define HD_INTERVAL 0x04 /**< 区間演算 */
+
 /** クライアントデータ構造体 */
 struct client_data {
     struct header hd;            /**< ヘッダ構造体 */
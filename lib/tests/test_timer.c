@@ -43,6 +43,8 @@ void test_start_timer(void);
 void test_stop_timer(void);
 /** get_time() 関数テスト */
 void test_get_time(void);
+/** get_monotonic_time() 関数テスト */
+void test_get_monotonic_time(void);
 
 /**
  * print_timer() 関数テスト
@@ -129,3 +131,18 @@ test_get_time(void)
     cut_assert_not_equal_uint(0, (unsigned int)t);
 }
 
+/**
+ * get_monotonic_time() 関数テスト
+ *
+ * @return なし
+ */
+void
+test_get_monotonic_time(void)
+{
+    unsigned long long t1 = 0, t2 = 0; /* 戻り値 */
+
+    t1 = get_monotonic_time();
+    t2 = get_monotonic_time();
+    cut_assert_true(t1 <= t2);
+}
+
@@ -37,6 +37,7 @@
 
 #include <stdio.h>    /* fprintf stderr */
 #include <sys/time.h> /* timeval */
+#include <time.h>     /* clock_gettime CLOCK_MONOTONIC */
 
 #include "log.h"
 
@@ -53,6 +54,8 @@ inline void start_timer(unsigned int *start_time);
 inline unsigned int stop_timer(unsigned int *start_time);
 /** 時刻取得 */
 inline unsigned long long get_time(void);
+/** 単調増加時刻取得 */
+inline unsigned long long get_monotonic_time(void);
 
 /**
  * タイマースタート
@@ -97,5 +100,23 @@ get_time(void)
     return ((unsigned long long)tv.tv_sec) * 1000000 + tv.tv_usec;
 }
 
+/**
+ * 単調増加時刻取得
+ *
+ * 時刻の変更の影響を受けないため, 期限の計算に使う.
+ *
+ * @return 時刻(マイクロ秒)
+ */
+inline unsigned long long
+get_monotonic_time(void)
+{
+    struct timespec ts = { 0, 0 };
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0)
+        outlog("clock_gettime");
+
+    return ((unsigned long long)ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
 #endif /* _TIMER_H_ */
 
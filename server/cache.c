@@ -0,0 +1,540 @@
+/**
+ * @file  server/cache.c
+ * @brief 計算結果キャッシュ
+ *
+ * 受信した式のバイト列と評価オプションをキーとして,
+ * 結果文字列を保持する.\n
+ * ロック競合を避けるため, ハッシュ値でシャードに分割し,\n
+ * シャードごとにLRUで追い出す.
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2011-2018 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdlib.h>  /* malloc calloc */
+#include <string.h>  /* memcpy memcmp memset strlen */
+#include <stdbool.h> /* bool */
+#include <pthread.h> /* pthread_mutex_t */
+
+#include "def.h"
+#include "log.h"
+#include "memfree.h"
+#include "cache.h"
+
+#define MAX_SHARD    16 /**< シャード数(2のべき乗) */
+#define INIT_BUCKETS 64 /**< バケット数初期値(2のべき乗) */
+
+/** シャード構造体 */
+struct shard {
+    pthread_mutex_t mutex;   /**< ミューテックス */
+    cacheentry **bucket;     /**< バケット */
+    size_t nbucket;          /**< バケット数 */
+    cacheentry *newest;      /**< LRUリスト先頭(最新) */
+    cacheentry *oldest;      /**< LRUリスト末尾(最古) */
+    size_t entries;          /**< エントリ数 */
+    size_t size;             /**< 使用メモリ */
+    unsigned long hits;      /**< ヒット数 */
+    unsigned long misses;    /**< ミス数 */
+    unsigned long evictions; /**< 追い出し数 */
+};
+
+/* 内部変数 */
+static struct shard shards[MAX_SHARD]; /**< シャード */
+static size_t shardsize = 0;           /**< シャードごとのメモリ上限 */
+static bool enable = false;            /**< キャッシュ有効フラグ */
+
+/* 内部関数 */
+/** ハッシュ値取得 */
+static uint64_t get_hash(const unsigned char *key, const size_t keylen,
+                         const unsigned int opt);
+/** シャード取得 */
+static struct shard *get_shard(const uint64_t hash);
+/** エントリ検索 */
+static cacheentry *find_entry(struct shard *sh, const uint64_t hash,
+                              const unsigned char *key,
+                              const size_t keylen, const unsigned int opt);
+/** LRUリストから外す */
+static void unlink_lru(struct shard *sh, cacheentry *entry);
+/** LRUリスト先頭に追加 */
+static void push_lru(struct shard *sh, cacheentry *entry);
+/** ハッシュテーブルから外す */
+static void unlink_bucket(struct shard *sh, cacheentry *entry);
+/** バケット拡張 */
+static void grow_bucket(struct shard *sh);
+/** 追い出し */
+static void evict(struct shard *sh);
+/** エントリ解放 */
+static void free_entry(cacheentry *entry);
+
+/**
+ * キャッシュ初期化
+ *
+ * @param[in] maxsize メモリ上限(0の場合, キャッシュしない)
+ * @retval EX_NG エラー
+ */
+int
+cache_init(const size_t maxsize)
+{
+    struct shard *sh = NULL; /* シャード */
+    int retval = 0;          /* 戻り値 */
+
+    dbglog("start: maxsize=%zu", maxsize);
+
+    (void)memset(shards, 0, sizeof(shards));
+    shardsize = maxsize / MAX_SHARD;
+    enable = false;
+    if (!shardsize)
+        return EX_OK;
+
+    int i;
+    for (i = 0; i < MAX_SHARD; i++) {
+        sh = &shards[i];
+        retval = pthread_mutex_init(&sh->mutex, NULL);
+        if (retval) { /* エラー(非0) */
+            outlog("pthread_mutex_init=%d", retval);
+            goto error_handler;
+        }
+        sh->bucket = (cacheentry **)calloc(INIT_BUCKETS,
+                                           sizeof(cacheentry *));
+        if (!sh->bucket) {
+            outlog("calloc: nbucket=%d", INIT_BUCKETS);
+            (void)pthread_mutex_destroy(&sh->mutex);
+            goto error_handler;
+        }
+        sh->nbucket = INIT_BUCKETS;
+    }
+    enable = true;
+    return EX_OK;
+
+error_handler:
+    while (--i >= 0) {
+        memfree((void **)&shards[i].bucket, NULL);
+        (void)pthread_mutex_destroy(&shards[i].mutex);
+    }
+    return EX_NG;
+}
+
+/**
+ * キャッシュ破棄
+ *
+ * @return なし
+ * @attention 全スレッドが参照を解放した後に呼ぶこと.
+ * calcd は終了時に切り離したスレッドを待たないため呼ばない.
+ */
+void
+cache_destroy(void)
+{
+    struct shard *sh = NULL;    /* シャード */
+    cacheentry *entry = NULL;   /* エントリ */
+    cacheentry *older = NULL;   /* 次のエントリ */
+
+    dbglog("start");
+
+    if (!enable)
+        return;
+    enable = false;
+
+    int i;
+    for (i = 0; i < MAX_SHARD; i++) {
+        sh = &shards[i];
+        for (entry = sh->newest; entry; entry = older) {
+            older = entry->older;
+            free_entry(entry);
+        }
+        memfree((void **)&sh->bucket, NULL);
+        (void)pthread_mutex_destroy(&sh->mutex);
+    }
+    (void)memset(shards, 0, sizeof(shards));
+}
+
+/**
+ * キャッシュ検索
+ *
+ * @param[in] key キー(式)
+ * @param[in] keylen キー長
+ * @param[in] opt 評価オプション
+ * @return エントリ
+ * @retval NULL 見つからない
+ * @attention 戻り値のエントリは cache_release() で解放すること.
+ */
+cacheentry *
+cache_get(const unsigned char *key, const size_t keylen,
+          const unsigned int opt)
+{
+    uint64_t hash = 0;        /* ハッシュ値 */
+    struct shard *sh = NULL;  /* シャード */
+    cacheentry *entry = NULL; /* エントリ */
+
+    if (!enable)
+        return NULL;
+
+    hash = get_hash(key, keylen, opt);
+    sh = get_shard(hash);
+
+    (void)pthread_mutex_lock(&sh->mutex);
+    entry = find_entry(sh, hash, key, keylen, opt);
+    if (entry) { /* ヒット */
+        entry->refcount++;
+        unlink_lru(sh, entry);
+        push_lru(sh, entry);
+        sh->hits++;
+    } else {
+        sh->misses++;
+    }
+    (void)pthread_mutex_unlock(&sh->mutex);
+
+    dbglog("entry=%p, keylen=%zu", entry, keylen);
+    return entry;
+}
+
+/**
+ * キャッシュ登録
+ *
+ * 既に同じキーが登録されている場合, 登録済みのエントリを返す.
+ *
+ * @param[in] key キー(式)
+ * @param[in] keylen キー長
+ * @param[in] opt 評価オプション
+ * @param[in] answer 結果文字列
+ * @return エントリ
+ * @retval NULL 登録しなかった
+ * @attention 戻り値のエントリは cache_release() で解放すること.
+ */
+cacheentry *
+cache_put(const unsigned char *key, const size_t keylen,
+          const unsigned int opt, const unsigned char *answer)
+{
+    uint64_t hash = 0;         /* ハッシュ値 */
+    struct shard *sh = NULL;   /* シャード */
+    cacheentry *entry = NULL;  /* エントリ */
+    cacheentry *exist = NULL;  /* 登録済みエントリ */
+    size_t anslen = 0;         /* 結果文字列長 */
+    size_t size = 0;           /* 使用メモリ */
+    size_t index = 0;          /* バケット位置 */
+
+    dbglog("start: keylen=%zu", keylen);
+
+    if (!enable || !answer)
+        return NULL;
+
+    anslen = strlen((char *)answer) + 1;
+    size = sizeof(cacheentry) + keylen + anslen;
+    if (shardsize < size) /* 上限を超える */
+        return NULL;
+
+    entry = (cacheentry *)malloc(sizeof(cacheentry) + keylen + anslen);
+    if (!entry) {
+        outlog("malloc: keylen=%zu, anslen=%zu", keylen, anslen);
+        return NULL;
+    }
+    (void)memset(entry, 0, sizeof(cacheentry));
+    (void)memcpy(entry->key, key, keylen);
+    entry->key[keylen] = '\0';
+    entry->keylen = keylen;
+    entry->opt = opt;
+    entry->answer = entry->key + keylen + 1;
+    (void)memcpy(entry->answer, answer, anslen);
+    entry->size = size;
+    entry->hash = hash = get_hash(key, keylen, opt);
+    entry->refcount = 2; /* キャッシュと呼び出し元 */
+
+    sh = get_shard(hash);
+    (void)pthread_mutex_lock(&sh->mutex);
+
+    exist = find_entry(sh, hash, key, keylen, opt);
+    if (exist) { /* 他のスレッドが登録済み */
+        exist->refcount++;
+        (void)pthread_mutex_unlock(&sh->mutex);
+        free_entry(entry);
+        return exist;
+    }
+
+    if (sh->nbucket <= sh->entries)
+        grow_bucket(sh);
+    index = (size_t)(hash & (sh->nbucket - 1));
+    entry->next = sh->bucket[index];
+    sh->bucket[index] = entry;
+    push_lru(sh, entry);
+    sh->entries++;
+    sh->size += size;
+
+    evict(sh);
+
+    (void)pthread_mutex_unlock(&sh->mutex);
+    return entry;
+}
+
+/**
+ * キャッシュ参照解放
+ *
+ * @param[in] entry エントリ
+ * @return なし
+ */
+void
+cache_release(cacheentry *entry)
+{
+    struct shard *sh = NULL; /* シャード */
+    bool release = false;    /* 解放フラグ */
+
+    if (!entry)
+        return;
+
+    sh = get_shard(entry->hash);
+    (void)pthread_mutex_lock(&sh->mutex);
+    release = (--entry->refcount == 0);
+    (void)pthread_mutex_unlock(&sh->mutex);
+
+    if (release) /* 追い出し済み */
+        free_entry(entry);
+}
+
+/**
+ * キャッシュ統計取得
+ *
+ * @param[out] stat キャッシュ統計構造体
+ * @return なし
+ */
+void
+cache_stat(cachestat *stat)
+{
+    struct shard *sh = NULL; /* シャード */
+
+    (void)memset(stat, 0, sizeof(cachestat));
+    if (!enable)
+        return;
+
+    stat->maxsize = shardsize * MAX_SHARD;
+
+    int i;
+    for (i = 0; i < MAX_SHARD; i++) {
+        sh = &shards[i];
+        (void)pthread_mutex_lock(&sh->mutex);
+        stat->hits += sh->hits;
+        stat->misses += sh->misses;
+        stat->evictions += sh->evictions;
+        stat->entries += sh->entries;
+        stat->size += sh->size;
+        (void)pthread_mutex_unlock(&sh->mutex);
+    }
+}
+
+/**
+ * ハッシュ値取得
+ *
+ * FNV-1a(64bit). 評価オプションは最後に混ぜる.
+ *
+ * @param[in] key キー
+ * @param[in] keylen キー長
+ * @param[in] opt 評価オプション
+ * @return ハッシュ値
+ */
+static uint64_t
+get_hash(const unsigned char *key, const size_t keylen,
+         const unsigned int opt)
+{
+    uint64_t hash = 14695981039346656037ULL; /* ハッシュ値 */
+
+    size_t i;
+    for (i = 0; i < keylen; i++) {
+        hash ^= key[i];
+        hash *= 1099511628211ULL;
+    }
+    for (i = 0; i < sizeof(opt); i++) {
+        hash ^= (opt >> (i * 8)) & 0xff;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * シャード取得
+ *
+ * バケット位置と独立させるため, 上位ビットを使用する.
+ *
+ * @param[in] hash ハッシュ値
+ * @return シャード
+ */
+static struct shard *
+get_shard(const uint64_t hash)
+{
+    return &shards[(hash >> 60) & (MAX_SHARD - 1)];
+}
+
+/**
+ * エントリ検索
+ *
+ * @param[in] sh シャード
+ * @param[in] hash ハッシュ値
+ * @param[in] key キー
+ * @param[in] keylen キー長
+ * @param[in] opt 評価オプション
+ * @return エントリ
+ * @retval NULL 見つからない
+ * @attention シャードをロックしてから呼ぶこと.
+ */
+static cacheentry *
+find_entry(struct shard *sh, const uint64_t hash,
+           const unsigned char *key, const size_t keylen,
+           const unsigned int opt)
+{
+    cacheentry *entry = NULL; /* エントリ */
+
+    entry = sh->bucket[hash & (sh->nbucket - 1)];
+    for (; entry; entry = entry->next) {
+        if (entry->hash == hash && entry->keylen == keylen &&
+            entry->opt == opt && !memcmp(entry->key, key, keylen))
+            return entry;
+    }
+    return NULL;
+}
+
+/**
+ * LRUリストから外す
+ *
+ * @param[in] sh シャード
+ * @param[in] entry エントリ
+ * @return なし
+ */
+static void
+unlink_lru(struct shard *sh, cacheentry *entry)
+{
+    if (entry->prev)
+        entry->prev->older = entry->older;
+    else
+        sh->newest = entry->older;
+    if (entry->older)
+        entry->older->prev = entry->prev;
+    else
+        sh->oldest = entry->prev;
+    entry->prev = entry->older = NULL;
+}
+
+/**
+ * LRUリスト先頭に追加
+ *
+ * @param[in] sh シャード
+ * @param[in] entry エントリ
+ * @return なし
+ */
+static void
+push_lru(struct shard *sh, cacheentry *entry)
+{
+    entry->prev = NULL;
+    entry->older = sh->newest;
+    if (sh->newest)
+        sh->newest->prev = entry;
+    sh->newest = entry;
+    if (!sh->oldest)
+        sh->oldest = entry;
+}
+
+/**
+ * ハッシュテーブルから外す
+ *
+ * @param[in] sh シャード
+ * @param[in] entry エントリ
+ * @return なし
+ */
+static void
+unlink_bucket(struct shard *sh, cacheentry *entry)
+{
+    cacheentry **pp = NULL; /* 前のエントリのnextポインタ */
+
+    pp = &sh->bucket[entry->hash & (sh->nbucket - 1)];
+    while (*pp && *pp != entry)
+        pp = &(*pp)->next;
+    if (*pp)
+        *pp = entry->next;
+    entry->next = NULL;
+}
+
+/**
+ * バケット拡張
+ *
+ * 確保できない場合は, 現在のバケットのまま使用する.
+ *
+ * @param[in] sh シャード
+ * @return なし
+ */
+static void
+grow_bucket(struct shard *sh)
+{
+    cacheentry **bucket = NULL; /* 新しいバケット */
+    cacheentry *entry = NULL;   /* エントリ */
+    cacheentry *next = NULL;    /* 次のエントリ */
+    size_t nbucket = sh->nbucket * 2;
+
+    bucket = (cacheentry **)calloc(nbucket, sizeof(cacheentry *));
+    if (!bucket) {
+        outlog("calloc: nbucket=%zu", nbucket);
+        return;
+    }
+
+    size_t i;
+    for (i = 0; i < sh->nbucket; i++) {
+        for (entry = sh->bucket[i]; entry; entry = next) {
+            next = entry->next;
+            entry->next = bucket[entry->hash & (nbucket - 1)];
+            bucket[entry->hash & (nbucket - 1)] = entry;
+        }
+    }
+    memfree((void **)&sh->bucket, NULL);
+    sh->bucket = bucket;
+    sh->nbucket = nbucket;
+}
+
+/**
+ * 追い出し
+ *
+ * メモリ上限を下回るまで, 最古のエントリから追い出す.\n
+ * 参照中のエントリは, 最後の cache_release() で解放される.
+ *
+ * @param[in] sh シャード
+ * @return なし
+ * @attention シャードをロックしてから呼ぶこと.
+ */
+static void
+evict(struct shard *sh)
+{
+    cacheentry *entry = NULL; /* エントリ */
+
+    while (shardsize < sh->size && sh->oldest) {
+        entry = sh->oldest;
+        unlink_lru(sh, entry);
+        unlink_bucket(sh, entry);
+        sh->entries--;
+        sh->size -= entry->size;
+        sh->evictions++;
+        if (--entry->refcount == 0)
+            free_entry(entry);
+    }
+}
+
+/**
+ * エントリ解放
+ *
+ * @param[in] entry エントリ
+ * @return なし
+ */
+static void
+free_entry(cacheentry *entry)
+{
+    memfree((void **)&entry, NULL);
+}
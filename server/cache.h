@@ -0,0 +1,83 @@
+/**
+ * @file  server/cache.h
+ * @brief コンパイル済み式キャッシュ
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2011-2018 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
+
+#define DEFAULT_CACHE_SIZE (4UL * 1024 * 1024) /**< デフォルトメモリ上限 */
+#define CACHE_MPFR     0x10000U /**< 評価オプション: 多倍長計算 */
+#define CACHE_FASTFE   0x20000U /**< 評価オプション: 浮動小数点例外一括確認 */
+#define CACHE_INTERVAL 0x40000U /**< 評価オプション: 区間演算 */
+
+/** キャッシュエントリ構造体 */
+struct _cacheentry {
+    struct _cacheentry *next;  /**< ハッシュチェイン */
+    struct _cacheentry *prev;  /**< LRUリスト(新しい側) */
+    struct _cacheentry *older; /**< LRUリスト(古い側) */
+    uint64_t hash;             /**< ハッシュ値 */
+    size_t size;               /**< 使用メモリ */
+    unsigned int refcount;     /**< 参照カウント */
+    unsigned char *answer;     /**< 結果文字列 */
+    unsigned int opt;          /**< 評価オプション(有効桁数など) */
+    size_t keylen;             /**< キー長 */
+    unsigned char key[1];      /**< キー(式) */
+};
+typedef struct _cacheentry cacheentry;
+
+/** キャッシュ統計構造体 */
+struct _cachestat {
+    unsigned long hits;      /**< ヒット数 */
+    unsigned long misses;    /**< ミス数 */
+    unsigned long evictions; /**< 追い出し数 */
+    size_t entries;          /**< エントリ数 */
+    size_t size;             /**< 使用メモリ */
+    size_t maxsize;          /**< メモリ上限 */
+};
+typedef struct _cachestat cachestat;
+
+/** キャッシュ初期化 */
+int cache_init(const size_t maxsize);
+
+/** キャッシュ破棄 */
+void cache_destroy(void);
+
+/** キャッシュ検索 */
+cacheentry *cache_get(const unsigned char *key, const size_t keylen,
+                      const unsigned int opt);
+
+/** キャッシュ登録 */
+cacheentry *cache_put(const unsigned char *key, const size_t keylen,
+                      const unsigned int opt, const unsigned char *answer);
+
+/** キャッシュ参照解放 */
+void cache_release(cacheentry *entry);
+
+/** キャッシュ統計取得 */
+void cache_stat(cachestat *stat);
+
+#endif /* _CACHE_H_ */
@@ -83,12 +83,19 @@ int main(int argc, char *argv[], char *envp[])
     }
 #endif /* _DEBUG */
 
+    /* キャッシュ初期化 */
+    if (cache_init(g_cache_size) < 0)
+        exit(EXIT_FAILURE);
+
     /* ソケット送受信 */
     server_loop(sockfd);
 
     /* ソケットクローズ */
     close_sock(&sockfd);
 
+    /* キャッシュ統計出力(スレッドが参照中の可能性があるため破棄しない) */
+    print_cache_stat();
+
     if (hupflag) { /* 再起動 */
         dbglog("SIGHUP");
         (void)alarm(0);
@@ -171,10 +178,11 @@ set_sig_handler(void)
     if (sigaction(SIGPIPE, &sa, (struct sigaction *)NULL) < 0)
         outlog("sigaction=%p, SIGPIPE", &sa);
 
+    /* キャッシュ統計出力 */
     if (sigaction(SIGUSR1, (struct sigaction *)NULL, &sa) < 0)
         outlog("sigaction=%p, SIGUSR1", &sa);
-    sa.sa_handler = SIG_IGN;
-    sa.sa_flags |= SA_NODEFER;
+    sa.sa_handler = sig_handler;
+    sa.sa_mask = sigmask;
     if (sigaction(SIGUSR1, &sa, (struct sigaction *)NULL) < 0)
         outlog("sigaction=%p, SIGUSR1", &sa);
 
@@ -208,6 +216,11 @@ set_sig_handler(void)
  */
 static void sig_handler(int signo)
 {
+    if (signo == SIGUSR1) { /* キャッシュ統計出力 */
+        g_stat_handled = 1;
+        return;
+    }
+
     g_sig_handled = 1;
 
     if (signo == SIGHUP)
@@ -3,11 +3,16 @@
  * @brief オプション引数の処理
  *
  * オプション
- *  -p, --port    ポート番号指定\n
- *  -d, --digit   有効桁数設定\n
- *  -g, --debug   デバッグモード\n
- *  -h, --help    ヘルプ表示\n
- *  -V, --version バージョン情報表示\n
+ *  -p, --port       ポート番号指定\n
+ *  -d, --digit      有効桁数設定\n
+ *  -c, --cache      キャッシュメモリ上限設定\n
+ *  -l, --max-length 式の長さの上限設定\n
+ *  -n, --max-depth  入れ子の深さの上限設定\n
+ *  -k, --max-nodes  ノード数の上限設定\n
+ *  -t, --timeout    評価の制限時間設定\n
+ *  -g, --debug      デバッグモード\n
+ *  -h, --help       ヘルプ表示\n
+ *  -V, --version    バージョン情報表示\n
  *
  * @author higashi
  * @date 2010-06-25 higashi 新規作成
@@ -33,6 +38,10 @@
 #include <stdio.h>  /* fprintf */
 #include <stdlib.h> /* EXIT_SUCCESS */
 #include <getopt.h> /* getopt_long */
+#include <ctype.h>  /* isdigit */
+#include <errno.h>  /* errno */
+#include <limits.h> /* INT_MAX */
+#include <stdint.h> /* SIZE_MAX */
 
 #include "log.h"
 #include "version.h"
@@ -42,16 +51,21 @@
 /* 内部変数 */
 /** オプション情報構造体(ロング) */
 static struct option longopts[] = {
-    { "port",    required_argument, NULL, 'p' },
-    { "digit",   required_argument, NULL, 'd' },
-    { "debug",   no_argument,       NULL, 'g' },
-    { "help",    no_argument,       NULL, 'h' },
-    { "version", no_argument,       NULL, 'V' },
-    { NULL,      0,                 NULL, 0 }
+    { "port",       required_argument, NULL, 'p' },
+    { "digit",      required_argument, NULL, 'd' },
+    { "cache",      required_argument, NULL, 'c' },
+    { "max-length", required_argument, NULL, 'l' },
+    { "max-depth",  required_argument, NULL, 'n' },
+    { "max-nodes",  required_argument, NULL, 'k' },
+    { "timeout",    required_argument, NULL, 't' },
+    { "debug",      no_argument,       NULL, 'g' },
+    { "help",       no_argument,       NULL, 'h' },
+    { "version",    no_argument,       NULL, 'V' },
+    { NULL,         0,                 NULL, 0   }
 };
 
 /** オプション情報文字列(ショート) */
-static const char *shortopts = "p:d:hVg";
+static const char *shortopts = "p:d:c:l:n:k:t:hVg";
 
 /* 内部関数 */
 /** ヘルプ表示 */
@@ -60,6 +74,10 @@ static void print_help(const char *progname);
 static void print_version(const char *progname);
 /** getoptエラー表示 */
 static void parse_error(const int c, const char *msg);
+/** サイズ文字列解析 */
+static int parse_size(const char *str, size_t *size);
+/** 上限値解析 */
+static int parse_limit(const char *str, int *limit);
 
 /**
  * オプション引数
@@ -97,7 +115,37 @@ parse_args(int argc, char *argv[])
                 (void)fprintf(stderr, "Digits is 1-%ld.\n", MAX_DIGIT);
                 exit(EXIT_FAILURE);
             }
-            set_digit(digit);
+            g_digit = digit;
+            break;
+        case 'c': /* キャッシュメモリ上限設定 */
+            if (parse_size(optarg, &g_cache_size) < 0) {
+                (void)fprintf(stderr, "Invalid cache size: %s\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'l': /* 式の長さの上限設定 */
+            if (parse_size(optarg, &g_max_length) < 0) {
+                (void)fprintf(stderr, "Invalid length: %s\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'n': /* 入れ子の深さの上限設定 */
+            if (parse_limit(optarg, &g_max_depth) < 0) {
+                (void)fprintf(stderr, "Invalid depth: %s\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'k': /* ノード数の上限設定 */
+            if (parse_limit(optarg, &g_max_nodes) < 0) {
+                (void)fprintf(stderr, "Invalid nodes: %s\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 't': /* 評価の制限時間設定 */
+            if (parse_limit(optarg, &g_timeout) < 0) {
+                (void)fprintf(stderr, "Invalid timeout: %s\n", optarg);
+                exit(EXIT_FAILURE);
+            }
             break;
         case 'g': /* デバッグモード */
             g_gflag = true;
@@ -141,6 +189,21 @@ print_help(const char *progname)
                   DEFAULT_PORTNO, ")\n");
     (void)fprintf(stderr, "  -d, --digit            %s%ld%s",
                   "set digit (1-", MAX_DIGIT, ")\n");
+    (void)fprintf(stderr, "  -c, --cache=SIZE[K|M]  %s%luK%s",
+                  "set cache memory limit, 0 disables (default: ",
+                  DEFAULT_CACHE_SIZE / 1024, ")\n");
+    (void)fprintf(stderr, "  -l, --max-length=SIZE  %s%luK%s",
+                  "set expression length limit [K|M], 0 disables (default: ",
+                  DEFAULT_MAX_LENGTH / 1024, ")\n");
+    (void)fprintf(stderr, "  -n, --max-depth=N      %s%d%s",
+                  "set nesting depth limit, 0 disables (default: ",
+                  DEFAULT_MAX_DEPTH, ")\n");
+    (void)fprintf(stderr, "  -k, --max-nodes=N      %s%d%s",
+                  "set node count limit, 0 disables (default: ",
+                  DEFAULT_MAX_NODES, ")\n");
+    (void)fprintf(stderr, "  -t, --timeout=MSEC     %s%d%s",
+                  "set evaluation time limit, 0 disables (default: ",
+                  DEFAULT_TIMEOUT, ")\n");
     (void)fprintf(stderr, "  -g, --debug            %s",
                   "execute for debug mode\n");
     (void)fprintf(stderr, "  -h, --help             %s",
@@ -178,3 +241,78 @@ parse_error(const int c, const char *msg)
     (void)fprintf(stderr, "Try `getopt --help' for more information\n");
 }
 
+
+/**
+ * サイズ文字列解析
+ *
+ * 接尾辞 K, M を受け付ける.
+ * 0 は無制限を表すため, 接尾辞の乗算で溢れる値はエラーにする.
+ * @param[in] str 文字列
+ * @param[out] size サイズ
+ * @retval EX_NG エラー
+ */
+static int
+parse_size(const char *str, size_t *size)
+{
+    char *endptr = NULL;     /* strtoul終了位置 */
+    unsigned long val = 0;   /* 値 */
+    size_t mul = 1;          /* 接尾辞の倍率 */
+    const int base = 10;     /* 基数 */
+
+    if (!isdigit((unsigned char)*str))
+        return EX_NG;
+
+    errno = 0;
+    val = strtoul(str, &endptr, base);
+    if (errno)
+        return EX_NG;
+
+    switch (*endptr) {
+    case 'k':
+    case 'K':
+        mul = 1024;
+        endptr++;
+        break;
+    case 'm':
+    case 'M':
+        mul = 1024 * 1024;
+        endptr++;
+        break;
+    default:
+        break;
+    }
+    if (*endptr != '\0')
+        return EX_NG;
+    if (SIZE_MAX / mul < val) /* 桁あふれ */
+        return EX_NG;
+
+    *size = (size_t)val * mul;
+    return EX_OK;
+}
+
+/**
+ * 上限値解析
+ *
+ * 0 以上 INT_MAX 以下の整数を受け付ける. 0 は無制限とする.
+ * @param[in] str 文字列
+ * @param[out] limit 上限値
+ * @retval EX_NG エラー
+ */
+static int
+parse_limit(const char *str, int *limit)
+{
+    char *endptr = NULL; /* strtol終了位置 */
+    long val = 0;        /* 値 */
+    const int base = 10; /* 基数 */
+
+    if (!isdigit((unsigned char)*str))
+        return EX_NG;
+
+    errno = 0;
+    val = strtol(str, &endptr, base);
+    if (errno || *endptr != '\0' || INT_MAX < val)
+        return EX_NG;
+
+    *limit = (int)val;
+    return EX_OK;
+}
@@ -24,7 +24,7 @@
  */
 
 #include <stdio.h>      /* fprintf */
-#include <stdlib.h>     /* EXIT_SUCCESS */
+#include <stdlib.h>     /* EXIT_SUCCESS realloc */
 #include <string.h>     /* memcpy memset strcpy */
 #include <stdbool.h>    /* bool */
 #include <sys/socket.h> /* socket setsockopt bind listen */
@@ -37,11 +37,20 @@
 #include "log.h"
 #include "net.h"
 #include "memfree.h"
+#include "error.h"
+#include "cache.h"
 #include "server.h"
 
 /* 外部変数 */
 volatile sig_atomic_t g_sig_handled = 0; /**< シグナル */
+volatile sig_atomic_t g_stat_handled = 0; /**< 統計出力シグナル */
 bool g_gflag = false;                    /**< gオプションフラグ */
+size_t g_cache_size = DEFAULT_CACHE_SIZE; /**< キャッシュメモリ上限 */
+long g_digit = DEFAULT_DIGIT;             /**< 有効桁数デフォルト値 */
+size_t g_max_length = DEFAULT_MAX_LENGTH; /**< 式の長さの上限 */
+int g_max_depth = DEFAULT_MAX_DEPTH;      /**< 入れ子の深さの上限 */
+int g_max_nodes = DEFAULT_MAX_NODES;      /**< ノード数の上限 */
+int g_timeout = DEFAULT_TIMEOUT;          /**< 評価の制限時間(ミリ秒) */
 
 /* 内部変数 */
 static char portno[PORT_SIZE];           /**< ポート番号またはサービス名 */
@@ -55,6 +64,12 @@ typedef struct _thread_id {
 /* 内部関数 */
 /** サーバプロセス */
 static void *server_proc(void *arg);
+/** 計算結果取得 */
+static const unsigned char *server_answer(calcinfo *calc,
+                                          const unsigned char *expr,
+                                          const size_t length);
+/** エラー応答 */
+static void server_reject(const int sock, const ER error);
 /** スレッドクリーンアップハンドラ */
 static void thread_cleanup(void *arg);
 /** スレッドメモリ解放ハンドラ */
@@ -230,12 +245,31 @@ server_loop(int sock)
                 if (retval) /* エラー(非0) */
                     outlog("pthread_detach: tid=%lu", (unsigned long)tid);
             }
-        } else { /* タイムアウト */
-            continue;
+        }
+        if (g_stat_handled) { /* 統計出力 */
+            g_stat_handled = 0;
+            print_cache_stat();
         }
     } while (!g_sig_handled);
 }
 
+/**
+ * キャッシュ統計出力
+ *
+ * @return なし
+ */
+void
+print_cache_stat(void)
+{
+    cachestat stat; /* キャッシュ統計 */
+
+    cache_stat(&stat);
+    outlog("cache: hits=%lu, misses=%lu, evictions=%lu, " \
+           "entries=%zu, size=%zu, maxsize=%zu",
+           stat.hits, stat.misses, stat.evictions,
+           stat.entries, stat.size, stat.maxsize);
+}
+
 /**
  * サーバプロセス
  *
@@ -250,7 +284,9 @@ server_proc(void *arg)
     size_t length = 0;                /* 長さ */
     ssize_t slen = 0;                 /* 送信するバイト数 */
     struct header hd;                 /* ヘッダ構造体 */
-    unsigned char *expr = NULL;       /* 受信データ */
+    unsigned char *expr = NULL;       /* 受信バッファ(接続中は再利用) */
+    unsigned char *tmp = NULL;        /* 一時ポインタ */
+    size_t size = 0;                  /* 受信バッファサイズ */
     calcinfo calc;                    /* calc情報構造体 */
     struct server_data *sdata = NULL; /* 送信データ構造体 */
 
@@ -264,6 +300,7 @@ server_proc(void *arg)
     set_thread_sigmask(dt.sigmask);
 
     pthread_cleanup_push(thread_cleanup, &dt);
+    pthread_cleanup_push(thread_memfree, &expr);
     do {
         /* ヘッダ受信 */
         length = sizeof(struct header);
@@ -281,13 +318,25 @@ server_proc(void *arg)
 
         /* データ受信 */
         length = (size_t)ntohl((uint32_t)hd.length); /* データ長を保持 */
-        expr = (unsigned char *)recv_data_new(dt.sock, &length);
-        if (!expr) /* メモリ不足 */
+        if (!length) /* 不正なヘッダ */
             pthread_exit((void *)EXIT_FAILURE);
-
-        pthread_cleanup_push(thread_memfree, &expr);
-
-        if (!length) /* 受信エラー */
+        /* 制限超過(終端文字とパディングを含む)は受信せずに切断する */
+        if (g_max_length && ((g_max_length + 8) & ~(size_t)7) < length) {
+            outlog("limit: length=%zu, max=%zu", length, g_max_length);
+            server_reject(dt.sock, E_LIMIT);
+            pthread_exit((void *)EXIT_FAILURE);
+        }
+        if (size < length) { /* 受信バッファ拡張 */
+            tmp = (unsigned char *)realloc(expr, length);
+            if (!tmp) { /* メモリ不足 */
+                outlog("realloc: length=%zu", length);
+                pthread_exit((void *)EXIT_FAILURE);
+            }
+            expr = tmp;
+            size = length;
+        }
+        retval = recv_data(dt.sock, expr, &length);
+        if (retval < 0) /* 受信エラー */
             pthread_exit((void *)EXIT_FAILURE);
 
         dbglog("expr=%p, length=%zu", expr, length);
@@ -300,7 +349,16 @@ server_proc(void *arg)
 
         /* サーバ処理 */
         (void)memset(&calc, 0, sizeof(calcinfo));
-        if (!create_answer(&calc, expr))
+        calc.digit = hd.digit ? (long)hd.digit : g_digit; /* 要求ごとの桁数 */
+        calc.mpflag = (hd.flags & HD_MPFR) != 0;
+        calc.fflag = (hd.flags & HD_FASTFE) != 0;
+        calc.iflag = (hd.flags & HD_INTERVAL) != 0;
+        calc.maxlen = g_max_length;
+        calc.maxdepth = g_max_depth;
+        calc.maxnodes = g_max_nodes;
+        calc.timeout = g_timeout;
+        calc.digit = calc_get_digit(&calc);
+        if (!server_answer(&calc, expr, length))
             pthread_exit((void *)EXIT_FAILURE);
 
         pthread_cleanup_push(destroy_answer, &calc);
@@ -332,15 +390,96 @@ server_proc(void *arg)
 
         pthread_cleanup_pop(1);
         pthread_cleanup_pop(1);
-        pthread_cleanup_pop(1);
 
     } while (!g_sig_handled);
 
+    pthread_cleanup_pop(1);
     pthread_cleanup_pop(1);
     pthread_exit((void *)EXIT_SUCCESS);
     return (void *)EXIT_SUCCESS;
 }
 
+/**
+ * 計算結果取得
+ *
+ * キャッシュにあればキャッシュの結果文字列を使用する.\n
+ * なければ受信バッファを長さ指定で計算し, 結果文字列を登録する.\n
+ * 制限時間超過は負荷によって変わるため登録しない.
+ *
+ * @param[in] calc calcinfo構造体
+ * @param[in] expr 受信データ
+ * @param[in] length 受信データ長
+ * @return 結果文字列ポインタ
+ * @retval NULL エラー
+ * @attention destroy_answerを必ず呼ぶこと.
+ */
+static const unsigned char *
+server_answer(calcinfo *calc, const unsigned char *expr, const size_t length)
+{
+    size_t keylen = 0;        /* キー長 */
+    unsigned int opt = 0;     /* 評価オプション */
+    size_t anslen = 0;        /* 結果文字列長 */
+    cacheentry *entry = NULL; /* キャッシュエントリ */
+
+    keylen = strnlen((char *)expr, length);
+    dbglog("start: keylen=%zu", keylen);
+
+    opt = (unsigned int)calc->digit | (calc->mpflag ? CACHE_MPFR : 0) |
+        (calc->fflag ? CACHE_FASTFE : 0) |
+        (calc->iflag ? CACHE_INTERVAL : 0);
+    entry = cache_get(expr, keylen, opt);
+    if (entry) { /* ヒット */
+        anslen = strlen((char *)entry->answer) + 1;
+        if (anslen <= sizeof(calc->buf)) {
+            (void)memcpy(calc->buf, entry->answer, anslen);
+            calc->answer = calc->buf;
+        } else {
+            calc->alloc = (unsigned char *)strdup((char *)entry->answer);
+            if (!calc->alloc)
+                outlog("strdup");
+            calc->answer = calc->alloc;
+        }
+        cache_release(entry);
+        return calc->answer;
+    }
+
+    if (!create_answer_buf(calc, (const char *)expr, keylen))
+        return NULL;
+    if (calc->answer == (const unsigned char *)get_errorstr(E_TIMEOUT))
+        return calc->answer;
+
+    entry = cache_put(expr, keylen, opt, calc->answer);
+    cache_release(entry);
+
+    return calc->answer;
+}
+
+/**
+ * エラー応答
+ *
+ * データを受信せずにエラーメッセージを送信する.
+ * 送信エラーは無視する(呼び出し元で切断する).
+ *
+ * @param[in] sock ソケット
+ * @param[in] error エラー種別
+ * @return なし
+ */
+static void
+server_reject(const int sock, const ER error)
+{
+    struct server_data *sdata = NULL; /* 送信データ構造体 */
+    const char *msg = NULL;           /* エラーメッセージ */
+    ssize_t slen = 0;                 /* 送信するバイト数 */
+
+    msg = get_errorstr(error);
+    slen = set_server_data(&sdata, (const unsigned char *)msg,
+                           strlen(msg) + 1);
+    if (slen < 0) /* メモリ確保できない */
+        return;
+    (void)send_data(sock, sdata, (size_t *)&slen);
+    memfree((void **)&sdata, NULL);
+}
+
 /**
  * スレッドクリーンアップハンドラ
  *
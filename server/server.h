@@ -18,15 +18,27 @@
 
 #include "data.h"
 #include "calc.h"
+#include "cache.h"
 
 #define HOST_SIZE 48           /**< ホスト名サイズ */
 #define PORT_SIZE  6           /**< ポート名サイズ */
 #define DEFAULT_PORTNO "12345" /**< デフォルトポート番号 */
+#define DEFAULT_MAX_LENGTH (1024UL * 1024) /**< 式の長さの上限デフォルト値 */
+#define DEFAULT_MAX_DEPTH  1024            /**< 入れ子の深さの上限デフォルト値 */
+#define DEFAULT_MAX_NODES  65536           /**< ノード数の上限デフォルト値 */
+#define DEFAULT_TIMEOUT    1000            /**< 評価の制限時間デフォルト値(ミリ秒) */
 
 
 /* 外部変数 */
 extern volatile sig_atomic_t g_sig_handled; /**< シグナル */
+extern volatile sig_atomic_t g_stat_handled; /**< 統計出力シグナル */
 extern bool g_gflag;                        /**< gオプションフラグ */
+extern size_t g_cache_size;                 /**< キャッシュメモリ上限 */
+extern long g_digit;                        /**< 有効桁数デフォルト値 */
+extern size_t g_max_length;                 /**< 式の長さの上限(0は無制限) */
+extern int g_max_depth;                     /**< 入れ子の深さの上限(0は無制限) */
+extern int g_max_nodes;                     /**< ノード数の上限(0は無制限) */
+extern int g_timeout;                       /**< 評価の制限時間(0は無制限) */
 
 /** ソケット情報構造体 */
 struct _thread_data {
@@ -46,6 +58,9 @@ int server_sock();
 /** 接続受付 */
 void server_loop(int sock);
 
+/** キャッシュ統計出力 */
+void print_cache_stat(void);
+
 #ifdef UNITTEST
 struct _testserver {
     void *(*server_proc)(void *arg);
@@ -0,0 +1,176 @@
+/**
+ * @file  server/tests/test_cache.c
+ * @brief 単体テスト
+ *
+ * @author higashi
+ * @date 2026-10-17 higashi 新規作成
+ * @version \$Id$
+ *
+ * Copyright (C) 2011-2018 Tetsuya Higashi. All Rights Reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <string.h> /* memset strlen */
+#include <cutter.h> /* cutter library */
+
+#include "def.h"
+#include "log.h"
+#include "cache.h"
+
+/* プロトタイプ */
+/** cache_get() cache_put() 関数テスト */
+void test_cache_put(void);
+/** cache_put() 同一キー登録テスト */
+void test_cache_put_exist(void);
+/** 追い出しテスト */
+void test_cache_evict(void);
+/** キャッシュ無効テスト */
+void test_cache_disable(void);
+
+/**
+ * 終了処理
+ *
+ * @return なし
+ */
+void
+cut_teardown(void)
+{
+    cache_destroy();
+}
+
+/**
+ * cache_get() cache_put() 関数テスト
+ *
+ * @return なし
+ */
+void
+test_cache_put(void)
+{
+    const char *expr = "1+2*3"; /* 式 */
+    cacheentry *entry = NULL;   /* エントリ */
+    cachestat stat;             /* 統計 */
+
+    cut_assert_equal_int(EX_OK, cache_init(DEFAULT_CACHE_SIZE));
+
+    entry = cache_get((unsigned char *)expr, strlen(expr), 0);
+    cut_assert_null(entry);
+
+    entry = cache_put((unsigned char *)expr, strlen(expr), 0,
+                      (unsigned char *)"7");
+    cut_assert_not_null(entry);
+    cache_release(entry);
+
+    entry = cache_get((unsigned char *)expr, strlen(expr), 0);
+    cut_assert_not_null(entry);
+    cut_assert_equal_string("7", (char *)entry->answer);
+    cache_release(entry);
+
+    /* 評価オプションが異なればヒットしない */
+    entry = cache_get((unsigned char *)expr, strlen(expr), 15);
+    cut_assert_null(entry);
+
+    /* 前方一致はヒットしない */
+    entry = cache_get((unsigned char *)expr, strlen(expr) - 1, 0);
+    cut_assert_null(entry);
+
+    cache_stat(&stat);
+    cut_assert_equal_int(1, stat.hits);
+    cut_assert_equal_int(3, stat.misses);
+    cut_assert_equal_int(0, stat.evictions);
+    cut_assert_equal_int(1, stat.entries);
+}
+
+/**
+ * cache_put() 同一キー登録テスト
+ *
+ * @return なし
+ */
+void
+test_cache_put_exist(void)
+{
+    const char *expr = "sin(2)"; /* 式 */
+    cacheentry *first = NULL;    /* エントリ */
+    cacheentry *second = NULL;   /* エントリ */
+    cachestat stat;              /* 統計 */
+
+    cut_assert_equal_int(EX_OK, cache_init(DEFAULT_CACHE_SIZE));
+
+    first = cache_put((unsigned char *)expr, strlen(expr), 0,
+                      (unsigned char *)"0.909297426826");
+    second = cache_put((unsigned char *)expr, strlen(expr), 0,
+                       (unsigned char *)"0.909297426826");
+    cut_assert_not_null(first);
+    cut_assert_equal_memory(&first, sizeof(first), &second, sizeof(second));
+    cache_release(first);
+    cache_release(second);
+
+    cache_stat(&stat);
+    cut_assert_equal_int(1, stat.entries);
+}
+
+/**
+ * 追い出しテスト
+ *
+ * @return なし
+ */
+void
+test_cache_evict(void)
+{
+    char expr[32];            /* 式 */
+    cacheentry *entry = NULL; /* エントリ */
+    cachestat stat;           /* 統計 */
+    int i;                    /* 汎用変数 */
+
+    /* シャードあたり数エントリしか入らない上限 */
+    cut_assert_equal_int(EX_OK, cache_init(16 * 1024));
+
+    for (i = 0; i < 1000; i++) {
+        (void)snprintf(expr, sizeof(expr), "%d+%d", i, i);
+        entry = cache_put((unsigned char *)expr, strlen(expr), 0,
+                          (unsigned char *)"0");
+        cache_release(entry);
+    }
+
+    cache_stat(&stat);
+    cut_assert_operator(0, <, stat.evictions);
+    cut_assert_equal_int(1000, stat.evictions + stat.entries);
+    cut_assert_operator(stat.size, <=, stat.maxsize);
+
+    /* 最新のエントリは残る */
+    entry = cache_get((unsigned char *)expr, strlen(expr), 0);
+    cut_assert_not_null(entry);
+    cache_release(entry);
+}
+
+/**
+ * キャッシュ無効テスト
+ *
+ * @return なし
+ */
+void
+test_cache_disable(void)
+{
+    const char *expr = "1+1"; /* 式 */
+    cacheentry *entry = NULL; /* エントリ */
+
+    cut_assert_equal_int(EX_OK, cache_init(0));
+
+    entry = cache_put((unsigned char *)expr, strlen(expr), 0,
+                      (unsigned char *)"2");
+    cut_assert_null(entry);
+    entry = cache_get((unsigned char *)expr, strlen(expr), 0);
+    cut_assert_null(entry);
+}